@@ -0,0 +1,266 @@
+#include "animation.h"
+
+#include <cmath>
+#include <algorithm>
+
+#include "mainvulkan.h"
+
+// Curves are sampled at EASING_TABLE_SIZE + 1 points and linearly interpolated between them
+static const uint16_t EASING_TABLE_SIZE = 256;
+
+// Keeps a scale that overshoots past zero from collapsing the target (And dividing by zero on the next frame)
+static const float MIN_SCALE = 0.001f;
+
+struct EasingTables
+{
+    float values[static_cast<size_t>(EasingFunction::SIZE)][EASING_TABLE_SIZE + 1];
+};
+
+static float easingCurve(EasingFunction function, float t)
+{
+    switch(function)
+    {
+        case EasingFunction::LINEAR: return t;
+        case EasingFunction::EASE_IN_QUAD: return t * t;
+        case EasingFunction::EASE_OUT_QUAD: return t * (2.0f - t);
+        case EasingFunction::EASE_IN_OUT_QUAD: return (t < 0.5f) ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+        case EasingFunction::EASE_IN_CUBIC: return t * t * t;
+        case EasingFunction::EASE_OUT_CUBIC: {
+            const float inverse = t - 1.0f;
+            return inverse * inverse * inverse + 1.0f;
+        }
+        case EasingFunction::EASE_IN_OUT_CUBIC: {
+            if(t < 0.5f) {
+                return 4.0f * t * t * t;
+            }
+
+            const float inverse = 2.0f * t - 2.0f;
+            return 0.5f * inverse * inverse * inverse + 1.0f;
+        }
+        case EasingFunction::EASE_OUT_BACK: {
+            const float overshoot = 1.70158f;
+            const float inverse = t - 1.0f;
+            return 1.0f + (overshoot + 1.0f) * inverse * inverse * inverse + overshoot * inverse * inverse;
+        }
+        default:
+            assert(false && "Invalid easing function");
+            return t;
+    }
+}
+
+static EasingTables buildEasingTables()
+{
+    EasingTables tables;
+
+    for(uint8_t function = 0; function < static_cast<uint8_t>(EasingFunction::SIZE); function++)
+    {
+        for(uint16_t i = 0; i <= EASING_TABLE_SIZE; i++) {
+            tables.values[function][i] = easingCurve(static_cast<EasingFunction>(function), static_cast<float>(i) / EASING_TABLE_SIZE);
+        }
+    }
+
+    return tables;
+}
+
+static const EasingTables easingTables = buildEasingTables();
+
+float evaluateEasing(uint8_t function, float t)
+{
+    assert(function < static_cast<uint8_t>(EasingFunction::SIZE) && "Invalid easing function");
+
+    const float * table = easingTables.values[function];
+    const float position = std::min(std::max(t, 0.0f), 1.0f) * EASING_TABLE_SIZE;
+
+    // The last sample is only reached at t == 1
+    const uint16_t sample = std::min(static_cast<uint16_t>(position), static_cast<uint16_t>(EASING_TABLE_SIZE - 1));
+    const float fraction = position - sample;
+
+    return table[sample] + (table[sample + 1] - table[sample]) * fraction;
+}
+
+bool startAnimation(VulkanApplication& app, OperationIndex operationIndex, const AnimatedMoveOperation& animatedMove)
+{
+    AnimationTracks& tracks = app.animations;
+
+    if(tracks.contains(operationIndex)) {
+        return false;
+    }
+
+    const uint8_t numFunctions = static_cast<uint8_t>(EasingFunction::SIZE);
+    const uint8_t moveFunction = (animatedMove.moveAnimationFunctionIndex < numFunctions) ? animatedMove.moveAnimationFunctionIndex : 0;
+    const uint8_t scaleFunction = (animatedMove.scaleAnimationFunctionIndex < numFunctions) ? animatedMove.scaleAnimationFunctionIndex : 0;
+
+    assert(moveFunction == animatedMove.moveAnimationFunctionIndex && "Invalid move easing function");
+    assert(scaleFunction == animatedMove.scaleAnimationFunctionIndex && "Invalid scale easing function");
+
+    const RelativeDataLocation& verticesTarget = app.entitySystem.verticesComponent.at(app.entitySystem.resolve(animatedMove.targetEntity));
+    const uint8_t * vertex = app.entitySystem.verticesComponentBasePtr + verticesTarget.offsetBytes;
+
+    float centreX = 0.0f;
+    float centreY = 0.0f;
+
+    for(uint16_t i = 0; i < verticesTarget.spanElements; i++)
+    {
+        const glm::vec2& position = *reinterpret_cast<const glm::vec2 *>(vertex);
+        centreX += position.x;
+        centreY += position.y;
+        vertex += verticesTarget.strideBytes;
+    }
+
+    if(verticesTarget.spanElements > 0) {
+        centreX /= verticesTarget.spanElements;
+        centreY /= verticesTarget.spanElements;
+    }
+
+    const float scale = (animatedMove.scaleBy == 0) ? 1.0f : animatedMove.scaleBy / 1000.0f;
+
+    const uint32_t track = tracks.add(  operationIndex,
+                                        animatedMove.targetEntity,
+                                        std::max(static_cast<float>(animatedMove.durationMs), 1.0f),
+                                        fixed16::toFloat(animatedMove.differenceX),
+                                        fixed16::toFloat(animatedMove.differenceY),
+                                        centreX, centreY,
+                                        scale,
+                                        moveFunction, scaleFunction );
+
+    if(track == AnimationTracks::INVALID_TRACK) {
+        return false;
+    }
+
+    // The most recently started animation of the entity
+    app.entitySystem.animationComponent.set(app.entitySystem.resolve(animatedMove.targetEntity), operationIndex);
+
+    return true;
+}
+
+void stopAnimation(VulkanApplication& app, OperationIndex operationIndex)
+{
+    if(app.animations.contains(operationIndex))
+    {
+        EntitySystemHandle& entities = app.entitySystem;
+        const Entity16 target = app.animations.targets[app.animations.trackOf[operationIndex]];
+
+        // Another animation of the entity may have been started since
+        if(entities.isAlive(target))
+        {
+            const uint32_t entityIndex = entities.resolve(target);
+
+            if(entities.animationComponent.contains(entityIndex) && entities.animationComponent.at(entityIndex) == operationIndex) {
+                entities.animationComponent.remove(entityIndex);
+            }
+        }
+
+        app.animations.remove(operationIndex);
+        app.opAt(operationIndex).flags &= ~OPERATION_FLAGS_ACTIVE;
+    }
+}
+
+void advanceAnimations(VulkanApplication& app, std::chrono::milliseconds delta)
+{
+    TRACE_FUNCTION();
+
+    AnimationTracks& tracks = app.animations;
+    const uint32_t numTracks = tracks.size();
+
+    if(numTracks == 0) {
+        return;
+    }
+
+    const float deltaMs = static_cast<float>(delta.count());
+
+    EntitySystemHandle& entities = app.entitySystem;
+    uint8_t * verticesBase = entities.verticesComponentBasePtr;
+    uint64_t verticesUpdated = 0;
+
+    for(uint32_t i = 0; i < numTracks; i++)
+    {
+        const float elapsed = std::min(tracks.elapsedMs[i] + deltaMs, tracks.durationMs[i]);
+        tracks.elapsedMs[i] = elapsed;
+
+        const float t = elapsed / tracks.durationMs[i];
+
+        // Only the change since the last frame is written, as the vertices already hold everything applied before
+        const float moveProgress = evaluateEasing(tracks.moveFunctions[i], t);
+        const float offsetX = tracks.differenceX[i] * moveProgress;
+        const float offsetY = tracks.differenceY[i] * moveProgress;
+
+        const float moveX = offsetX - tracks.appliedX[i];
+        const float moveY = offsetY - tracks.appliedY[i];
+
+        const uint32_t entityIndex = entities.resolve(tracks.targets[i]);
+
+        // Vertices are relative to the entity's transform, so only the transform changes
+        if(entities.transformComponent.contains(entityIndex))
+        {
+            const uint32_t node = entities.transformComponent.at(entityIndex);
+
+            if(tracks.targetScale[i] == 1.0f) {
+                entities.transforms.translate(node, moveX, moveY);
+            } else {
+                const float scaleProgress = evaluateEasing(tracks.scaleFunctions[i], t);
+                const float scale = std::max(1.0f + (tracks.targetScale[i] - 1.0f) * scaleProgress, MIN_SCALE);
+                const float ratio = scale / tracks.appliedScale[i];
+
+                // Scaled about the centre of the vertices, before the transform. The centre doesn't move in that space
+                const Affine2D aboutCentre = transform::combine(transform::combine( transform::translation(-tracks.centerX[i], -tracks.centerY[i]),
+                                                                                    transform::scale(ratio, ratio) ),
+                                                                transform::translation(tracks.centerX[i], tracks.centerY[i]));
+
+                Affine2D local = transform::combine(aboutCentre, entities.transforms.local[node]);
+                local.tx += moveX;
+                local.ty += moveY;
+
+                entities.transforms.setLocal(node, local);
+                tracks.appliedScale[i] = scale;
+            }
+
+            tracks.appliedX[i] = offsetX;
+            tracks.appliedY[i] = offsetY;
+            continue;
+        }
+
+        const RelativeDataLocation& verticesTarget = entities.verticesComponent.at(entityIndex);
+        uint8_t * vertices = verticesBase + verticesTarget.offsetBytes;
+
+        if(tracks.targetScale[i] == 1.0f)
+        {
+            updateAddVertexPositions(   reinterpret_cast<glm::vec2 *>(vertices),
+                                        verticesTarget.spanElements,
+                                        verticesTarget.strideBytes,
+                                        moveX, moveY );
+        } else {
+            const float scaleProgress = evaluateEasing(tracks.scaleFunctions[i], t);
+            const float scale = std::max(1.0f + (tracks.targetScale[i] - 1.0f) * scaleProgress, MIN_SCALE);
+            const float ratio = scale / tracks.appliedScale[i];
+
+            // Centre has moved along with the target
+            const float centreX = tracks.centerX[i] + tracks.appliedX[i];
+            const float centreY = tracks.centerY[i] + tracks.appliedY[i];
+
+            for(uint16_t v = 0; v < verticesTarget.spanElements; v++)
+            {
+                glm::vec2& position = *reinterpret_cast<glm::vec2 *>(vertices);
+                position.x = centreX + (position.x - centreX) * ratio + moveX;
+                position.y = centreY + (position.y - centreY) * ratio + moveY;
+                vertices += verticesTarget.strideBytes;
+            }
+
+            tracks.appliedScale[i] = scale;
+        }
+
+        tracks.appliedX[i] = offsetX;
+        tracks.appliedY[i] = offsetY;
+
+        verticesUpdated += verticesTarget.spanElements;
+    }
+
+    app.frameStats.bytesUploaded += verticesUpdated * sizeof(glm::vec2);
+
+    // Backwards, as removing swaps the last track into the hole
+    for(uint32_t i = numTracks; i-- > 0;)
+    {
+        if(tracks.elapsedMs[i] >= tracks.durationMs[i]) {
+            stopAnimation(app, tracks.operations[i]);
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+// Time based animation of AnimatedMoveOperations
+// Running an OPERATION_CODE_ANIMATED_MOVE operation starts a track in VulkanApplication::animations. Each frame
+// advanceAnimations moves every track forward by the real time elapsed, so motion doesn't depend on frame rate.
+//
+// moveAnimationFunctionIndex / scaleAnimationFunctionIndex select an EasingFunction. differenceX / differenceY are in
+// SNormFloat16 units (1/10000 of a normalized device unit) and scaleBy is in thousandths (0 for no scaling)
+
+#include <stdint.h>
+#include <chrono>
+
+#include "typesvulkan.h"
+
+enum class EasingFunction : uint8_t
+{
+    LINEAR = 0,
+    EASE_IN_QUAD,
+    EASE_OUT_QUAD,
+    EASE_IN_OUT_QUAD,
+    EASE_IN_CUBIC,
+    EASE_OUT_CUBIC,
+    EASE_IN_OUT_CUBIC,
+    EASE_OUT_BACK,
+    SIZE
+};
+
+// Progress of the easing curve at t, where t is in [0, 1]. Sampled from a lookup table
+float evaluateEasing(uint8_t function, float t);
+
+// Starts a track for the operation. Returns false if the operation is already animating or the track limit is reached
+bool startAnimation(VulkanApplication& app, OperationIndex operationIndex, const AnimatedMoveOperation& animatedMove);
+
+// Stops the track where it is and clears OPERATION_FLAGS_ACTIVE on its operation
+void stopAnimation(VulkanApplication& app, OperationIndex operationIndex);
+
+// Moves every track forward by delta and writes the result to the vertices of the targets, or to their transform
+// for targets that have one
+void advanceAnimations(VulkanApplication& app, std::chrono::milliseconds delta);
+
+#endif // ANIMATION_H
@@ -0,0 +1,81 @@
+#include "arena.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+FrameArena::FrameArena(FrameArena&& other)
+{
+    *this = std::move(other);
+}
+
+FrameArena& FrameArena::operator=(FrameArena&& other)
+{
+    if(this != &other)
+    {
+        release();
+
+        memory = other.memory;
+        capacity = other.capacity;
+        used = other.used;
+        peakUsed = other.peakUsed;
+
+        other.memory = nullptr;
+        other.capacity = 0;
+        other.used = 0;
+        other.peakUsed = 0;
+    }
+
+    return *this;
+}
+
+FrameArena::~FrameArena()
+{
+    release();
+}
+
+void FrameArena::reserve(size_t bytes)
+{
+    assert(bytes > 0);
+
+    release();
+
+    memory = static_cast<uint8_t *>(malloc(bytes));
+
+    if(memory == nullptr) {
+        throw std::runtime_error("failed to reserve frame arena!");
+    }
+
+    capacity = bytes;
+}
+
+void * FrameArena::allocate(size_t sizeBytes, size_t alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    const uintptr_t base = reinterpret_cast<uintptr_t>(memory);
+    const size_t offset = ((base + used + alignment - 1) & ~(alignment - 1)) - base;
+
+    if(offset > capacity || sizeBytes > capacity - offset) {
+        throw std::runtime_error("failed to allocate from frame arena!");
+    }
+
+    used = offset + sizeBytes;
+
+    if(used > peakUsed) {
+        peakUsed = used;
+    }
+
+    return memory + offset;
+}
+
+void FrameArena::release()
+{
+    free(memory);
+
+    memory = nullptr;
+    capacity = 0;
+    used = 0;
+    peakUsed = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+// Bump allocator for memory that only needs to live until the end of the frame. The backing memory is allocated once
+// by reserve and everything handed out is released together by reset, which is called at the start of every frame
+// (See loopLogic). Nothing is constructed or destroyed, so only trivial types can be allocated from it
+
+struct FrameArena
+{
+    uint8_t * memory = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    size_t peakUsed = 0;    // Highest `used` since reserve, for sizing vconfig::FRAME_ARENA_SIZE
+
+    FrameArena() = default;
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    FrameArena(FrameArena&& other);
+    FrameArena& operator=(FrameArena&& other);
+
+    ~FrameArena();
+
+    void reserve(size_t bytes);
+
+    // Throws if the arena doesn't have sizeBytes left. alignment must be a power of two
+    void * allocate(size_t sizeBytes, size_t alignment);
+
+    template <typename T>
+    inline T * allocate(size_t count)
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value);
+        return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Everything allocated since the last reset is invalidated
+    inline void reset() {
+        used = 0;
+    }
+
+    void release();
+};
+
+#endif // ARENA_H
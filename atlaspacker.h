@@ -0,0 +1,85 @@
+#ifndef ATLASPACKER_H
+#define ATLASPACKER_H
+
+#include <stdint.h>
+#include <cassert>
+#include <vector>
+
+// Shelf packing of rects into a fixed size atlas. Rects are placed left to right on the first shelf they fit on, and a
+// new shelf is opened below the last one when none has room. Icons tend to come in a handful of sizes, so shelves
+// waste little space and packing is a scan over the shelves rather than a search. Nothing is ever freed
+
+struct AtlasRect
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct AtlasPacker
+{
+    struct Shelf
+    {
+        uint32_t y;
+        uint32_t height;
+        uint32_t usedWidth;
+    };
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t padding = 0;   // Left around every rect so filtering doesn't bleed between neighbours
+    uint32_t usedHeight = 0;
+
+    std::vector<Shelf> shelves;
+
+    inline void reset(uint32_t atlasWidth, uint32_t atlasHeight, uint32_t rectPadding)
+    {
+        width = atlasWidth;
+        height = atlasHeight;
+        padding = rectPadding;
+        usedHeight = 0;
+        shelves.clear();
+    }
+
+    // False if there's no room left. outRect excludes the padding
+    inline bool insert(uint32_t rectWidth, uint32_t rectHeight, AtlasRect& outRect)
+    {
+        assert(rectWidth > 0 && rectHeight > 0);
+
+        const uint32_t paddedWidth = rectWidth + padding * 2;
+        const uint32_t paddedHeight = rectHeight + padding * 2;
+
+        if(paddedWidth > width) {
+            return false;
+        }
+
+        Shelf * best = nullptr;
+
+        // Shortest shelf that's tall enough, so small rects don't use up tall shelves
+        for(Shelf& shelf : shelves)
+        {
+            if(shelf.height >= paddedHeight && width - shelf.usedWidth >= paddedWidth && (best == nullptr || shelf.height < best->height)) {
+                best = &shelf;
+            }
+        }
+
+        if(best == nullptr)
+        {
+            if(height - usedHeight < paddedHeight) {
+                return false;
+            }
+
+            shelves.push_back({ usedHeight, paddedHeight, 0 });
+            usedHeight += paddedHeight;
+            best = &shelves.back();
+        }
+
+        outRect = { best->usedWidth + padding, best->y + padding, rectWidth, rectHeight };
+        best->usedWidth += paddedWidth;
+
+        return true;
+    }
+};
+
+#endif // ATLASPACKER_H
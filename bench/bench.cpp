@@ -0,0 +1,1417 @@
+#include "mainvulkan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+// Scene benchmarks
+// Each scenario builds a scene on a freshly created headless application, renders a fixed number of warmup frames
+// and then times a fixed number of measured frames. There is no randomness and every frame is given the same time
+// delta, so results are comparable between runs and between versions.
+//
+// Usage: vkgui_bench [--frames <count>] [--warmup <count>] [--scenario <name>] [--output <path.json>]
+
+#ifndef VKGUI_VERSION
+#define VKGUI_VERSION "unknown"
+#endif
+
+static const std::chrono::milliseconds FIXED_FRAME_DELTA(16);
+
+// BEGIN Heap allocation counting
+
+// Every operator new in the process goes through here, so the frame path can be checked for allocations.
+// The array and sized forms forward to these by default
+static std::atomic<uint64_t> numHeapAllocations(0);
+
+void * operator new(size_t sizeBytes)
+{
+    numHeapAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    void * memory = malloc((sizeBytes > 0) ? sizeBytes : 1);
+
+    if(memory == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void operator delete(void * memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void * memory, size_t) noexcept
+{
+    free(memory);
+}
+
+// END Heap allocation counting
+
+struct ScenarioParams
+{
+    uint32_t numElements;
+    uint32_t textLength;
+};
+
+struct Scenario
+{
+    const char * name;
+    ScenarioParams params;
+
+    // Builds the scene and returns the number of elements actually created (Requests are clamped to the fixed capacities in VulkanApplication)
+    uint32_t (*build)(VulkanApplication& app, const ScenarioParams& params);
+
+    // Optional work done at the start of every frame, before loopLogic
+    void (*onFrame)(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements);
+
+    // Optional, called after the last frame. Used to undo state kept outside of VulkanApplication
+    void (*teardown)(VulkanApplication& app);
+};
+
+struct ScenarioResult
+{
+    std::string name;
+    uint32_t requestedElements;
+    uint32_t numElements;
+    uint32_t textLength;
+
+    double frameMeanMs;
+    double frameActionMeanMs;   // Time spent in Scenario::onFrame
+    double frameP50Ms;
+    double frameP95Ms;
+    double frameP99Ms;
+    double frameMaxMs;
+
+    uint64_t sceneUploadBytes;
+    double bytesUploadedPerFrame;
+    double commandBufferRecordingsPerFrame;
+    uint32_t drawsPerFrame;
+
+    // Made by loopLogic and drawFrame, Scenario::onFrame isn't counted
+    double heapAllocationsPerFrame;
+
+    uint64_t vertexBytes;
+    uint64_t indexBytes;
+    long peakResidentKiB;
+
+    // Image residency over the whole run (See TextureResidencyStats)
+    uint64_t textureHits;
+    uint64_t textureMisses;
+    uint64_t textureEvictions;
+    uint64_t textureBytesResident;
+
+    // Pipeline variants built and served from the cache over the whole run (See PipelineVariants)
+    uint32_t pipelineBuilds;
+    uint32_t pipelineHits;
+};
+
+static const uint8_t VERTICES_PER_CHAR = 4;
+static const uint8_t INDICES_PER_CHAR = 6;
+
+static const char * const BENCH_CHARSET = "abcdefghijklmnopqrstuvwxyz";
+
+// BEGIN Capacity helpers
+
+
+static uint32_t remainingOperations(const VulkanApplication& app, uint32_t operationBytes)
+{
+    const OperationStore& store = app.operations;
+
+    const uint32_t freeIndices = (OperationStore::MAX_OPERATIONS - store.numIndices) + store.numFreeIndices;
+    const uint32_t freeBlocks = (OperationStore::STORAGE_BYTES - store.storageUsed) / operationBytes;
+
+    return std::min(freeIndices, freeBlocks);
+}
+
+static uint32_t remainingOp8(const VulkanApplication& app)
+{
+    return remainingOperations(app, sizeof(Operation8));
+}
+
+static uint32_t remainingOp16(const VulkanApplication& app)
+{
+    return remainingOperations(app, sizeof(Operation16));
+}
+
+static uint32_t remainingTextChars(const VulkanApplication& app)
+{
+    const VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
+
+    const uint32_t regionSize = vconfig::PIPELINE_MEMORY_SIZE / 2;
+    const uint32_t maxByVertices = (regionSize / (VERTICES_PER_CHAR * sizeof(Vertex))) - (texturesPipeline.numVertices / VERTICES_PER_CHAR);
+    const uint32_t maxByIndices = (regionSize / (INDICES_PER_CHAR * sizeof(uint16_t))) - (texturesPipeline.numIndices / INDICES_PER_CHAR);
+    const uint32_t maxByIndexRange = (UINT16_MAX / VERTICES_PER_CHAR) - (texturesPipeline.numVertices / VERTICES_PER_CHAR);
+
+    return std::min(maxByVertices, std::min(maxByIndices, maxByIndexRange));
+}
+
+// Each button is two entities, its background and an 8 character label. Operations target entities by 16 bit index
+static uint32_t remainingButtons(const VulkanApplication& app)
+{
+    // Buttons are targeted by operations, which can only reference the slots an Entity16 can hold
+    const uint32_t entityCapacity = ENTITY16_INDEX_MASK + 1;
+    const uint32_t byEntities = (app.entitySystem.numEntities < entityCapacity) ? (entityCapacity - app.entitySystem.numEntities) / 2 : 0;
+
+    return std::min(byEntities, remainingTextChars(app) / 8);
+}
+
+// END Capacity helpers
+
+// BEGIN Scene building
+
+static void prepareScene(VulkanApplication& app)
+{
+    app.pipelines[PipelineType::Texture].vertexStride = sizeof(Vertex);
+    app.pipelines[PipelineType::PrimativeShapes].vertexStride = sizeof(BasicVertex);
+}
+
+static std::string benchText(uint32_t seed, uint32_t length)
+{
+    std::string text(length, 'a');
+
+    for(uint32_t i = 0; i < length; i++) {
+        text[i] = BENCH_CHARSET[(seed + i) % 26];
+    }
+
+    return text;
+}
+
+// Buttons are laid out in a 4 column grid
+static NormalizedPoint buttonPoint(uint32_t index)
+{
+    NormalizedPoint point;
+    point.x.set(-0.9 + (index % 4) * 0.45);
+    point.y.set(-0.9 + (index / 4) * 0.12);
+
+    return point;
+}
+
+// Returns the entity of each button's text
+static std::vector<Entity32> addButtonEntities(VulkanApplication& app, uint32_t numButtons)
+{
+    std::vector<Entity32> entities;
+    entities.reserve(numButtons);
+
+    for(uint32_t i = 0; i < numButtons; i++)
+    {
+        NormalizedPoint point = buttonPoint(i);
+
+        // drawText only supports 8 character strings
+        std::string text = benchText(i, 8);
+
+        entities.push_back(button(app, { 0.0f, 1.0f, 0.0f }, text, point));
+    }
+
+    return entities;
+}
+
+// As addButtonEntities, in the compact form that operations store
+static std::vector<Entity16> addButtons(VulkanApplication& app, uint32_t numButtons)
+{
+    std::vector<Entity16> entities;
+    entities.reserve(numButtons);
+
+    for(Entity32 textEntity : addButtonEntities(app, numButtons)) {
+        entities.push_back(entity::toEntity16(textEntity));
+    }
+
+    return entities;
+}
+
+static uint32_t buildButtons(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t numButtons = std::min(params.numElements, remainingButtons(app));
+    addButtons(app, numButtons);
+
+    return numButtons;
+}
+
+static uint32_t buildTextLabels(VulkanApplication& app, const ScenarioParams& params)
+{
+    VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
+
+    assert(params.textLength > 0);
+
+    const uint32_t numLabels = std::min(params.numElements, remainingTextChars(app) / params.textLength);
+
+    for(uint32_t i = 0; i < numLabels; i++)
+    {
+        std::string text = benchText(i, params.textLength);
+
+        const uint16_t requiredVertices = static_cast<uint16_t>(params.textLength * VERTICES_PER_CHAR);
+        const uint16_t requiredIndices = static_cast<uint16_t>(params.textLength * INDICES_PER_CHAR);
+
+        glm::vec2 * startTexCoordPos = texturesPipeline.getFreeVertices(app.mappedVerticesMemory, sizeof(Vertex), offsetof(Vertex, texCoord));
+        uint16_t verticesStartIndex = static_cast<uint16_t>(texturesPipeline.numVertices);
+
+        generateTextMeshes( texturesPipeline.writeIndices(app.mappedIndicesMemory, requiredIndices),
+                            texturesPipeline.writeVertices(app.mappedVerticesMemory, requiredVertices, sizeof(Vertex), offsetof(Vertex, pos)),
+                            sizeof(Vertex),
+                            verticesStartIndex,
+                            app.fontBitmap,
+                            startTexCoordPos,
+                            texturesPipeline.vertexStride,
+                            text,
+                            10,
+                            static_cast<uint16_t>(20 + (i * 20) % (vconfig::INITIAL_WINDOW_HEIGHT - 40)) );
+    }
+
+    return numLabels;
+}
+
+// One mouse bounds per button, laid out side by side in a single row. Entering a bounds nudges its button up
+// and leaving moves it back down
+static uint32_t buildHoverTargets(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t numTargets = std::min( { params.numElements, remainingButtons(app), remainingOp8(app) / 2 } );
+
+    std::vector<Entity16> entities = addButtons(app, numTargets);
+
+    app.onMouseEventOpBindings.numAreas = 0;
+    app.onMouseEventOpBindings.clearBounds();
+
+    const double slotWidth = (numTargets > 0) ? 2.0 / numTargets : 0.0;
+
+    for(uint32_t i = 0; i < numTargets; i++)
+    {
+        Operation8Union op8;
+
+        op8.relativeMove = { entities[i], {0}, {-50} };
+        const OperationIndex enterOpIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, 0, op8);
+
+        op8.relativeMove = { entities[i], {0}, {50} };
+        const OperationIndex exitOpIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, 0, op8);
+
+        MouseBounds bounds;
+
+        bounds.boundsArea.topLeftPoint.x.set(-1.0 + (i * slotWidth));
+        bounds.boundsArea.topLeftPoint.y.set(-0.2);
+        bounds.boundsArea.width.set(slotWidth * 0.8);
+        bounds.boundsArea.height.set(0.4);
+        bounds.flags = MOUSE_BOUNDS_FLAGS_1_ON_HOVER_ENTER | MOUSE_BOUNDS_FLAGS_1_ON_HOVER_EXIT;
+        bounds.onHoverEnterOperation = enterOpIndex;
+        bounds.onHoverExitOperation = exitOpIndex;
+        bounds.onLClickOperation = OPERATION_INDEX_INVALID;
+        bounds.onRClickOperation = OPERATION_INDEX_INVALID;
+        bounds.onMClickOperation = OPERATION_INDEX_INVALID;
+        bounds.numSubAreas = 0;
+
+        app.onMouseEventOpBindings.addBounds(bounds);
+    }
+
+    return numTargets;
+}
+
+// Tiles the screen with a square grid of small mouse bounds, all sharing one button and its enter / exit operations.
+// Measures hit testing with many more regions than the cursor could ever be over. Round bounds are a full circle
+// sub area inside each tile, so every candidate also goes through the arc test. Bounds are 80% of their tile, unless
+// a size in pixels is given, in which case the tiles are sized to fit them and there are as many as fit the screen.
+// Bounds never overlap, as only one can be active at a time
+static uint32_t addHoverGrid(VulkanApplication& app, const ScenarioParams& params, bool round, double widthPixels = 0.0, double heightPixels = 0.0)
+{
+    if(remainingButtons(app) == 0 || remainingOp8(app) < 2) {
+        return 0;
+    }
+
+    const uint32_t boundsPerAxis = static_cast<uint32_t>(std::sqrt(static_cast<double>(std::min(params.numElements, static_cast<uint32_t>(UINT16_MAX)))));
+
+    double width = (boundsPerAxis > 0) ? 1.6 / boundsPerAxis : 0.0;
+    double height = width;
+    uint32_t columns = boundsPerAxis;
+    uint32_t rows = boundsPerAxis;
+
+    if(widthPixels > 0.0 && heightPixels > 0.0)
+    {
+        width = 2.0 * widthPixels / vconfig::INITIAL_WINDOW_WIDTH;
+        height = 2.0 * heightPixels / vconfig::INITIAL_WINDOW_HEIGHT;
+        columns = std::min(static_cast<uint32_t>(1.6 / width), boundsPerAxis);
+        rows = std::min(static_cast<uint32_t>(1.6 / height), boundsPerAxis);
+    }
+
+    const uint32_t numTargets = columns * rows;
+
+    std::vector<Entity16> entities = addButtons(app, 1);
+
+    Operation8Union op8;
+
+    op8.relativeMove = { entities[0], {0}, {-50} };
+    const OperationIndex enterOpIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, 0, op8);
+
+    op8.relativeMove = { entities[0], {0}, {50} };
+    const OperationIndex exitOpIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, 0, op8);
+
+    app.onMouseEventOpBindings.numAreas = 0;
+    app.onMouseEventOpBindings.clearBounds();
+
+    const double tileWidth = (columns > 0) ? 2.0 / columns : 0.0;
+    const double tileHeight = (rows > 0) ? 2.0 / rows : 0.0;
+
+    for(uint32_t i = 0; i < numTargets; i++)
+    {
+        MouseBounds bounds;
+
+        bounds.boundsArea.topLeftPoint.x.set(-1.0 + ((i % columns) * tileWidth));
+        bounds.boundsArea.topLeftPoint.y.set(-1.0 + ((i / columns) * tileHeight));
+        bounds.boundsArea.width.set(width);
+        bounds.boundsArea.height.set(height);
+        bounds.flags = MOUSE_BOUNDS_FLAGS_1_ON_HOVER_ENTER | MOUSE_BOUNDS_FLAGS_1_ON_HOVER_EXIT;
+        bounds.onHoverEnterOperation = enterOpIndex;
+        bounds.onHoverExitOperation = exitOpIndex;
+        bounds.onLClickOperation = OPERATION_INDEX_INVALID;
+        bounds.onRClickOperation = OPERATION_INDEX_INVALID;
+        bounds.onMClickOperation = OPERATION_INDEX_INVALID;
+        bounds.numSubAreas = 0;
+
+        if(round)
+        {
+            // Fits the tile on screen. The radius is in units of the x axis, which are a different size in pixels
+            const double heightInWidthUnits = height * vconfig::INITIAL_WINDOW_HEIGHT / vconfig::INITIAL_WINDOW_WIDTH;
+
+            NormalizedArc circle;
+            circle.radius.set(std::min(width, heightInWidthUnits) / 2.0);
+            circle.center.x.data = static_cast<int16_t>(bounds.boundsArea.width.data / 2);
+            circle.center.y.data = static_cast<int16_t>(bounds.boundsArea.height.data / 2);
+            circle.startAngle = 0;
+            circle.endAngle = 0;
+
+            app.onMouseEventOpBindings.addBounds(bounds, {}, { circle });
+        } else {
+            app.onMouseEventOpBindings.addBounds(bounds);
+        }
+    }
+
+    return numTargets;
+}
+
+static uint32_t buildHoverGrid(VulkanApplication& app, const ScenarioParams& params)
+{
+    return addHoverGrid(app, params, false);
+}
+
+static uint32_t buildRoundHoverGrid(VulkanApplication& app, const ScenarioParams& params)
+{
+    return addHoverGrid(app, params, true);
+}
+
+// 96x32 pixel bounds cover many cells of the finest level of the grid, so they're found in a coarser one
+static uint32_t buildHoverButtons(VulkanApplication& app, const ScenarioParams& params)
+{
+    return addHoverGrid(app, params, false, 96.0, 32.0);
+}
+
+static int32_t clampReference(int64_t value, int64_t min, int64_t max) {
+    return static_cast<int32_t>(std::min(std::max(value, min), max));
+}
+
+// Every 16 bit value against the values at and around the ends of the normalized range and the storage type,
+// compared with the same operation done in 64 bits and clamped. Also round trips every pixel of a few extents
+static bool fixedPointMatchesReference()
+{
+    const int32_t edges[] = {   INT16_MIN, INT16_MIN + 1, NORMFLOAT_MIN - 1, NORMFLOAT_MIN, NORMFLOAT_MIN + 1, -1, 0, 1,
+                                NORMFLOAT_MAX - 1, NORMFLOAT_MAX, NORMFLOAT_MAX + 1, INT16_MAX - 1, INT16_MAX };
+
+    for(int32_t a = INT16_MIN; a <= INT16_MAX; a++)
+    {
+        const int16_t signedA = static_cast<int16_t>(a);
+        const uint16_t unsignedA = static_cast<uint16_t>(a - INT16_MIN);
+
+        for(int32_t b : edges)
+        {
+            const int16_t signedB = static_cast<int16_t>(b);
+            const uint16_t unsignedB = static_cast<uint16_t>(b - INT16_MIN);
+
+            const int64_t product = static_cast<int64_t>(a) * b;
+            const int64_t productRounded = (product >= 0) ? (product + fixed16::ONE / 2) / fixed16::ONE
+                                                          : -((-product + fixed16::ONE / 2) / fixed16::ONE);
+
+            if(fixed16::add(signedA, signedB) != clampReference(static_cast<int64_t>(a) + b, INT16_MIN, INT16_MAX) ||
+               fixed16::subtract(signedA, signedB) != clampReference(static_cast<int64_t>(a) - b, INT16_MIN, INT16_MAX) ||
+               fixed16::add(signedA, unsignedB) != clampReference(static_cast<int64_t>(a) + unsignedB, INT16_MIN, INT16_MAX) ||
+               fixed16::add(unsignedA, unsignedB) != clampReference(static_cast<int64_t>(unsignedA) + unsignedB, 0, UINT16_MAX) ||
+               fixed16::mul(signedA, signedB) != clampReference(productRounded, INT16_MIN, INT16_MAX) ||
+               fixed16::compare(a, b) != ((a > b) ? 1 : (a < b) ? -1 : 0))
+            {
+                printf("Fixed point mismatch for %d and %d\n", a, b);
+                return false;
+            }
+        }
+    }
+
+    const uint16_t extents[] = { 1, 600, 800, 1920, 4096, 2 * fixed16::ONE };
+
+    for(uint16_t extent : extents)
+    {
+        for(int32_t pixel = 0; pixel <= extent; pixel++)
+        {
+            const int32_t value = fixed16::fromPixels(pixel, extent);
+
+            if(value < NORMFLOAT_MIN || value > NORMFLOAT_MAX || fixed16::toPixels(value, extent) != pixel) {
+                printf("Fixed point pixel mismatch for %d of %u\n", pixel, extent);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Hover grid where every bounds is moved each frame, which goes through the fixed point adds and the grid update
+static uint32_t buildMovingBounds(VulkanApplication& app, const ScenarioParams& params)
+{
+    return addHoverGrid(app, params, false);
+}
+
+static uint32_t buildPerFrameOperations(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t perFrameCapacity = app.perFrameOperations.capacity - app.perFrameOperations.count;
+    const uint32_t numOperations = std::min( { params.numElements, perFrameCapacity, remainingOp8(app) } );
+    const uint32_t numButtons = std::max(1u, std::min(numOperations, remainingButtons(app)));
+
+    std::vector<Entity16> entities = addButtons(app, numButtons);
+
+    for(uint32_t i = 0; i < numOperations; i++)
+    {
+        Operation8Union op8;
+        op8.relativeMove = { entities[i % entities.size()], {1}, {1} };
+
+        const OperationIndex operationIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, OPERATION_FLAGS_PER_FRAME, op8);
+
+        // Activates the operation, after which it's run every frame inside loopLogic
+        handleOperation(app, operationIndex);
+    }
+
+    return numOperations;
+}
+
+// Long running animations so every measured frame advances all of them. Targets are shared between tracks
+// as there are far fewer entities than animations
+static uint32_t buildAnimations(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t animationCapacity = app.animations.capacity - app.animations.size();
+    const uint32_t numAnimations = std::min( { params.numElements, animationCapacity, remainingOp16(app) } );
+    const uint32_t numButtons = std::max(1u, std::min(numAnimations, remainingButtons(app)));
+
+    std::vector<Entity16> entities = addButtons(app, numButtons);
+
+    for(uint32_t i = 0; i < numAnimations; i++)
+    {
+        Operation16Union op16;
+        op16.animatedMove.targetEntity = entities[i % entities.size()];
+        op16.animatedMove.durationMs = UINT16_MAX;
+        op16.animatedMove.currentMs = 0;
+        op16.animatedMove.differenceX = 10;
+        op16.animatedMove.differenceY = 10;
+        op16.animatedMove.moveAnimationFunctionIndex = static_cast<uint8_t>(i % static_cast<uint32_t>(EasingFunction::SIZE));
+        op16.animatedMove.scaleAnimationFunctionIndex = static_cast<uint8_t>(EasingFunction::LINEAR);
+        op16.animatedMove.scaleBy = (i % 2 == 0) ? 1001 : 0;
+
+        handleOperation(app, app.insertOp16(OPERATION_CODE_ANIMATED_MOVE, 0, op16));
+    }
+
+    return numAnimations;
+}
+
+// Button labels that are animated and moved every frame, released one per frame while they still are (See releaseAnimating)
+static std::vector<Entity32> animatingEntities;
+
+static uint32_t buildReleasingAnimations(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t animationCapacity = app.animations.capacity - app.animations.size();
+    const uint32_t perFrameCapacity = app.perFrameOperations.capacity - app.perFrameOperations.count;
+    const uint32_t numButtons = std::min( { params.numElements, remainingButtons(app), animationCapacity, perFrameCapacity, remainingOp16(app), remainingOp8(app) } );
+
+    animatingEntities = addButtonEntities(app, numButtons);
+
+    for(Entity32 entity : animatingEntities)
+    {
+        Operation16Union op16;
+        op16.animatedMove.targetEntity = entity::toEntity16(entity);
+        op16.animatedMove.durationMs = UINT16_MAX;
+        op16.animatedMove.currentMs = 0;
+        op16.animatedMove.differenceX = 10;
+        op16.animatedMove.differenceY = 10;
+        op16.animatedMove.moveAnimationFunctionIndex = static_cast<uint8_t>(EasingFunction::LINEAR);
+        op16.animatedMove.scaleAnimationFunctionIndex = static_cast<uint8_t>(EasingFunction::LINEAR);
+        op16.animatedMove.scaleBy = 1001;
+
+        handleOperation(app, app.insertOp16(OPERATION_CODE_ANIMATED_MOVE, 0, op16));
+
+        Operation8Union op8;
+        op8.relativeMove = { entity::toEntity16(entity), {1}, {1} };
+
+        handleOperation(app, app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, OPERATION_FLAGS_PER_FRAME, op8));
+    }
+
+    return numButtons;
+}
+
+// Entities with only a colour component, which nothing draws. Measures the entity system on its own (See entityChurn)
+static std::vector<Entity32> churnEntities;
+
+static uint32_t buildEntities(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t numEntities = std::min(params.numElements, EntitySystemHandle::MAX_ENTITIES - app.entitySystem.numEntities);
+
+    churnEntities.clear();
+    churnEntities.reserve(numEntities);
+
+    for(uint32_t i = 0; i < numEntities; i++)
+    {
+        const Entity32 entity = requestEntity(app.entitySystem);
+        app.entitySystem.colorComponent.set(entity::indexOf(entity), { static_cast<uint8_t>(i), 0, 0, 255 });
+        churnEntities.push_back(entity);
+    }
+
+    return numEntities;
+}
+
+// Used by the dispatch scenarios. The same operations are run either through one operation chain or by
+// calling handleOperation directly, so the difference is the interpreter's overhead
+static std::vector<OperationIndex> dispatchOperations;
+static uint16_t dispatchChain = 0;
+
+static uint32_t buildDispatchOperations(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t numOperations = std::min(params.numElements, remainingOp8(app));
+
+    std::vector<Entity16> entities = addButtons(app, 1);
+
+    dispatchOperations.clear();
+
+    OperationChainBuilder chainBuilder(app.operationChains);
+    dispatchChain = chainBuilder.begin();
+
+    for(uint32_t i = 0; i < numOperations; i++)
+    {
+        // Alternate directions so the target stays in place
+        const int16_t direction = (i % 2 == 0) ? 1 : -1;
+
+        Operation8Union op8;
+        op8.relativeMove = { entities[0], { direction }, { direction } };
+
+        const OperationIndex operationIndex = app.insertOp8(OPERATION_CODE_RELATIVE_MOVE, 0, op8);
+
+        dispatchOperations.push_back(operationIndex);
+        chainBuilder.runOperation(operationIndex);
+    }
+
+    chainBuilder.end();
+
+    return numOperations;
+}
+
+// Positions updated straight through the vertex kernels, outside of any pipeline. Half are a packed stream
+// and half are strided like the texture pipeline's vertices
+static std::vector<float> kernelPackedVertices;
+static std::vector<float> kernelStridedVertices;
+
+static const uint32_t KERNEL_STRIDED_FLOATS = sizeof(Vertex) / sizeof(float);
+
+static float kernelTestValue(uint32_t seed) {
+    return static_cast<float>((seed * 2654435761u) % 2001) / 1000.0f - 1.0f;
+}
+
+// Runs every kernel for the active target against the reference over a spread of lengths and strides
+static bool vertexKernelsMatchReference()
+{
+    const Affine2D transform = { 0.8f, 0.6f, -0.6f, 0.8f, 0.25f, -0.5f };
+    const uint32_t strides[] = { 8, 12, 16, sizeof(BasicVertex), sizeof(Vertex) };
+
+    for(uint32_t strideBytes : strides)
+    {
+        for(uint32_t numVertices = 0; numVertices < 40; numVertices++)
+        {
+            for(uint8_t kernel = 0; kernel < 3; kernel++)
+            {
+                std::vector<float> actual((numVertices * strideBytes) / sizeof(float) + 2);
+
+                for(uint32_t i = 0; i < actual.size(); i++) {
+                    actual[i] = kernelTestValue(i + numVertices * 31 + strideBytes);
+                }
+
+                std::vector<float> expected = actual;
+
+                if(kernel == 0) {
+                    translateVertices(actual.data(), numVertices, strideBytes, 0.125f, -0.75f);
+                    translateVerticesReference(expected.data(), numVertices, strideBytes, 0.125f, -0.75f);
+                } else if(kernel == 1) {
+                    scaleVertices(actual.data(), numVertices, strideBytes, 1.5f, -0.25f);
+                    scaleVerticesReference(expected.data(), numVertices, strideBytes, 1.5f, -0.25f);
+                } else {
+                    transformVertices(actual.data(), numVertices, strideBytes, transform);
+                    transformVerticesReference(expected.data(), numVertices, strideBytes, transform);
+                }
+
+                // Padding between positions must be left untouched, so every float is compared
+                for(uint32_t i = 0; i < actual.size(); i++)
+                {
+                    if(std::fabs(actual[i] - expected[i]) > 1e-5f * (1.0f + std::fabs(expected[i]))) {
+                        printf("Vertex kernel %u (%s) differs from reference. Stride %u, %u vertices\n",
+                               kernel, vertexKernelTargetName(vertexKernelTarget()), strideBytes, numVertices);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static uint32_t buildVertexKernels(VulkanApplication& app, const ScenarioParams& params, VertexKernelTarget target)
+{
+    (void)app;
+
+    setVertexKernelTarget(target);
+
+    const uint32_t streamVertices = params.numElements / 2;
+
+    kernelPackedVertices.resize(static_cast<size_t>(streamVertices) * 2);
+    kernelStridedVertices.resize(static_cast<size_t>(streamVertices) * KERNEL_STRIDED_FLOATS);
+
+    for(uint32_t i = 0; i < kernelPackedVertices.size(); i++) {
+        kernelPackedVertices[i] = kernelTestValue(i);
+    }
+
+    for(uint32_t i = 0; i < kernelStridedVertices.size(); i++) {
+        kernelStridedVertices[i] = kernelTestValue(i);
+    }
+
+    return streamVertices * 2;
+}
+
+static uint32_t buildScalarVertexKernels(VulkanApplication& app, const ScenarioParams& params)
+{
+    return buildVertexKernels(app, params, VertexKernelTarget::SCALAR);
+}
+
+static uint32_t buildSimdVertexKernels(VulkanApplication& app, const ScenarioParams& params)
+{
+    return buildVertexKernels(app, params, bestVertexKernelTarget());
+}
+
+// Button text parented to one container transform, which is moved every frame (See moveSubtree)
+static uint32_t transformSubtreeRoot = TransformHierarchy::INVALID_NODE;
+
+static uint32_t buildTransformSubtree(VulkanApplication& app, const ScenarioParams& params)
+{
+    TransformHierarchy& transforms = app.entitySystem.transforms;
+
+    const uint32_t transformCapacity = transforms.capacity - transforms.size();
+
+    if(transformCapacity < 2) {
+        return 0;
+    }
+
+    const uint32_t numButtons = std::min( { params.numElements, remainingButtons(app), transformCapacity - 1 } );
+
+    transformSubtreeRoot = transforms.create(TransformHierarchy::ROOT, transform::identity());
+
+    for(Entity32 textEntity : addButtonEntities(app, numButtons)) {
+        attachTransform(app, textEntity, transformSubtreeRoot, transform::identity());
+    }
+
+    return numButtons;
+}
+
+// Rows of fixed size leaves in a column, with button text placed by the leaves of the first row. Each frame one leaf
+// changes width, which moves its siblings and the buttons with them (See resizeLayoutLeaf)
+static std::vector<uint32_t> layoutLeaves;
+
+static uint32_t buildLayout(VulkanApplication& app, const ScenarioParams& params)
+{
+    static const uint32_t NODES_PER_ROW = 100;
+
+    LayoutTree& layout = app.layout;
+
+    LayoutStyle rootStyle;
+    rootStyle.kind = LayoutKind::COLUMN;
+    rootStyle.padding = 500;
+    rootStyle.gap = 200;
+    layout.setStyle(LayoutTree::ROOT, rootStyle);
+
+    LayoutStyle rowStyle;
+    rowStyle.kind = LayoutKind::ROW;
+    rowStyle.align = LayoutAlign::CENTER;
+    rowStyle.gap = 250;
+
+    LayoutStyle leafStyle;
+    leafStyle.width = { LayoutUnit::FIXED, 2000 };
+    leafStyle.height = { LayoutUnit::FIXED, 700 };
+
+    const uint32_t numNodes = std::min(params.numElements, layout.capacity - layout.size());
+
+    layoutLeaves.clear();
+
+    uint32_t row = LayoutTree::INVALID_NODE;
+
+    for(uint32_t i = 0; i < numNodes; i++)
+    {
+        if(i % NODES_PER_ROW == 0) {
+            row = layout.create(LayoutTree::ROOT, rowStyle);
+        } else {
+            layoutLeaves.push_back(layout.create(row, leafStyle));
+        }
+    }
+
+    const uint32_t numButtons = std::min( { static_cast<uint32_t>(layoutLeaves.size()), NODES_PER_ROW - 1, remainingButtons(app) } );
+    const std::vector<Entity32> entities = addButtonEntities(app, numButtons);
+
+    for(uint32_t i = 0; i < numButtons; i++) {
+        bindLayout(app, entities[i], layoutLeaves[i], buttonPoint(i));
+    }
+
+    return numNodes;
+}
+
+// Labels that are set every frame, nearly always to the text they already have (See updateLabels)
+static std::vector<Entity32> labelEntities;
+static std::vector<std::string> labelTexts;
+
+static uint32_t buildLabels(VulkanApplication& app, const ScenarioParams& params)
+{
+    const uint32_t numButtons = std::min(params.numElements, remainingButtons(app));
+
+    labelEntities = addButtonEntities(app, numButtons);
+    labelTexts.clear();
+
+    for(uint32_t i = 0; i < numButtons; i++) {
+        labelTexts.push_back(benchText(i, 8));
+    }
+
+    return numButtons;
+}
+
+static std::vector<std::string> residencyImagePaths;
+static Entity32 residencyEntity = ENTITY_INVALID;
+
+// Images too large for the atlas, with a budget that only holds a few of them, so showing them in turn keeps evicting
+// and reloading
+static uint32_t buildImageResidency(VulkanApplication& app, const ScenarioParams& params)
+{
+    if(! app.images.isAvailable) {
+        return 0;
+    }
+
+    const uint32_t imageSize = 128;
+    const uint32_t imageBytes = imageSize * imageSize * 4;
+
+    std::vector<uint8_t> pixels(imageBytes);
+    residencyImagePaths.clear();
+
+    for(uint32_t i = 0; i < params.numElements; i++)
+    {
+        for(uint32_t p = 0; p < imageBytes; p += 4)
+        {
+            pixels[p + 0] = static_cast<uint8_t>(i * 37);
+            pixels[p + 1] = static_cast<uint8_t>(p / (imageSize * 4));
+            pixels[p + 2] = static_cast<uint8_t>(p);
+            pixels[p + 3] = 255;
+        }
+
+        const std::string path = std::string(P_tmpdir) + "/vkgui_bench_image_" + std::to_string(i) + ".png";
+
+        if(! writePNG(path.c_str(), pixels.data(), imageSize, imageSize)) {
+            throw std::runtime_error("failed to write bench image!");
+        }
+
+        residencyImagePaths.push_back(path);
+    }
+
+    // Mipmaps and alignment stay well within double the size of the pixels
+    app.images.budgetBytes = app.images.stats.bytesResident + 4 * 2 * imageBytes;
+
+    return params.numElements;
+}
+
+// END Scene building
+
+// BEGIN Per frame actions
+
+static void sweepCursor(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    // Cross the full width every 64 frames, back and forth
+    const uint32_t step = frameIndex % 128;
+    const uint32_t position = (step < 64) ? step : 127 - step;
+    const double xPos = (position / 63.0) * (vconfig::INITIAL_WINDOW_WIDTH - 1);
+
+    handleCursorMove(app, xPos, vconfig::INITIAL_WINDOW_HEIGHT / 2.0);
+}
+
+// One label changes each frame, to text that other labels already have, so its mesh is always cached
+static void updateLabels(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    if(labelEntities.empty()) {
+        return;
+    }
+
+    labelTexts[frameIndex % labelEntities.size()] = benchText(frameIndex % 64, 8);
+
+    for(size_t i = 0; i < labelEntities.size(); i++) {
+        setText(app, labelEntities[i], labelTexts[i]);
+    }
+}
+
+static void resizeLayoutLeaf(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    if(layoutLeaves.empty()) {
+        return;
+    }
+
+    LayoutStyle style = app.layout.styleOf(layoutLeaves[0]);
+    style.width.value = (frameIndex % 2 == 0) ? 2500 : 2000;
+    app.layout.setStyle(layoutLeaves[0], style);
+}
+
+// Small enough steps that bounds stay on the grid, alternating so they don't drift
+static void moveAllBounds(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    const int16_t step = (frameIndex % 2 == 0) ? 25 : -25;
+
+    for(uint16_t i = 0; i < app.onMouseEventOpBindings.numBounds; i++) {
+        app.onMouseEventOpBindings.moveBounds(i, { step }, { step });
+    }
+}
+
+// Many motion events per frame, as from a high polling rate mouse. They go through the input queue, which
+// coalesces them so only the last position is hit tested
+static void cursorStorm(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    const uint32_t eventsPerFrame = 1000;
+
+    for(uint32_t i = 0; i < eventsPerFrame; i++)
+    {
+        const double position = ((frameIndex * eventsPerFrame + i) % 4096) / 4095.0;
+        app.input.pushCursorMove(position * (vconfig::INITIAL_WINDOW_WIDTH - 1), vconfig::INITIAL_WINDOW_HEIGHT / 2.0);
+    }
+
+    processInput(app);
+}
+
+// Releases the next animating label. Nothing may still target it, or the next frame would move a released entity
+static void releaseAnimating(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    if(frameIndex >= numElements || frameIndex >= animatingEntities.size()) {
+        return;
+    }
+
+    const Entity32 entity = animatingEntities[frameIndex];
+    releaseEntity(app, entity);
+
+    for(Entity16 target : app.animations.targets)
+    {
+        if(entity::indexOf16(target) == entity::indexOf(entity)) {
+            throw std::runtime_error("failed to stop the animations of a released entity!");
+        }
+    }
+
+    for(Entity16 target : app.perFrameOperations.relativeMoves.targets)
+    {
+        if(entity::indexOf16(target) == entity::indexOf(entity)) {
+            throw std::runtime_error("failed to stop the per frame moves of a released entity!");
+        }
+    }
+}
+
+// Destroys and recreates a slice of the entities, then iterates every colour
+static void entityChurn(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    const uint32_t churnPerFrame = 4096;
+    const size_t numEntities = churnEntities.size();
+
+    if(numEntities == 0) {
+        return;
+    }
+
+    EntitySystemHandle& entities = app.entitySystem;
+
+    for(uint32_t i = 0; i < churnPerFrame; i++)
+    {
+        Entity32& slot = churnEntities[(static_cast<size_t>(frameIndex) * churnPerFrame * 7 + i * 7) % numEntities];
+
+        releaseEntity(entities, slot);
+        slot = requestEntity(entities);
+        entities.colorComponent.set(entity::indexOf(slot), { static_cast<uint8_t>(frameIndex), 0, 0, 255 });
+    }
+
+    uint32_t checksum = 0;
+
+    for(const EntityColor& color : entities.colorComponent.dense) {
+        checksum += color.r;
+    }
+
+    // Keeps the iteration from being optimised away
+    static volatile uint32_t sink;
+    sink = checksum;
+}
+
+static void resizeStorm(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    static const VkExtent2D sizes[] = { {800, 600}, {1024, 768}, {640, 480}, {1280, 720} };
+    const VkExtent2D& size = sizes[(frameIndex + 1) % (sizeof(sizes) / sizeof(VkExtent2D))];
+
+    resizeHeadless(app, size.width, size.height);
+}
+
+static void runDispatchChain(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)frameIndex;
+    (void)numElements;
+
+    runOperationChain(app, dispatchChain);
+}
+
+static void runDispatchDirect(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)frameIndex;
+    (void)numElements;
+
+    for(OperationIndex operationIndex : dispatchOperations) {
+        handleOperation(app, operationIndex);
+    }
+}
+
+// A translate and a rotation over both streams, alternating direction so the positions stay bounded
+static void runVertexKernels(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)app;
+
+    const uint32_t streamVertices = numElements / 2;
+    const float direction = (frameIndex % 2 == 0) ? 1.0f : -1.0f;
+    const float angle = 0.01f * direction;
+
+    const Affine2D rotation = { std::cos(angle), std::sin(angle), -std::sin(angle), std::cos(angle), 0.0f, 0.0f };
+
+    translateVertices(kernelPackedVertices.data(), streamVertices, sizeof(float) * 2, 0.001f * direction, 0.001f * direction);
+    translateVertices(kernelStridedVertices.data(), streamVertices, sizeof(Vertex), 0.001f * direction, 0.001f * direction);
+
+    transformVertices(kernelPackedVertices.data(), streamVertices, sizeof(float) * 2, rotation);
+    transformVertices(kernelStridedVertices.data(), streamVertices, sizeof(Vertex), rotation);
+}
+
+// Only the container changes, its children's world transforms are rewritten by the flush in loopLogic
+static void moveSubtree(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    (void)numElements;
+
+    const float direction = (frameIndex % 2 == 0) ? 1.0f : -1.0f;
+    app.entitySystem.transforms.translate(transformSubtreeRoot, 0.01f * direction, 0.01f * direction);
+}
+
+// Every few frames the image is replaced by the next one from buildImageResidency
+static void showNextImage(VulkanApplication& app, uint32_t frameIndex, uint32_t numElements)
+{
+    const uint32_t framesPerImage = 4;
+
+    if(numElements == 0 || frameIndex % framesPerImage != 0) {
+        return;
+    }
+
+    if(residencyEntity != ENTITY_INVALID) {
+        releaseEntity(app, residencyEntity);
+    }
+
+    NormFloat16 size;
+    size.set(0.5);
+
+    const uint32_t imageAsset = loadImage(app, residencyImagePaths[(frameIndex / framesPerImage) % numElements]);
+    residencyEntity = image(app, imageAsset, buttonPoint(0), size, size);
+}
+
+static void restoreVertexKernels(VulkanApplication& app)
+{
+    (void)app;
+
+    setVertexKernelTarget(bestVertexKernelTarget());
+
+    kernelPackedVertices = std::vector<float>();
+    kernelStridedVertices = std::vector<float>();
+}
+
+static void restoreInitialSize(VulkanApplication& app)
+{
+    resizeHeadless(app, vconfig::INITIAL_WINDOW_WIDTH, vconfig::INITIAL_WINDOW_HEIGHT);
+}
+
+// END Per frame actions
+
+static void removeResidencyImages(VulkanApplication& app)
+{
+    (void)app;
+
+    for(const std::string& path : residencyImagePaths) {
+        remove(path.c_str());
+    }
+
+    residencyImagePaths.clear();
+    residencyEntity = ENTITY_INVALID;
+}
+
+static uint64_t vertexBytesInUse(const VulkanApplication& app)
+{
+    uint64_t total = 0;
+
+    for(const VulkanApplicationPipeline& pipeline : app.pipelines) {
+        total += static_cast<uint64_t>(pipeline.numVertices) * pipeline.vertexStride;
+    }
+
+    return total;
+}
+
+static uint64_t indexBytesInUse(const VulkanApplication& app)
+{
+    uint64_t total = 0;
+
+    for(const VulkanApplicationPipeline& pipeline : app.pipelines) {
+        total += static_cast<uint64_t>(pipeline.numIndices) * sizeof(uint16_t);
+    }
+
+    return total;
+}
+
+static long peakResidentKiB()
+{
+#ifdef __linux__
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_maxrss;
+    }
+#endif
+
+    return -1;
+}
+
+static double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if(sorted.empty()) {
+        return 0.0;
+    }
+
+    const size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static ScenarioResult runScenario(const Scenario& scenario, uint32_t numWarmupFrames, uint32_t numFrames, std::string& outDeviceName)
+{
+    using Clock = std::chrono::steady_clock;
+
+    VulkanApplication app = setupApplication(true);
+    INSTRUMENT_INITIALIZE(app.device, app.physicalDevice, static_cast<uint32_t>(app.swapChainImages.size()));
+
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(app.physicalDevice, &deviceProperties);
+    outDeviceName = deviceProperties.deviceName;
+
+    prepareScene(app);
+
+    ScenarioResult result = {};
+    result.name = scenario.name;
+    result.requestedElements = scenario.params.numElements;
+    result.textLength = scenario.params.textLength;
+    result.numElements = scenario.build(app, scenario.params);
+
+    result.vertexBytes = vertexBytesInUse(app);
+    result.indexBytes = indexBytesInUse(app);
+    result.sceneUploadBytes = result.vertexBytes + result.indexBytes;
+
+    std::vector<double> frameTimesMs;
+    frameTimesMs.reserve(numFrames);
+
+    uint64_t bytesUploadedStart = 0;
+    uint32_t recordingsStart = 0;
+    uint64_t numFrameAllocations = 0;
+    double totalActionMs = 0.0;
+
+    for(uint32_t i = 0; i < numWarmupFrames + numFrames; i++)
+    {
+        if(i == numWarmupFrames) {
+            bytesUploadedStart = app.frameStats.bytesUploaded;
+            recordingsStart = app.frameStats.commandBufferRecordings;
+        }
+
+        INSTRUMENT_BEGIN_FRAME();
+
+        const Clock::time_point frameStart = Clock::now();
+
+        if(scenario.onFrame != nullptr)
+        {
+            scenario.onFrame(app, i, result.numElements);
+
+            if(i >= numWarmupFrames) {
+                totalActionMs += std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count();
+            }
+        }
+
+        const uint64_t allocationsStart = numHeapAllocations.load(std::memory_order_relaxed);
+
+        loopLogic(app, FIXED_FRAME_DELTA);
+        drawFrame(app);
+
+        if(i >= numWarmupFrames)
+        {
+            numFrameAllocations += numHeapAllocations.load(std::memory_order_relaxed) - allocationsStart;
+            frameTimesMs.push_back(std::chrono::duration<double, std::milli>(Clock::now() - frameStart).count());
+        }
+    }
+
+    // Nothing changes between frames of a scenario without a per frame action, so every frame after warmup should be
+    // served from memory reserved up front (See FrameArena)
+    if(scenario.onFrame == nullptr && numFrameAllocations != 0) {
+        printf("%s: %llu heap allocations over %u steady state frames\n", scenario.name, static_cast<unsigned long long>(numFrameAllocations), numFrames);
+        throw std::runtime_error("failed to render steady state frames without allocating!");
+    }
+
+    vkDeviceWaitIdle(app.device);
+
+    if(numFrames > 0)
+    {
+        result.bytesUploadedPerFrame = static_cast<double>(app.frameStats.bytesUploaded - bytesUploadedStart) / numFrames;
+        result.commandBufferRecordingsPerFrame = static_cast<double>(app.frameStats.commandBufferRecordings - recordingsStart) / numFrames;
+        result.heapAllocationsPerFrame = static_cast<double>(numFrameAllocations) / numFrames;
+    }
+
+    result.drawsPerFrame = app.frameStats.drawsPerFrame;
+
+    result.textureHits = app.images.stats.hits;
+    result.textureMisses = app.images.stats.misses;
+    result.textureEvictions = app.images.stats.evictions;
+    result.textureBytesResident = app.images.stats.bytesResident;
+
+    result.pipelineBuilds = app.pipelineVariants.numBuilds;
+    result.pipelineHits = app.pipelineVariants.numHits;
+
+    double totalMs = 0.0;
+
+    for(double frameTime : frameTimesMs) {
+        totalMs += frameTime;
+    }
+
+    std::sort(frameTimesMs.begin(), frameTimesMs.end());
+
+    result.frameMeanMs = (frameTimesMs.empty()) ? 0.0 : totalMs / frameTimesMs.size();
+    result.frameActionMeanMs = (frameTimesMs.empty()) ? 0.0 : totalActionMs / frameTimesMs.size();
+    result.frameP50Ms = percentile(frameTimesMs, 0.50);
+    result.frameP95Ms = percentile(frameTimesMs, 0.95);
+    result.frameP99Ms = percentile(frameTimesMs, 0.99);
+    result.frameMaxMs = (frameTimesMs.empty()) ? 0.0 : frameTimesMs.back();
+
+    if(scenario.teardown != nullptr) {
+        scenario.teardown(app);
+    }
+
+    INSTRUMENT_SHUTDOWN(app.device);
+    cleanup(app);
+
+    result.peakResidentKiB = peakResidentKiB();
+
+    return result;
+}
+
+static void writeJsonString(FILE * file, const std::string& value)
+{
+    fputc('"', file);
+
+    for(char c : value)
+    {
+        if(c == '"' || c == '\\') {
+            fputc('\\', file);
+        }
+
+        fputc(c, file);
+    }
+
+    fputc('"', file);
+}
+
+static bool writeResults(const char * path, const std::string& deviceName, uint32_t numWarmupFrames, uint32_t numFrames, const std::vector<ScenarioResult>& results)
+{
+    FILE * file = fopen(path, "w");
+
+    if(file == nullptr) {
+        printf("Failed to open '%s' for writing\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"version\": ");
+    writeJsonString(file, VKGUI_VERSION);
+    fprintf(file, ",\n  \"device\": ");
+    writeJsonString(file, deviceName);
+    fprintf(file, ",\n  \"warmupFrames\": %u,\n  \"frames\": %u,\n  \"frameDeltaMs\": %lld,\n  \"scenarios\": [\n",
+            numWarmupFrames, numFrames, static_cast<long long>(FIXED_FRAME_DELTA.count()));
+
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        const ScenarioResult& result = results[i];
+
+        fprintf(file, "    {\n      \"name\": ");
+        writeJsonString(file, result.name);
+        fprintf(file, ",\n");
+        fprintf(file, "      \"requestedElements\": %u,\n", result.requestedElements);
+        fprintf(file, "      \"elements\": %u,\n", result.numElements);
+        fprintf(file, "      \"textLength\": %u,\n", result.textLength);
+        fprintf(file, "      \"cpuFrameMs\": { \"mean\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+                result.frameMeanMs, result.frameP50Ms, result.frameP95Ms, result.frameP99Ms, result.frameMaxMs);
+        fprintf(file, "      \"frameActionMeanMs\": %.4f,\n", result.frameActionMeanMs);
+        fprintf(file, "      \"sceneUploadBytes\": %llu,\n", static_cast<unsigned long long>(result.sceneUploadBytes));
+        fprintf(file, "      \"bytesUploadedPerFrame\": %.1f,\n", result.bytesUploadedPerFrame);
+        fprintf(file, "      \"drawsPerFrame\": %u,\n", result.drawsPerFrame);
+        fprintf(file, "      \"commandBufferRecordingsPerFrame\": %.2f,\n", result.commandBufferRecordingsPerFrame);
+        fprintf(file, "      \"heapAllocationsPerFrame\": %.2f,\n", result.heapAllocationsPerFrame);
+        fprintf(file, "      \"textures\": { \"hits\": %llu, \"misses\": %llu, \"evictions\": %llu, \"bytesResident\": %llu },\n",
+                static_cast<unsigned long long>(result.textureHits), static_cast<unsigned long long>(result.textureMisses),
+                static_cast<unsigned long long>(result.textureEvictions), static_cast<unsigned long long>(result.textureBytesResident));
+        fprintf(file, "      \"pipelines\": { \"builds\": %u, \"hits\": %u },\n", result.pipelineBuilds, result.pipelineHits);
+        fprintf(file, "      \"memory\": { \"vertexBytes\": %llu, \"indexBytes\": %llu, \"peakResidentKiB\": %ld }\n",
+                static_cast<unsigned long long>(result.vertexBytes), static_cast<unsigned long long>(result.indexBytes), result.peakResidentKiB);
+        fprintf(file, "    }%s\n", (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+
+    return true;
+}
+
+// Run before any scenario, whichever are selected, so a build with broken arithmetic doesn't produce timings
+static bool runSelfChecks()
+{
+    if(! fixedPointMatchesReference()) {
+        printf("Fixed point arithmetic doesn't match the reference\n");
+        return false;
+    }
+
+    bool kernelsMatch = true;
+
+    for(uint8_t target = 0; target < static_cast<uint8_t>(VertexKernelTarget::SIZE) && kernelsMatch; target++)
+    {
+        if(setVertexKernelTarget(static_cast<VertexKernelTarget>(target))) {
+            kernelsMatch = vertexKernelsMatchReference();
+        }
+    }
+
+    setVertexKernelTarget(bestVertexKernelTarget());
+
+    if(! kernelsMatch) {
+        printf("Vertex kernels don't match the reference\n");
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char ** argv)
+{
+    uint32_t numFrames = 300;
+    uint32_t numWarmupFrames = 30;
+    const char * outputPath = "bench_results.json";
+    const char * scenarioFilter = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            numFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if(strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            numWarmupFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if(strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenarioFilter = argv[++i];
+        } else {
+            printf("Unknown argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if(! runSelfChecks()) {
+        return 1;
+    }
+
+    const Scenario scenarios[] = {
+        { "buttons_8",             { 8,       0  }, buildButtons,             nullptr,           nullptr },
+        { "buttons_max",           { 256,     0  }, buildButtons,             nullptr,           nullptr },
+        { "text_labels_64x8",      { 64,      8  }, buildTextLabels,          nullptr,           nullptr },
+        { "text_labels_8x64",      { 8,       64 }, buildTextLabels,          nullptr,           nullptr },
+        { "hover_sweep",           { 10,      0  }, buildHoverTargets,        sweepCursor,       nullptr },
+        { "cursor_storm",          { 10,      0  }, buildHoverTargets,        cursorStorm,       nullptr },
+        { "hover_grid_16384",      { 16384,   0  }, buildHoverGrid,           sweepCursor,       nullptr },
+        { "hover_round_16384",     { 16384,   0  }, buildRoundHoverGrid,      sweepCursor,       nullptr },
+        { "hover_buttons",         { 1024,    0  }, buildHoverButtons,        sweepCursor,       nullptr },
+        { "bounds_move_16384",     { 16384,   0  }, buildMovingBounds,        moveAllBounds,     nullptr },
+        { "per_frame_ops_256",     { 256,     0  }, buildPerFrameOperations,  nullptr,           nullptr },
+        { "per_frame_ops_1024",    { 1024,    0  }, buildPerFrameOperations,  nullptr,           nullptr },
+        { "per_frame_ops_4096",    { 4096,    0  }, buildPerFrameOperations,  nullptr,           nullptr },
+        { "animations_4096",       { 4096,    0  }, buildAnimations,          nullptr,           nullptr },
+        { "release_animating_64",  { 64,      0  }, buildReleasingAnimations, releaseAnimating,  nullptr },
+        { "entity_churn_262144",   { 262144,  0  }, buildEntities,            entityChurn,       nullptr },
+        { "dispatch_chain_4096",   { 4096,    0  }, buildDispatchOperations,  runDispatchChain,  nullptr },
+        { "dispatch_direct_4096",  { 4096,    0  }, buildDispatchOperations,  runDispatchDirect, nullptr },
+        { "resize_storm",          { 8,       0  }, buildButtons,             resizeStorm,       restoreInitialSize },
+        { "vertex_kernels_scalar", { 1048576, 0  }, buildScalarVertexKernels, runVertexKernels,  restoreVertexKernels },
+        { "vertex_kernels_simd",   { 1048576, 0  }, buildSimdVertexKernels,   runVertexKernels,  restoreVertexKernels },
+        { "transform_subtree_256", { 256,     0  }, buildTransformSubtree,    moveSubtree,       nullptr },
+        { "text_updates_256",      { 256,     0  }, buildLabels,              updateLabels,      nullptr },
+        { "layout_10000",          { 10000,   0  }, buildLayout,              resizeLayoutLeaf,  nullptr },
+        { "image_residency_16",    { 16,      0  }, buildImageResidency,      showNextImage,     removeResidencyImages }
+    };
+
+    std::vector<ScenarioResult> results;
+    std::string deviceName;
+
+    for(const Scenario& scenario : scenarios)
+    {
+        if(scenarioFilter != nullptr && strcmp(scenarioFilter, scenario.name) != 0) {
+            continue;
+        }
+
+        ScenarioResult result = runScenario(scenario, numWarmupFrames, numFrames, deviceName);
+
+        printf("%-22s elements %4u / %-4u mean %8.3fms p99 %8.3fms action %8.3fms uploaded %10.1f B/frame draws %u allocs %.2f/frame\n",
+               result.name.c_str(), result.numElements, result.requestedElements,
+               result.frameMeanMs, result.frameP99Ms, result.frameActionMeanMs, result.bytesUploadedPerFrame, result.drawsPerFrame,
+               result.heapAllocationsPerFrame);
+
+        results.push_back(result);
+    }
+
+    if(results.empty()) {
+        printf("No scenario named '%s'\n", scenarioFilter);
+        return 1;
+    }
+
+    if(! writeResults(outputPath, deviceName, numWarmupFrames, numFrames, results)) {
+        return 1;
+    }
+
+    printf("Wrote results to '%s'\n", outputPath);
+
+    return 0;
+}
@@ -1,3 +0,0 @@
-glslangValidator -V image.vert -o vert.spv
-glslangValidator -V image.frag -o frag.spv
-echo 'Done'
@@ -1,22 +0,0 @@
-
-#version 450
-#extension GL_ARB_separate_shader_objects : enable
-
-layout(location = 0) in vec2 inPosition;
-layout(location = 1) in vec3 inColor;
-layout(location = 2) in vec2 inTexCoord;
-
-layout(location = 0) out vec4 fragColor;
-layout(location = 1) out vec2 fragTexCoord;
-
-void main() {
-
-    gl_Position =  vec4(inPosition, 0.0, 1.0);
-
-    fragColor = vec4(inColor, 1.0f);
-
-    fragTexCoord = inTexCoord;
-}
-
-
-
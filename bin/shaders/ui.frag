@@ -0,0 +1,41 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Shared by every pipeline, specialised through the constant below (See shadervariants.h). Built twice by CMakeLists.txt,
+// with and without BINDLESS, as a specialization constant can't remove the capabilities a runtime array needs
+
+#ifdef BINDLESS
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Every texture in the texture table. The index can differ between primitives of one draw, hence nonuniformEXT
+layout(set = 1, binding = 0) uniform sampler2D textures[];
+#else
+// Without descriptor indexing the texture table has a single slot, so the texture index is ignored
+layout(set = 1, binding = 0) uniform sampler2D texSampler;
+#endif
+
+layout(constant_id = 0) const bool TEXTURED = false;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+layout(location = 2) flat in uint fragTextureIndex;
+
+layout(location = 0) out vec4 outColor;
+
+vec4 sampleTexture() {
+#ifdef BINDLESS
+    return texture(textures[nonuniformEXT(fragTextureIndex)], fragTexCoord);
+#else
+    return texture(texSampler, fragTexCoord);
+#endif
+}
+
+void main() {
+
+    if(! TEXTURED) {
+        outColor = fragColor;
+        return;
+    }
+
+    outColor = sampleTexture();
+}
@@ -0,0 +1,37 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// Shared by every pipeline (See shadervariants.h). Vertices that aren't textured feed texCoord and textureIndex from
+// other members, untextured variants never read them
+
+struct Transform {
+    vec4 linear;        // a b c d
+    vec4 translation;   // tx ty
+};
+
+layout(std430, binding = 1) readonly buffer Transforms {
+    Transform transforms[];
+};
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in uint inTransformIndex;
+layout(location = 4) in uint inTextureIndex;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+layout(location = 2) flat out uint fragTextureIndex;
+
+void main() {
+
+    Transform transform = transforms[inTransformIndex];
+    vec2 position = transform.linear.xy * inPosition.x + transform.linear.zw * inPosition.y + transform.translation.xy;
+
+    gl_Position = vec4(position, 0.0, 1.0);
+
+    fragColor = vec4(inColor, 1.0f);
+
+    fragTexCoord = inTexCoord;
+    fragTextureIndex = inTextureIndex;
+}
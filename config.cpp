@@ -7,6 +7,28 @@ namespace vconfig {
     const uint16_t INITIAL_WINDOW_WIDTH = 800;
     const bool ENABLE_DEBUG_LAYERS = true;
     const uint32_t PIPELINE_MEMORY_SIZE = 65536 * 2;
+    const double IDLE_EVENT_WAIT_TIMEOUT_SECONDS = 0.5;
+    const uint16_t FALLBACK_REFRESH_RATE = 60;
+    const char * INSTRUMENTATION_OUTPUT_PATH = "frame_timings.json";
+    const char * TRACE_OUTPUT_PATH = "trace.json";
+    const uint32_t HEADLESS_IMAGE_COUNT = 3;
+    const uint32_t DEFAULT_HEADLESS_FRAMES = 100;
+    const uint8_t GOLDEN_IMAGE_TOLERANCE = 8;               // Per channel, drivers can rasterize edges differently
+    const uint32_t GOLDEN_IMAGE_MAX_DIFFERENT_PIXELS = 64;
+    const uint32_t MAX_PER_FRAME_OPERATIONS = 4096;
+    const uint32_t MAX_ANIMATIONS = 4096;
+    const uint32_t MAX_TRANSFORMS = 4096;
+    const uint32_t MAX_LAYOUT_NODES = 16384;
+    const uint32_t MAX_CACHED_MESHES = 1024;
+    const uint32_t FRAME_ARENA_SIZE = 64 * 1024;
+    const bool ENABLE_DESCRIPTOR_INDEXING = true;
+    const uint32_t MAX_TEXTURES = 4096;
+    const uint32_t IMAGE_DECODE_THREADS = 2;
+    const uint32_t IMAGE_STAGING_SIZE = 16 * 1024 * 1024;
+    const uint32_t IMAGE_ATLAS_SIZE = 1024;
+    const uint32_t MAX_ATLAS_IMAGE_SIZE = 64;
+    const uint32_t TEXTURE_MEMORY_BUDGET = 256 * 1024 * 1024;
+    const uint32_t IMAGE_CPU_CACHE_SIZE = 64 * 1024 * 1024;
 }
 
 //    const std::string FONT_PATH = "/usr/share/fonts/TTF/DejaVuSans.ttf";
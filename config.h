@@ -10,6 +10,28 @@ namespace vconfig {
     extern const uint16_t INITIAL_WINDOW_WIDTH;
     extern const bool ENABLE_DEBUG_LAYERS;
     extern const uint32_t PIPELINE_MEMORY_SIZE;
+    extern const double IDLE_EVENT_WAIT_TIMEOUT_SECONDS;
+    extern const uint16_t FALLBACK_REFRESH_RATE;
+    extern const char * INSTRUMENTATION_OUTPUT_PATH;
+    extern const char * TRACE_OUTPUT_PATH;
+    extern const uint32_t HEADLESS_IMAGE_COUNT;
+    extern const uint32_t DEFAULT_HEADLESS_FRAMES;
+    extern const uint8_t GOLDEN_IMAGE_TOLERANCE;
+    extern const uint32_t GOLDEN_IMAGE_MAX_DIFFERENT_PIXELS;
+    extern const uint32_t MAX_PER_FRAME_OPERATIONS;
+    extern const uint32_t MAX_ANIMATIONS;
+    extern const uint32_t MAX_TRANSFORMS;
+    extern const uint32_t MAX_LAYOUT_NODES;
+    extern const uint32_t MAX_CACHED_MESHES;
+    extern const uint32_t FRAME_ARENA_SIZE;
+    extern const bool ENABLE_DESCRIPTOR_INDEXING;
+    extern const uint32_t MAX_TEXTURES;
+    extern const uint32_t IMAGE_DECODE_THREADS;
+    extern const uint32_t IMAGE_STAGING_SIZE;
+    extern const uint32_t IMAGE_ATLAS_SIZE;
+    extern const uint32_t MAX_ATLAS_IMAGE_SIZE;
+    extern const uint32_t TEXTURE_MEMORY_BUDGET;
+    extern const uint32_t IMAGE_CPU_CACHE_SIZE;
 }
 
 
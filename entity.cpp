@@ -1,3 +1,92 @@
 #include "entity.h"
 
+#include <stdexcept>
 
+static inline uint32_t countTrailingZeros(uint64_t value)
+{
+    assert(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#else
+    uint32_t count = 0;
+
+    while(! (value & 1)) {
+        value >>= 1;
+        count++;
+    }
+
+    return count;
+#endif
+}
+
+Entity32 requestEntity(EntitySystemHandle& handle)
+{
+    const uint32_t numWords = static_cast<uint32_t>(handle.freeSlots.size());
+
+    uint32_t word = handle.firstFreeWord;
+
+    while(word < numWords && handle.freeSlots[word] == 0) {
+        word++;
+    }
+
+    if(word == numWords)
+    {
+        if(handle.generations.size() >= EntitySystemHandle::MAX_ENTITIES) {
+            throw std::runtime_error("failed to create entity, limit reached!");
+        }
+
+        handle.freeSlots.push_back(UINT64_MAX);
+        handle.generations.resize(handle.generations.size() + 64, 0);
+    }
+
+    handle.firstFreeWord = word;
+
+    const uint32_t bit = countTrailingZeros(handle.freeSlots[word]);
+    handle.freeSlots[word] &= ~(uint64_t(1) << bit);
+    handle.numEntities++;
+
+    const uint32_t index = word * 64 + bit;
+    return entity::make(index, handle.generations[index]);
+}
+
+void releaseEntity(EntitySystemHandle& handle, Entity32 entity)
+{
+    if(! handle.isAlive(entity)) {
+        return;
+    }
+
+    const uint32_t index = entity::indexOf(entity);
+
+    handle.verticesComponent.remove(index);
+    handle.colorComponent.remove(index);
+    handle.boundsComponent.remove(index);
+    handle.animationComponent.remove(index);
+
+    if(handle.transformComponent.contains(index)) {
+        handle.transforms.release(handle.transformComponent.at(index));
+        handle.transformComponent.remove(index);
+    }
+
+    if(handle.meshComponent.contains(index)) {
+        handle.meshes.release(handle.meshComponent.at(index).mesh);
+        handle.meshComponent.remove(index);
+    }
+
+    // The layout node is left to whoever created it, it no longer has an owner that's alive
+    if(handle.layoutComponent.contains(index)) {
+        handle.transforms.release(handle.layoutComponent.at(index).transformNode);
+        handle.layoutComponent.remove(index);
+    }
+
+    // Any handle still pointing at this slot is now stale
+    handle.generations[index] = static_cast<uint16_t>((handle.generations[index] + 1) & ENTITY_GENERATION_MASK);
+
+    const uint32_t word = index / 64;
+    handle.freeSlots[word] |= uint64_t(1) << (index % 64);
+    handle.numEntities--;
+
+    if(word < handle.firstFreeWord) {
+        handle.firstFreeWord = word;
+    }
+}
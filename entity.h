@@ -2,9 +2,58 @@
 #define ENTITY_H
 
 #include <stdint.h>
+#include <cassert>
+#include <vector>
 
+#include "transform.h"
+#include "meshcache.h"
+
+// Entities are generational indices. The lower ENTITY_INDEX_BITS are a slot in the entity system and the rest count
+// how many times that slot has been reused, so a handle to a released entity can be told apart from its replacement
 typedef uint32_t Entity32;
 
+// Compact form of an Entity32 stored inside operations, where there is only room for 16 bits. Keeps the lower
+// ENTITY16_INDEX_BITS of the index and the lowest bits of the generation, so only the first 4096 slots can be referenced
+typedef uint16_t Entity16;
+
+#define ENTITY_INDEX_BITS 20
+#define ENTITY_INDEX_MASK ((1u << ENTITY_INDEX_BITS) - 1)
+#define ENTITY_GENERATION_MASK ((1u << (32 - ENTITY_INDEX_BITS)) - 1)
+#define ENTITY_INVALID UINT32_MAX
+
+#define ENTITY16_INDEX_BITS 12
+#define ENTITY16_INDEX_MASK ((1u << ENTITY16_INDEX_BITS) - 1)
+#define ENTITY16_GENERATION_MASK ((1u << (16 - ENTITY16_INDEX_BITS)) - 1)
+
+namespace entity
+{
+    inline uint32_t indexOf(Entity32 entity) {
+        return entity & ENTITY_INDEX_MASK;
+    }
+
+    inline uint32_t generationOf(Entity32 entity) {
+        return entity >> ENTITY_INDEX_BITS;
+    }
+
+    inline Entity32 make(uint32_t index, uint32_t generation) {
+        return ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+    }
+
+    inline uint32_t indexOf16(Entity16 entity) {
+        return entity & ENTITY16_INDEX_MASK;
+    }
+
+    inline uint32_t generationOf16(Entity16 entity) {
+        return static_cast<uint32_t>(entity) >> ENTITY16_INDEX_BITS;
+    }
+
+    inline Entity16 toEntity16(Entity32 entity)
+    {
+        assert(indexOf(entity) <= ENTITY16_INDEX_MASK && "Entity index is too large for an Entity16");
+        return static_cast<Entity16>(((generationOf(entity) & ENTITY16_GENERATION_MASK) << ENTITY16_INDEX_BITS) | indexOf(entity));
+    }
+}
+
 // NOTE: Assume reordering Entities is cheap, always try and do this instead of moving actual data
 
 struct RelativeDataLocation
@@ -15,22 +64,169 @@ struct RelativeDataLocation
                             // Or even, to reduce by half
 };
 
+// Where an entity is placed by a node in the application's LayoutTree (See bindLayout). The entity's mesh has its top
+// left at origin, and the layout moves it by changing transformNode, which is the parent of the entity's own transform
+// so moves and animations still apply on top of it
+struct LayoutAnchor
+{
+    uint32_t layoutNode;
+    uint32_t transformNode;
+    int32_t originX;
+    int32_t originY;
+};
+
+// The cached mesh an entity's vertices were copied from. indicesOffsetBytes is where its indices were written,
+// from the start of the mapped index memory
+struct MeshBinding
+{
+    uint32_t mesh;
+    uint32_t indicesOffsetBytes;
+};
+
+struct EntityColor
+{
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+    uint8_t a;
+};
+
+// Sparse set of components keyed by entity index. Values are packed into `dense` so iterating a component touches only
+// entities that have it. Removal moves the last value into the hole, so order isn't preserved
+template <typename T>
+struct ComponentArray
+{
+    static const constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+    std::vector<T> dense;
+    std::vector<uint32_t> denseEntities;    // Entity index of each value in `dense`
+    std::vector<uint32_t> sparse;           // Entity index -> slot in `dense`
 
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(dense.size());
+    }
+
+    inline bool contains(uint32_t entityIndex) const {
+        return entityIndex < sparse.size() && sparse[entityIndex] != INVALID_SLOT;
+    }
+
+    inline T& at(uint32_t entityIndex) {
+        assert(contains(entityIndex) && "Entity doesn't have this component");
+        return dense[sparse[entityIndex]];
+    }
+
+    inline const T& at(uint32_t entityIndex) const {
+        assert(contains(entityIndex) && "Entity doesn't have this component");
+        return dense[sparse[entityIndex]];
+    }
+
+    // Replaces the value if the entity already has one
+    void set(uint32_t entityIndex, const T& value)
+    {
+        if(contains(entityIndex)) {
+            dense[sparse[entityIndex]] = value;
+            return;
+        }
+
+        if(entityIndex >= sparse.size()) {
+            sparse.resize(entityIndex + 1, INVALID_SLOT);
+        }
+
+        sparse[entityIndex] = static_cast<uint32_t>(dense.size());
+        dense.push_back(value);
+        denseEntities.push_back(entityIndex);
+    }
+
+    void remove(uint32_t entityIndex)
+    {
+        if(! contains(entityIndex)) {
+            return;
+        }
+
+        const uint32_t slot = sparse[entityIndex];
+        const uint32_t movedEntity = denseEntities.back();
+
+        dense[slot] = dense.back();
+        denseEntities[slot] = movedEntity;
+        sparse[movedEntity] = slot;
+
+        dense.pop_back();
+        denseEntities.pop_back();
+        sparse[entityIndex] = INVALID_SLOT;
+    }
+
+    void clear()
+    {
+        dense.clear();
+        denseEntities.clear();
+        sparse.clear();
+    }
+};
 
 struct EntitySystemHandle
 {
-    Entity32 nextEntity = 0;
-    uint64_t unusedEntities[5]; // = 5 * 64
+    static const constexpr uint32_t MAX_ENTITIES = 1u << ENTITY_INDEX_BITS;
+
+    // One bit per slot, set while the slot is free. Grows 64 slots at a time
+    std::vector<uint64_t> freeSlots;
+    std::vector<uint16_t> generations;
+    uint32_t firstFreeWord = 0; // No free slots before this word
+    uint32_t numEntities = 0;
 
     uint8_t * verticesComponentBasePtr;
-    uint32_t numberVerticesComponents;
-    RelativeDataLocation verticesComponent[30];
+
+    ComponentArray<RelativeDataLocation> verticesComponent;
+    ComponentArray<EntityColor> colorComponent;     // Set by button and drawText
+    ComponentArray<uint16_t> boundsComponent;       // Index into OnMouseEventOpBindings::bounds (See bindBounds)
+    ComponentArray<uint16_t> animationComponent;    // OperationIndex of the AnimatedMoveOperation moving the entity
+    ComponentArray<uint32_t> transformComponent;    // Node in `transforms` that the entity's vertices reference
+    ComponentArray<LayoutAnchor> layoutComponent;
+    ComponentArray<MeshBinding> meshComponent;
+
+    TransformHierarchy transforms;
+    MeshCache meshes;
 
     uint16_t exampleTimeUpdateListSize = 0;
     Entity32 exampleTimeUpdateList[10];
+
+    inline bool isAlive(Entity32 entity) const
+    {
+        const uint32_t index = entity::indexOf(entity);
+        return isOccupied(index) && generations[index] == entity::generationOf(entity);
+    }
+
+    // Only the lowest generation bits are compared, so a slot reused a multiple of 16 times isn't detected
+    inline bool isAlive(Entity16 entity) const
+    {
+        const uint32_t index = entity::indexOf16(entity);
+        return isOccupied(index) && (generations[index] & ENTITY16_GENERATION_MASK) == entity::generationOf16(entity);
+    }
+
+    // Index to use with the component arrays. Stale and out of range handles are caught here in debug builds,
+    // in release builds this is only the index mask
+    inline uint32_t resolve(Entity32 entity) const
+    {
+        assert(isAlive(entity) && "Stale or invalid Entity32");
+        return entity::indexOf(entity);
+    }
+
+    inline uint32_t resolve(Entity16 entity) const
+    {
+        assert(isAlive(entity) && "Stale or invalid Entity16");
+        return entity::indexOf16(entity);
+    }
+
+private:
+
+    inline bool isOccupied(uint32_t index) const {
+        return index < generations.size() && !(freeSlots[index / 64] & (uint64_t(1) << (index % 64)));
+    }
 };
 
-//Entity32 requestEntity(EntitySystemHandle& handle);
-//void releaseEntity(EntitySystemHandle& handle, Entity32 entity);
+// Throws if MAX_ENTITIES are alive
+Entity32 requestEntity(EntitySystemHandle& handle);
+
+// Also removes every component of the entity. Releasing a stale handle does nothing
+void releaseEntity(EntitySystemHandle& handle, Entity32 entity);
 
 #endif // ENTITY_H
@@ -0,0 +1,115 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <stdint.h>
+
+// Fixed point arithmetic for layout, bounds and hit testing. Values are integers in 1/10000ths of a normalized device
+// unit, so NORMFLOAT_MAX is 1.0 and NORMFLOAT_MIN is -1.0, and are stored in 16 bits (See NormFloat16 / SNormFloat16).
+// Everything here stays in integers. Results that don't fit the storage type are clamped to it rather than wrapping,
+// so a bounds moved past the edge of the screen stays past it instead of reappearing on the other side
+
+#define NORMFLOAT_MAX   10000
+#define NORMFLOAT_MIN  -10000
+
+// Rect in fixed16 units. Edges are inclusive
+struct FixedRect
+{
+    int32_t left;
+    int32_t top;
+    int32_t right;
+    int32_t bottom;
+
+    inline bool contains(int32_t x, int32_t y) const {
+        return x >= left && x <= right && y >= top && y <= bottom;
+    }
+};
+
+namespace fixed16
+{
+    static const constexpr int32_t ONE = NORMFLOAT_MAX;
+
+    constexpr int16_t saturate(int32_t value) {
+        return (value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : static_cast<int16_t>(value);
+    }
+
+    constexpr uint16_t saturateUnsigned(int32_t value) {
+        return (value > UINT16_MAX) ? UINT16_MAX : (value < 0) ? 0 : static_cast<uint16_t>(value);
+    }
+
+    // Rounds to nearest, halves away from zero. denominator must be positive
+    constexpr int64_t divideRounded(int64_t numerator, int64_t denominator) {
+        return (numerator >= 0) ? (numerator + denominator / 2) / denominator : -((-numerator + denominator / 2) / denominator);
+    }
+
+    constexpr int16_t add(int16_t a, int16_t b) {
+        return saturate(static_cast<int32_t>(a) + b);
+    }
+
+    constexpr int16_t add(int16_t a, uint16_t b) {
+        return saturate(static_cast<int32_t>(a) + b);
+    }
+
+    constexpr uint16_t add(uint16_t a, uint16_t b) {
+        return saturateUnsigned(static_cast<int32_t>(a) + b);
+    }
+
+    constexpr int16_t subtract(int16_t a, int16_t b) {
+        return saturate(static_cast<int32_t>(a) - b);
+    }
+
+    // E.g. mul(5000, 5000) == 2500 (0.5 * 0.5 == 0.25)
+    constexpr int16_t mul(int16_t a, int16_t b) {
+        return saturate(static_cast<int32_t>(divideRounded(static_cast<int32_t>(a) * b, ONE)));
+    }
+
+    // -1, 0 or 1
+    constexpr int32_t compare(int32_t a, int32_t b) {
+        return (a > b) - (a < b);
+    }
+
+    // Pixel 0 maps to NORMFLOAT_MIN and extentPixels to NORMFLOAT_MAX. For extents of up to 2 * ONE pixels,
+    // toPixels(fromPixels(pixel, extent), extent) == pixel for every pixel in [0, extent]
+    constexpr int32_t fromPixels(int32_t pixel, uint16_t extentPixels) {
+        return static_cast<int32_t>(divideRounded(static_cast<int64_t>(pixel) * 2 * ONE, extentPixels)) - ONE;
+    }
+
+    // Not clamped to [0, extentPixels], values outside of [-1, 1] are off screen
+    constexpr int32_t toPixels(int32_t value, uint16_t extentPixels) {
+        return static_cast<int32_t>(divideRounded((static_cast<int64_t>(value) + ONE) * extentPixels, 2 * ONE));
+    }
+
+    // Only for values written by hand or read from config, nothing per frame should need these
+    constexpr int16_t fromDouble(double value)
+    {
+        const double scaled = value * ONE;
+        return (scaled >= INT16_MAX) ? INT16_MAX : (scaled <= INT16_MIN) ? INT16_MIN
+                                     : static_cast<int16_t>((scaled >= 0.0) ? scaled + 0.5 : scaled - 0.5);
+    }
+
+    constexpr uint16_t fromDoubleUnsigned(double value)
+    {
+        const double scaled = value * ONE;
+        return (scaled >= UINT16_MAX) ? UINT16_MAX : (scaled <= 0.0) ? 0 : static_cast<uint16_t>(scaled + 0.5);
+    }
+
+    constexpr double toDouble(int32_t value) {
+        return value / static_cast<double>(ONE);
+    }
+
+    // For writing vertex positions
+    constexpr float toFloat(int32_t value) {
+        return static_cast<float>(value) / static_cast<float>(ONE);
+    }
+}
+
+static_assert(fixed16::add(int16_t(NORMFLOAT_MAX), int16_t(NORMFLOAT_MAX)) == 2 * NORMFLOAT_MAX);
+static_assert(fixed16::add(int16_t(INT16_MAX), int16_t(1)) == INT16_MAX);
+static_assert(fixed16::add(int16_t(INT16_MIN), int16_t(-1)) == INT16_MIN);
+static_assert(fixed16::add(uint16_t(UINT16_MAX), uint16_t(1)) == UINT16_MAX);
+static_assert(fixed16::mul(int16_t(NORMFLOAT_MIN), int16_t(NORMFLOAT_MIN)) == NORMFLOAT_MAX);
+static_assert(fixed16::mul(int16_t(5000), int16_t(-5000)) == -2500);
+static_assert(fixed16::fromPixels(0, 800) == NORMFLOAT_MIN && fixed16::fromPixels(800, 800) == NORMFLOAT_MAX);
+static_assert(fixed16::toPixels(NORMFLOAT_MIN, 600) == 0 && fixed16::toPixels(NORMFLOAT_MAX, 600) == 600);
+static_assert(fixed16::fromDouble(0.07) == 700 && fixed16::fromDouble(-0.9) == -9000);
+
+#endif // FIXEDPOINT_H
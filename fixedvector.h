@@ -0,0 +1,91 @@
+#ifndef FIXEDVECTOR_H
+#define FIXEDVECTOR_H
+
+#include <stdint.h>
+#include <cassert>
+#include <initializer_list>
+
+// Vector with its storage inline, for small temporaries whose upper bound is known. E.g. vertex attributes or
+// descriptor bindings, which would otherwise be a heap allocation every time a pipeline is created or recreated.
+// Going over Capacity is a programming error
+
+template <typename T, uint32_t Capacity>
+struct FixedVector
+{
+    static_assert(Capacity > 0);
+
+    T elements[Capacity];
+    uint32_t count = 0;
+
+    FixedVector() = default;
+
+    FixedVector(std::initializer_list<T> values)
+    {
+        assert(values.size() <= Capacity);
+
+        for(const T& value : values) {
+            elements[count++] = value;
+        }
+    }
+
+    inline void push_back(const T& value)
+    {
+        assert(count < Capacity && "FixedVector is full");
+        elements[count++] = value;
+    }
+
+    inline void pop_back()
+    {
+        assert(count > 0);
+        count--;
+    }
+
+    inline void resize(uint32_t newCount)
+    {
+        assert(newCount <= Capacity);
+
+        for(uint32_t i = count; i < newCount; i++) {
+            elements[i] = T();
+        }
+
+        count = newCount;
+    }
+
+    inline void clear() {
+        count = 0;
+    }
+
+    inline T& operator[](uint32_t index)
+    {
+        assert(index < count);
+        return elements[index];
+    }
+
+    inline const T& operator[](uint32_t index) const
+    {
+        assert(index < count);
+        return elements[index];
+    }
+
+    inline T& back()
+    {
+        assert(count > 0);
+        return elements[count - 1];
+    }
+
+    inline T * data() { return elements; }
+    inline const T * data() const { return elements; }
+
+    inline T * begin() { return elements; }
+    inline T * end() { return elements + count; }
+    inline const T * begin() const { return elements; }
+    inline const T * end() const { return elements + count; }
+
+    inline uint32_t size() const { return count; }
+    inline bool empty() const { return count == 0; }
+    inline bool full() const { return count == Capacity; }
+
+    static constexpr uint32_t capacity() { return Capacity; }
+};
+
+#endif // FIXEDVECTOR_H
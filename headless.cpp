@@ -0,0 +1,318 @@
+#include "headless.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#include "vulkanhelper.h"
+#include "stb_image.h"
+
+void createOffscreenImages(VulkanApplication& app, uint32_t width, uint32_t height, uint32_t imageCount)
+{
+    app.swapChainExtent = { width, height };
+    app.swapChainImages.resize(imageCount);
+    app.offscreenImageMemory.resize(imageCount);
+    app.swapChainImageViews.resize(imageCount);
+
+    for(uint32_t i = 0; i < imageCount; i++)
+    {
+        createImage(    app.device,
+                        app.physicalDevice,
+                        width,
+                        height,
+                        app.swapChainImageFormat,
+                        VK_IMAGE_TILING_OPTIMAL,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                        app.swapChainImages[i],
+                        app.offscreenImageMemory[i] );
+
+        createImageView(app.device, app.swapChainImages[i], app.swapChainImageFormat, app.swapChainImageViews[i]);
+    }
+
+    app.nextOffscreenImage = 0;
+}
+
+void destroyOffscreenImages(VulkanApplication& app)
+{
+    for(size_t i = 0; i < app.swapChainImages.size(); i++)
+    {
+        vkDestroyImage(app.device, app.swapChainImages[i], nullptr);
+        vkFreeMemory(app.device, app.offscreenImageMemory[i], nullptr);
+    }
+
+    app.swapChainImages.clear();
+    app.offscreenImageMemory.clear();
+}
+
+uint32_t acquireOffscreenImage(VulkanApplication& app)
+{
+    const uint32_t imageIndex = app.nextOffscreenImage;
+    app.nextOffscreenImage = (app.nextOffscreenImage + 1) % static_cast<uint32_t>(app.swapChainImages.size());
+
+    return imageIndex;
+}
+
+void readbackOffscreenImage(VulkanApplication& app, uint32_t imageIndex, std::vector<uint8_t>& outPixelsRGBA)
+{
+    TRACE_FUNCTION();
+
+    assert(imageIndex < app.swapChainImages.size());
+
+    const uint32_t width = app.swapChainExtent.width;
+    const uint32_t height = app.swapChainExtent.height;
+    const VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * 4;
+
+    VkBuffer stagingBuffer;
+    VkDeviceMemory stagingBufferMemory;
+
+    createBuffer(   app.device,
+                    app.physicalDevice,
+                    imageSize,
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    stagingBuffer,
+                    stagingBufferMemory );
+
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(app.device, app.commandPool);
+
+    // The render pass has already left the image in TRANSFER_SRC_OPTIMAL, this only orders the copy after its writes
+    VkImageMemoryBarrier renderedBarrier = {};
+    renderedBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    renderedBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    renderedBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    renderedBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    renderedBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    renderedBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    renderedBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    renderedBarrier.image = app.swapChainImages[imageIndex];
+    renderedBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    renderedBarrier.subresourceRange.baseMipLevel = 0;
+    renderedBarrier.subresourceRange.levelCount = 1;
+    renderedBarrier.subresourceRange.baseArrayLayer = 0;
+    renderedBarrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(   commandBuffer,
+                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            0,
+                            0, nullptr,
+                            0, nullptr,
+                            1, &renderedBarrier );
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = {0, 0, 0};
+    region.imageExtent = { width, height, 1 };
+
+    vkCmdCopyImageToBuffer(commandBuffer, app.swapChainImages[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer, 1, &region);
+
+    // Makes the copy visible to the map below
+    VkBufferMemoryBarrier copiedBarrier = {};
+    copiedBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    copiedBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    copiedBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    copiedBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    copiedBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    copiedBarrier.buffer = stagingBuffer;
+    copiedBarrier.offset = 0;
+    copiedBarrier.size = VK_WHOLE_SIZE;
+
+    vkCmdPipelineBarrier(   commandBuffer,
+                            VK_PIPELINE_STAGE_TRANSFER_BIT,
+                            VK_PIPELINE_STAGE_HOST_BIT,
+                            0,
+                            0, nullptr,
+                            1, &copiedBarrier,
+                            0, nullptr );
+
+    endSingleTimeCommands(app.device, app.commandPool, app.graphicsQueue, commandBuffer);
+
+    void * mappedMemory;
+    vkMapMemory(app.device, stagingBufferMemory, 0, imageSize, 0, &mappedMemory);
+
+    outPixelsRGBA.resize(imageSize);
+    memcpy(outPixelsRGBA.data(), mappedMemory, imageSize);
+
+    vkUnmapMemory(app.device, stagingBufferMemory);
+
+    vkDestroyBuffer(app.device, stagingBuffer, nullptr);
+    vkFreeMemory(app.device, stagingBufferMemory, nullptr);
+
+    if(app.swapChainImageFormat == VK_FORMAT_B8G8R8A8_UNORM)
+    {
+        for(size_t i = 0; i < outPixelsRGBA.size(); i += 4) {
+            std::swap(outPixelsRGBA[i], outPixelsRGBA[i + 2]);
+        }
+    }
+}
+
+static uint32_t crc32(const uint8_t * data, size_t length, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool tableInitialized = false;
+
+    if(! tableInitialized)
+    {
+        for(uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t value = i;
+
+            for(uint8_t bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+
+            table[i] = value;
+        }
+
+        tableInitialized = true;
+    }
+
+    crc = ~crc;
+
+    for(size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+
+    return ~crc;
+}
+
+static void appendBigEndian32(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static void appendChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data)
+{
+    appendBigEndian32(out, static_cast<uint32_t>(data.size()));
+
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    appendBigEndian32(out, crc32(out.data() + typeOffset, data.size() + 4));
+}
+
+bool writePNG(const char * path, const uint8_t * pixelsRGBA, uint32_t width, uint32_t height)
+{
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+
+    // Each scanline is prefixed with a filter type byte (0 = None)
+    std::vector<uint8_t> scanlines;
+    scanlines.reserve((rowSize + 1) * height);
+
+    for(uint32_t y = 0; y < height; y++) {
+        scanlines.push_back(0);
+        scanlines.insert(scanlines.end(), pixelsRGBA + (y * rowSize), pixelsRGBA + ((y + 1) * rowSize));
+    }
+
+    // zlib stream made of stored (Uncompressed) deflate blocks
+    std::vector<uint8_t> zlibData;
+    zlibData.reserve(scanlines.size() + (scanlines.size() / 65535 + 1) * 5 + 6);
+    zlibData.push_back(0x78);
+    zlibData.push_back(0x01);
+
+    size_t offset = 0;
+
+    do {
+        const uint16_t blockSize = static_cast<uint16_t>(std::min<size_t>(65535, scanlines.size() - offset));
+        const bool isFinalBlock = (offset + blockSize == scanlines.size());
+
+        zlibData.push_back(isFinalBlock ? 1 : 0);
+        zlibData.push_back(static_cast<uint8_t>(blockSize));
+        zlibData.push_back(static_cast<uint8_t>(blockSize >> 8));
+        zlibData.push_back(static_cast<uint8_t>(~blockSize));
+        zlibData.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        zlibData.insert(zlibData.end(), scanlines.begin() + offset, scanlines.begin() + offset + blockSize);
+
+        offset += blockSize;
+    } while(offset < scanlines.size());
+
+    uint32_t adlerA = 1;
+    uint32_t adlerB = 0;
+
+    for(uint8_t byte : scanlines) {
+        adlerA = (adlerA + byte) % 65521;
+        adlerB = (adlerB + adlerA) % 65521;
+    }
+
+    appendBigEndian32(zlibData, (adlerB << 16) | adlerA);
+
+    std::vector<uint8_t> header;
+    appendBigEndian32(header, width);
+    appendBigEndian32(header, height);
+    header.push_back(8);    // Bit depth
+    header.push_back(6);    // Colour type RGBA
+    header.push_back(0);    // Compression
+    header.push_back(0);    // Filter
+    header.push_back(0);    // Interlace
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+    std::vector<uint8_t> png(signature, signature + 8);
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", zlibData);
+    appendChunk(png, "IEND", {});
+
+    FILE * file = fopen(path, "wb");
+
+    if(file == nullptr) {
+        printf("Failed to open '%s' for writing\n", path);
+        return false;
+    }
+
+    const bool success = (fwrite(png.data(), 1, png.size(), file) == png.size());
+    fclose(file);
+
+    return success;
+}
+
+bool readImageRGBA(const char * path, std::vector<uint8_t>& outPixelsRGBA, uint32_t& outWidth, uint32_t& outHeight)
+{
+    int width = 0, height = 0, channels = 0;
+    uint8_t * pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+
+    if(pixels == nullptr) {
+        printf("Failed to read image '%s'\n", path);
+        return false;
+    }
+
+    outWidth = static_cast<uint32_t>(width);
+    outHeight = static_cast<uint32_t>(height);
+    outPixelsRGBA.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+
+    stbi_image_free(pixels);
+
+    return true;
+}
+
+uint32_t countDifferentPixels(const uint8_t * pixelsRGBA, const uint8_t * expectedRGBA, uint32_t numPixels, uint8_t tolerance)
+{
+    uint32_t numDifferent = 0;
+
+    for(uint32_t i = 0; i < numPixels; i++)
+    {
+        for(uint8_t channel = 0; channel < 4; channel++)
+        {
+            const int32_t difference = static_cast<int32_t>(pixelsRGBA[i * 4 + channel]) - expectedRGBA[i * 4 + channel];
+
+            if(difference > tolerance || difference < -tolerance) {
+                numDifferent++;
+                break;
+            }
+        }
+    }
+
+    return numDifferent;
+}
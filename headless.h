@@ -0,0 +1,36 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Headless rendering
+// Renders into a ring of offscreen images that stand in for the swapchain, so the normal drawFrame path
+// can run without a window or VkSurfaceKHR (E.g. On lavapipe / SwiftShader in CI)
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+#include <vector>
+
+#include "typesvulkan.h"
+
+// Creates `imageCount` offscreen colour images and stores them in app.swapChainImages
+void createOffscreenImages(VulkanApplication& app, uint32_t width, uint32_t height, uint32_t imageCount);
+void destroyOffscreenImages(VulkanApplication& app);
+
+// Replacement for vkAcquireNextImageKHR in headless mode
+uint32_t acquireOffscreenImage(VulkanApplication& app);
+
+// Copies an offscreen image (Which must be in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) into tightly packed RGBA8.
+// Waits for rendering to the image to finish first
+void readbackOffscreenImage(VulkanApplication& app, uint32_t imageIndex, std::vector<uint8_t>& outPixelsRGBA);
+
+// Writes an uncompressed (Stored deflate blocks) RGBA8 PNG. No zlib dependency
+bool writePNG(const char * path, const uint8_t * pixelsRGBA, uint32_t width, uint32_t height);
+
+// Reads any image stb_image can into RGBA8. Returns false if the file can't be read
+bool readImageRGBA(const char * path, std::vector<uint8_t>& outPixelsRGBA, uint32_t& outWidth, uint32_t& outHeight);
+
+// Number of pixels where any channel differs by more than tolerance. Both must hold numPixels RGBA8 pixels
+uint32_t countDifferentPixels(const uint8_t * pixelsRGBA, const uint8_t * expectedRGBA, uint32_t numPixels, uint8_t tolerance);
+
+#endif // HEADLESS_H
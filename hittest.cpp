@@ -0,0 +1,108 @@
+#include "hittest.h"
+
+#include <cmath>
+
+// Unit vector for each binary angle, in 2.14 fixed point
+struct AngleDirections
+{
+    int32_t x[256];
+    int32_t y[256];
+};
+
+static AngleDirections buildAngleDirections()
+{
+    AngleDirections directions;
+    const double step = (2.0 * M_PI) / 256.0;
+
+    for(uint16_t i = 0; i < 256; i++) {
+        directions.x[i] = static_cast<int32_t>(std::lround(std::cos(i * step) * (1 << 14)));
+        directions.y[i] = static_cast<int32_t>(std::lround(std::sin(i * step) * (1 << 14)));
+    }
+
+    return directions;
+}
+
+static const AngleDirections angleDirections = buildAngleDirections();
+
+// Positive when b is on the +angle side of a
+static inline int64_t cross(int64_t ax, int64_t ay, int64_t bx, int64_t by)
+{
+    return ax * by - ay * bx;
+}
+
+bool hitTestArc(const NormalizedArc& arc, int32_t x, int32_t y, VkExtent2D extent)
+{
+    // In pixels, scaled by 2 * NORMFLOAT_MAX. Only compared with each other, so the scale doesn't matter
+    const int64_t dx = (static_cast<int64_t>(x) - arc.center.x.data) * extent.width;
+    const int64_t dy = (static_cast<int64_t>(y) - arc.center.y.data) * extent.height;
+    const int64_t radius = static_cast<int64_t>(arc.radius.data) * extent.width;
+
+    // Rejecting outside the bounding square first keeps both offsets within the radius. That's under 2^31 for
+    // framebuffers up to 32768 pixels wide, so each square is under 2^62 and their sum fits in uint64_t
+    if(dx > radius || dx < -radius || dy > radius || dy < -radius) {
+        return false;
+    }
+
+    const uint64_t absX = static_cast<uint64_t>(dx < 0 ? -dx : dx);
+    const uint64_t absY = static_cast<uint64_t>(dy < 0 ? -dy : dy);
+    const uint64_t radiusSquared = static_cast<uint64_t>(radius) * static_cast<uint64_t>(radius);
+
+    if(absX * absX + absY * absY > radiusSquared) {
+        return false;
+    }
+
+    const uint8_t span = static_cast<uint8_t>(arc.endAngle - arc.startAngle);
+
+    if(span == 0) {
+        return true;
+    }
+
+    const int32_t startX = angleDirections.x[arc.startAngle];
+    const int32_t startY = angleDirections.y[arc.startAngle];
+    const int32_t endX = angleDirections.x[arc.endAngle];
+    const int32_t endY = angleDirections.y[arc.endAngle];
+
+    // Up to half a turn the sector is the intersection of two half planes. Past that, test the smaller sector
+    // that isn't covered instead
+    if(span <= 128) {
+        return cross(startX, startY, dx, dy) >= 0 && cross(dx, dy, endX, endY) >= 0;
+    }
+
+    return ! (cross(endX, endY, dx, dy) > 0 && cross(dx, dy, startX, startY) > 0);
+}
+
+bool hitTestSubAreas(const OnMouseEventOpBindings& bindings, const MouseBounds& mouseBounds, int32_t x, int32_t y, VkExtent2D extent)
+{
+    assert(static_cast<size_t>(mouseBounds.firstSubArea) + mouseBounds.numSubAreas <= bindings.complexAreas.size());
+
+    const int32_t relativeX = x - mouseBounds.boundsArea.topLeftPoint.x.data;
+    const int32_t relativeY = y - mouseBounds.boundsArea.topLeftPoint.y.data;
+
+    const AreaShape * subAreas = bindings.complexAreas.data() + mouseBounds.firstSubArea;
+
+    for(uint8_t i = 0; i < mouseBounds.numSubRects; i++)
+    {
+        if(toFixedRect(subAreas[i].r).contains(relativeX, relativeY)) {
+            return true;
+        }
+    }
+
+    for(uint8_t i = mouseBounds.numSubRects; i < mouseBounds.numSubAreas; i++)
+    {
+        if(hitTestArc(subAreas[i].a, relativeX, relativeY, extent)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool hitTestBounds(const OnMouseEventOpBindings& bindings, uint16_t boundsIndex, int32_t x, int32_t y, VkExtent2D extent)
+{
+    if(! bindings.grid.rectOf(boundsIndex).contains(x, y)) {
+        return false;
+    }
+
+    const MouseBounds& mouseBounds = bindings.bounds[boundsIndex];
+    return mouseBounds.numSubAreas == 0 || hitTestSubAreas(bindings, mouseBounds, x, y, extent);
+}
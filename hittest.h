@@ -0,0 +1,26 @@
+#ifndef HITTEST_H
+#define HITTEST_H
+
+// Hit testing of mouse bounds against their exact shape
+// A MouseBounds with no sub areas is hit anywhere inside its boundsArea. Otherwise it's a compound area, hit where
+// any of its rects or arcs are. Candidates always come from MouseBoundsGrid, which has already rejected everything
+// whose boundsArea doesn't contain the point, so the tests here only run for the few bounds under the cursor.
+//
+// Positions are in SNormFloat16 units. A unit is a different number of pixels on each axis unless the framebuffer is
+// square, so arcs are tested in pixels of extent (The framebuffer size) to stay round on screen. An arc's radius is
+// in units of the x axis. Arc angles are binary angles (256 is a full turn) measured from +x towards +y on screen,
+// and an arc covers startAngle to endAngle in that direction. startAngle == endAngle is a full circle
+
+#include <stdint.h>
+
+#include "typesvulkan.h"
+
+// Point is relative to the top left of the bounds the arc belongs to
+bool hitTestArc(const NormalizedArc& arc, int32_t x, int32_t y, VkExtent2D extent);
+
+// Point is absolute. Doesn't test boundsArea
+bool hitTestSubAreas(const OnMouseEventOpBindings& bindings, const MouseBounds& mouseBounds, int32_t x, int32_t y, VkExtent2D extent);
+
+bool hitTestBounds(const OnMouseEventOpBindings& bindings, uint16_t boundsIndex, int32_t x, int32_t y, VkExtent2D extent);
+
+#endif // HITTEST_H
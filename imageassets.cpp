@@ -0,0 +1,861 @@
+#include "imageassets.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "config.h"
+#include "initvulkan.h"
+#include "mainvulkan.h"
+#include "typesvulkan.h"
+#include "vulkanhelper.h"
+
+static const VkFormat IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+
+static VkImageMemoryBarrier imageBarrier(   VkImage image,
+                                            uint32_t baseMipLevel,
+                                            uint32_t levelCount,
+                                            VkImageLayout oldLayout,
+                                            VkImageLayout newLayout,
+                                            VkAccessFlags srcAccessMask,
+                                            VkAccessFlags dstAccessMask )
+{
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = baseMipLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+    barrier.srcAccessMask = srcAccessMask;
+    barrier.dstAccessMask = dstAccessMask;
+
+    return barrier;
+}
+
+static VkBufferImageCopy stagingRegion(uint32_t stagingOffset, int32_t x, int32_t y, uint32_t width, uint32_t height)
+{
+    VkBufferImageCopy region = {};
+    region.bufferOffset = stagingOffset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = { x, y, 0 };
+    region.imageExtent = { width, height, 1 };
+
+    return region;
+}
+
+// Gives the asset its own image, view and texture table slot. False if the table is full
+static bool createOwnImage(VulkanApplication& app, ImageAsset& asset)
+{
+    ImageAssets& images = app.images;
+
+    asset.mipLevels = (images.canGenerateMipmaps)
+            ? static_cast<uint32_t>(std::floor(std::log2(std::max(asset.width, asset.height)))) + 1
+            : 1;
+
+    createImage(    app.device,
+                    app.physicalDevice,
+                    asset.width,
+                    asset.height,
+                    IMAGE_FORMAT,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    asset.image,
+                    asset.memory,
+                    asset.mipLevels );
+
+    createImageView(app.device, asset.image, IMAGE_FORMAT, asset.imageView, asset.mipLevels);
+
+    asset.texture = registerTexture(app.device, app.textures, asset.imageView, images.sampler);
+
+    if(asset.texture == TextureTable::INVALID_TEXTURE)
+    {
+        vkDestroyImageView(app.device, asset.imageView, nullptr);
+        vkDestroyImage(app.device, asset.image, nullptr);
+        vkFreeMemory(app.device, asset.memory, nullptr);
+
+        asset.image = VK_NULL_HANDLE;
+        asset.memory = VK_NULL_HANDLE;
+        asset.imageView = VK_NULL_HANDLE;
+
+        return false;
+    }
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetImageMemoryRequirements(app.device, asset.image, &memoryRequirements);
+
+    asset.sizeBytes = memoryRequirements.size;
+    images.stats.bytesResident += asset.sizeBytes;
+
+    asset.u0 = 0.0f;
+    asset.v0 = 0.0f;
+    asset.u1 = 1.0f;
+    asset.v1 = 1.0f;
+
+    return true;
+}
+
+// BEGIN Residency
+
+// The configured budget, lowered to what's left of the device local heap when VK_EXT_memory_budget is enabled
+static uint64_t availableBudget(const VulkanApplication& app)
+{
+    const ImageAssets& images = app.images;
+
+    if(images.getMemoryProperties2 == nullptr) {
+        return images.budgetBytes;
+    }
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudget = {};
+    memoryBudget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+    VkPhysicalDeviceMemoryProperties2KHR memoryProperties = {};
+    memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+    memoryProperties.pNext = &memoryBudget;
+
+    images.getMemoryProperties2(app.physicalDevice, &memoryProperties);
+
+    const uint64_t heapBudget = memoryBudget.heapBudget[images.deviceLocalHeap];
+    const uint64_t heapUsage = memoryBudget.heapUsage[images.deviceLocalHeap];
+
+    // Usage includes what's already resident, which is reusable by evicting it
+    const uint64_t headroom = (heapBudget > heapUsage) ? heapBudget - heapUsage : 0;
+
+    return std::min(images.budgetBytes, images.stats.bytesResident + headroom);
+}
+
+static void evictImage(VulkanApplication& app, uint32_t image)
+{
+    ImageAssets& images = app.images;
+    ImageAsset& asset = images.assets[image];
+
+    assert(asset.state == ImageState::READY && asset.image != VK_NULL_HANDLE);
+
+    releaseTexture(app.textures, asset.texture);
+
+    vkDestroyImageView(app.device, asset.imageView, nullptr);
+    vkDestroyImage(app.device, asset.image, nullptr);
+    vkFreeMemory(app.device, asset.memory, nullptr);
+
+    asset.image = VK_NULL_HANDLE;
+    asset.memory = VK_NULL_HANDLE;
+    asset.imageView = VK_NULL_HANDLE;
+    asset.texture = TextureTable::INVALID_TEXTURE;
+    asset.state = ImageState::EVICTED;
+
+    images.stats.bytesResident -= asset.sizeBytes;
+    images.stats.evictions++;
+}
+
+// Evicts the least recently drawn images until bytesNeeded fits in the budget. Images drawn by a frame that could
+// still be in flight aren't evicted. False if there wasn't enough to evict
+static bool makeResidentRoom(VulkanApplication& app, uint64_t bytesNeeded)
+{
+    ImageAssets& images = app.images;
+    const uint64_t budget = availableBudget(app);
+
+    while(images.stats.bytesResident + bytesNeeded > budget)
+    {
+        uint32_t victim = ImageAssets::INVALID_IMAGE;
+
+        for(uint32_t i = 0; i < images.assets.size(); i++)
+        {
+            const ImageAsset& asset = images.assets[i];
+
+            if(asset.state != ImageState::READY || asset.image == VK_NULL_HANDLE || asset.lastUsedFrame + MAX_FRAMES_IN_FLIGHT >= images.frame) {
+                continue;
+            }
+
+            if(victim == ImageAssets::INVALID_IMAGE || asset.lastUsedFrame < images.assets[victim].lastUsedFrame) {
+                victim = i;
+            }
+        }
+
+        if(victim == ImageAssets::INVALID_IMAGE) {
+            return false;
+        }
+
+        evictImage(app, victim);
+    }
+
+    return true;
+}
+
+// Takes the decoded pixels into the CPU cache if they fit, dropping the least recently drawn cached pixels to make
+// room. Otherwise they're released and an eviction will reload from disk
+static void cachePixels(ImageAssets& images, DecodedImage& decoded)
+{
+    const uint64_t sizeBytes = static_cast<uint64_t>(decoded.width) * decoded.height * 4;
+
+    if(sizeBytes > vconfig::IMAGE_CPU_CACHE_SIZE) {
+        ImageDecoder::releasePixels(decoded);
+        return;
+    }
+
+    while(images.stats.bytesCached + sizeBytes > vconfig::IMAGE_CPU_CACHE_SIZE)
+    {
+        uint32_t victim = ImageAssets::INVALID_IMAGE;
+
+        for(uint32_t i = 0; i < images.assets.size(); i++)
+        {
+            const ImageAsset& asset = images.assets[i];
+
+            if(asset.pixels != nullptr && (victim == ImageAssets::INVALID_IMAGE || asset.lastUsedFrame < images.assets[victim].lastUsedFrame)) {
+                victim = i;
+            }
+        }
+
+        assert(victim != ImageAssets::INVALID_IMAGE);
+
+        ImageAsset& asset = images.assets[victim];
+
+        ImageDecoder::releasePixels(asset.pixels);
+        images.stats.bytesCached -= static_cast<uint64_t>(asset.width) * asset.height * 4;
+    }
+
+    images.assets[decoded.image].pixels = decoded.pixels;
+    images.stats.bytesCached += sizeBytes;
+    decoded.pixels = nullptr;
+}
+
+// Puts the image back in the upload queue, from the CPU cache if it's there
+static void reloadImage(ImageAssets& images, uint32_t image)
+{
+    ImageAsset& asset = images.assets[image];
+
+    assert(asset.state == ImageState::EVICTED);
+
+    asset.state = ImageState::DECODING;
+
+    if(asset.pixels != nullptr)
+    {
+        images.decoded.push_back({ image, asset.width, asset.height, asset.pixels });
+        images.stats.bytesCached -= static_cast<uint64_t>(asset.width) * asset.height * 4;
+        images.stats.reloadsFromCache++;
+
+        asset.pixels = nullptr;
+    } else
+    {
+        images.decoder->request(image, asset.path);
+        images.stats.reloadsFromDisk++;
+    }
+}
+
+// END Residency
+
+// Quads are written top right, bottom right, bottom left, top left (See image)
+static void writeQuad(VulkanApplication& app, uint32_t verticesOffsetBytes, uint32_t texture, float u0, float v0, float u1, float v1)
+{
+    Vertex * vertices = reinterpret_cast<Vertex *>(app.entitySystem.verticesComponentBasePtr + verticesOffsetBytes);
+
+    vertices[0].texCoord = { u1, v0 };
+    vertices[1].texCoord = { u1, v1 };
+    vertices[2].texCoord = { u0, v1 };
+    vertices[3].texCoord = { u0, v0 };
+
+    for(uint32_t i = 0; i < 4; i++) {
+        vertices[i].textureIndex = texture;
+    }
+
+    app.frameStats.bytesUploaded += 4 * (sizeof(glm::vec2) + sizeof(uint32_t));
+}
+
+static void writeImageQuad(VulkanApplication& app, uint32_t verticesOffsetBytes, const ImageAsset& asset)
+{
+    writeQuad(app, verticesOffsetBytes, asset.texture, asset.u0, asset.v0, asset.u1, asset.v1);
+}
+
+// Centre of the placeholder, so filtering never reaches outside of it
+static void writePlaceholderQuad(VulkanApplication& app, uint32_t verticesOffsetBytes)
+{
+    const ImageAssets& images = app.images;
+    const float atlasSize = static_cast<float>(vconfig::IMAGE_ATLAS_SIZE);
+
+    const float u = (images.placeholder.x + 1.0f) / atlasSize;
+    const float v = (images.placeholder.y + 1.0f) / atlasSize;
+
+    writeQuad(app, verticesOffsetBytes, images.atlasTexture, u, v, u, v);
+}
+
+// Marks the images drawn this frame as used and points pending entities at images that have become READY. Released
+// entities are dropped, after pointing their quads (Which are still drawn) at the placeholder so they can't sample an
+// image that's evicted later
+static void updateBindings(VulkanApplication& app)
+{
+    ImageAssets& images = app.images;
+    const EntitySystemHandle& entities = app.entitySystem;
+
+    bool isRedrawRequired = false;
+
+    for(uint32_t i = 0; i < images.bindings.size();)
+    {
+        ImageBinding& binding = images.bindings[i];
+
+        if(! entities.isAlive(binding.entity))
+        {
+            if(! binding.isPending) {
+                writePlaceholderQuad(app, binding.verticesOffsetBytes);
+            }
+
+            binding = images.bindings.back();
+            images.bindings.pop_back();
+            continue;
+        }
+
+        ImageAsset& asset = images.assets[binding.image];
+        asset.lastUsedFrame = images.frame;
+
+        if(binding.isPending && asset.state == ImageState::READY)
+        {
+            writeImageQuad(app, binding.verticesOffsetBytes, asset);
+            binding.isPending = false;
+            isRedrawRequired = true;
+        }
+
+        i++;
+    }
+
+    if(isRedrawRequired) {
+        requestRedraw();
+    }
+}
+
+// Copies level 0 from the staging buffer, then blits each level down from the one above it. Every level ends up
+// in SHADER_READ_ONLY_OPTIMAL
+static void recordOwnImageUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, uint32_t stagingOffset, const ImageAsset& asset)
+{
+    VkImageMemoryBarrier barrier = imageBarrier(    asset.image, 0, asset.mipLevels,
+                                                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                    0, VK_ACCESS_TRANSFER_WRITE_BIT );
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    const VkBufferImageCopy region = stagingRegion(stagingOffset, 0, 0, asset.width, asset.height);
+    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, asset.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    int32_t levelWidth = static_cast<int32_t>(asset.width);
+    int32_t levelHeight = static_cast<int32_t>(asset.height);
+
+    for(uint32_t level = 1; level < asset.mipLevels; level++)
+    {
+        barrier = imageBarrier( asset.image, level - 1, 1,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT );
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        const int32_t nextWidth = std::max(levelWidth / 2, 1);
+        const int32_t nextHeight = std::max(levelHeight / 2, 1);
+
+        VkImageBlit blit = {};
+        blit.srcOffsets[0] = { 0, 0, 0 };
+        blit.srcOffsets[1] = { levelWidth, levelHeight, 1 };
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.dstOffsets[0] = { 0, 0, 0 };
+        blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+
+        vkCmdBlitImage( commandBuffer,
+                        asset.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        asset.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        1, &blit,
+                        VK_FILTER_LINEAR );
+
+        barrier = imageBarrier( asset.image, level - 1, 1,
+                                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT );
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        levelWidth = nextWidth;
+        levelHeight = nextHeight;
+    }
+
+    barrier = imageBarrier( asset.image, asset.mipLevels - 1, 1,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT );
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+bool supportsMemoryBudget(VkPhysicalDevice physicalDevice)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    for(const VkExtensionProperties& extension : availableExtensions)
+    {
+        if(strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void createImageAssets(VulkanApplication& app)
+{
+    ImageAssets& images = app.images;
+
+    // Without descriptor indexing the table only has room for the font atlas
+    if(! app.textures.isBindless)
+    {
+        images.isAvailable = false;
+        return;
+    }
+
+    VkSamplerCreateInfo samplerInfo = {};
+    samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+    samplerInfo.magFilter = VK_FILTER_LINEAR;
+    samplerInfo.minFilter = VK_FILTER_LINEAR;
+    samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    samplerInfo.anisotropyEnable = VK_FALSE;
+    samplerInfo.maxAnisotropy = 1.0f;
+    samplerInfo.borderColor = VK_BORDER_COLOR_INT_TRANSPARENT_BLACK;
+    samplerInfo.unnormalizedCoordinates = VK_FALSE;
+    samplerInfo.compareEnable = VK_FALSE;
+    samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+    samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.mipLodBias = 0.0f;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+    if (vkCreateSampler(app.device, &samplerInfo, nullptr, &images.sampler) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image sampler!");
+    }
+
+    // Mipmaps are generated with linear blits, which not every device supports for the format
+    VkFormatProperties formatProperties;
+    vkGetPhysicalDeviceFormatProperties(app.physicalDevice, IMAGE_FORMAT, &formatProperties);
+
+    const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+    images.canGenerateMipmaps = (formatProperties.optimalTilingFeatures & blitFeatures) == blitFeatures;
+
+    // Atlas BEGIN
+
+    createImage(    app.device,
+                    app.physicalDevice,
+                    vconfig::IMAGE_ATLAS_SIZE,
+                    vconfig::IMAGE_ATLAS_SIZE,
+                    IMAGE_FORMAT,
+                    VK_IMAGE_TILING_OPTIMAL,
+                    VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    images.atlasImage,
+                    images.atlasMemory );
+
+    createImageView(app.device, images.atlasImage, IMAGE_FORMAT, images.atlasImageView);
+
+    // Cleared so the placeholder and the padding between images are transparent
+    VkCommandBuffer commandBuffer = beginSingleTimeCommands(app.device, app.commandPool);
+
+    VkImageMemoryBarrier barrier = imageBarrier(    images.atlasImage, 0, 1,
+                                                    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                    0, VK_ACCESS_TRANSFER_WRITE_BIT );
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    const VkClearColorValue transparent = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+    const VkImageSubresourceRange clearRange = barrier.subresourceRange;
+
+    vkCmdClearColorImage(commandBuffer, images.atlasImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &transparent, 1, &clearRange);
+
+    barrier = imageBarrier( images.atlasImage, 0, 1,
+                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                            VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT );
+
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    endSingleTimeCommands(app.device, app.commandPool, app.graphicsQueue, commandBuffer);
+
+    VkMemoryRequirements atlasMemoryRequirements;
+    vkGetImageMemoryRequirements(app.device, images.atlasImage, &atlasMemoryRequirements);
+    images.stats.bytesResident += atlasMemoryRequirements.size;
+
+    images.atlasTexture = registerTexture(app.device, app.textures, images.atlasImageView, images.sampler);
+
+    if(images.atlasTexture == TextureTable::INVALID_TEXTURE) {
+        throw std::runtime_error("failed to register image atlas texture!");
+    }
+
+    images.atlasPacker.reset(vconfig::IMAGE_ATLAS_SIZE, vconfig::IMAGE_ATLAS_SIZE, 1);
+
+    if(! images.atlasPacker.insert(2, 2, images.placeholder)) {
+        throw std::runtime_error("failed to reserve image placeholder in atlas!");
+    }
+
+    // Atlas END
+
+    createBuffer(   app.device,
+                    app.physicalDevice,
+                    vconfig::IMAGE_STAGING_SIZE,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    images.stagingBuffer,
+                    images.stagingMemory );
+
+    if(vkMapMemory(app.device, images.stagingMemory, 0, vconfig::IMAGE_STAGING_SIZE, 0, reinterpret_cast<void **>(&images.mappedStaging)) != VK_SUCCESS) {
+        throw std::runtime_error("failed to map image staging memory!");
+    }
+
+    VkCommandBufferAllocateInfo commandBufferAllocInfo = {};
+    commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocInfo.commandPool = app.commandPool;
+    commandBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocInfo.commandBufferCount = 1;
+
+    if (vkAllocateCommandBuffers(app.device, &commandBufferAllocInfo, &images.uploadCommandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate image upload command buffer!");
+    }
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+    if (vkCreateFence(app.device, &fenceInfo, nullptr, &images.uploadFence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create image upload fence!");
+    }
+
+    images.budgetBytes = vconfig::TEXTURE_MEMORY_BUDGET;
+
+    // Needs the instance to have VK_KHR_get_physical_device_properties2 as well (See getRequiredExtensions)
+    if(app.memoryBudgetEnabled)
+    {
+        images.getMemoryProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(vkGetInstanceProcAddr(app.instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        vkGetPhysicalDeviceMemoryProperties(app.physicalDevice, &memoryProperties);
+
+        for(uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+        {
+            if(memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) {
+                images.deviceLocalHeap = memoryProperties.memoryTypes[i].heapIndex;
+                break;
+            }
+        }
+    }
+
+    images.decoder = std::make_unique<ImageDecoder>();
+    images.decoder->start(vconfig::IMAGE_DECODE_THREADS);
+
+    images.isAvailable = true;
+}
+
+void destroyImageAssets(VulkanApplication& app)
+{
+    ImageAssets& images = app.images;
+
+    if(images.decoder) {
+        images.decoder->stop();
+    }
+
+    for(DecodedImage& decoded : images.decoded) {
+        ImageDecoder::releasePixels(decoded);
+    }
+
+    if(! images.uploading.empty()) {
+        vkWaitForFences(app.device, 1, &images.uploadFence, VK_TRUE, UINT64_MAX);
+    }
+
+    for(ImageAsset& asset : images.assets)
+    {
+        ImageDecoder::releasePixels(asset.pixels);
+
+        if(asset.image != VK_NULL_HANDLE)
+        {
+            vkDestroyImageView(app.device, asset.imageView, nullptr);
+            vkDestroyImage(app.device, asset.image, nullptr);
+            vkFreeMemory(app.device, asset.memory, nullptr);
+        }
+    }
+
+    if(images.atlasImage != VK_NULL_HANDLE)
+    {
+        vkDestroyImageView(app.device, images.atlasImageView, nullptr);
+        vkDestroyImage(app.device, images.atlasImage, nullptr);
+        vkFreeMemory(app.device, images.atlasMemory, nullptr);
+    }
+
+    if(images.sampler != VK_NULL_HANDLE) {
+        vkDestroySampler(app.device, images.sampler, nullptr);
+    }
+
+    if(images.stagingBuffer != VK_NULL_HANDLE)
+    {
+        vkDestroyBuffer(app.device, images.stagingBuffer, nullptr);
+        vkFreeMemory(app.device, images.stagingMemory, nullptr);
+    }
+
+    if(images.uploadFence != VK_NULL_HANDLE) {
+        vkDestroyFence(app.device, images.uploadFence, nullptr);
+    }
+
+    if(images.uploadCommandBuffer != VK_NULL_HANDLE) {
+        vkFreeCommandBuffers(app.device, app.commandPool, 1, &images.uploadCommandBuffer);
+    }
+
+    images = ImageAssets();
+}
+
+uint32_t loadImage(VulkanApplication& app, const std::string& path)
+{
+    ImageAssets& images = app.images;
+
+    if(! images.isAvailable) {
+        return ImageAssets::INVALID_IMAGE;
+    }
+
+    const auto found = images.byPath.find(path);
+
+    if(found != images.byPath.end()) {
+        return found->second;
+    }
+
+    const uint32_t image = static_cast<uint32_t>(images.assets.size());
+
+    ImageAsset asset = {};
+    asset.state = ImageState::DECODING;
+    asset.path = path;
+    asset.texture = TextureTable::INVALID_TEXTURE;
+    asset.mipLevels = 1;
+    asset.lastUsedFrame = images.frame;
+    asset.pixels = nullptr;
+
+    images.assets.push_back(std::move(asset));
+    images.byPath.emplace(path, image);
+
+    images.decoder->request(image, path);
+
+    return image;
+}
+
+void processImageAssets(VulkanApplication& app)
+{
+    ImageAssets& images = app.images;
+
+    if(! images.isAvailable) {
+        return;
+    }
+
+    images.frame++;
+
+    if(! images.uploading.empty() && vkGetFenceStatus(app.device, images.uploadFence) == VK_SUCCESS)
+    {
+        vkResetFences(app.device, 1, &images.uploadFence);
+
+        for(uint32_t image : images.uploading) {
+            images.assets[image].state = ImageState::READY;
+        }
+
+        images.uploading.clear();
+    }
+
+    updateBindings(app);
+
+    // The staging buffer can't be reused until the previous batch has been copied out of it
+    if(! images.uploading.empty()) {
+        return;
+    }
+
+    images.decoder->collect(images.decoded, UINT32_MAX);
+
+    if(images.decoded.empty()) {
+        return;
+    }
+
+    VkBufferImageCopy * atlasCopies = app.frameArena.allocate<VkBufferImageCopy>(static_cast<uint32_t>(images.decoded.size()));
+    uint32_t numAtlasCopies = 0;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    if (vkBeginCommandBuffer(images.uploadCommandBuffer, &beginInfo) != VK_SUCCESS) {
+        throw std::runtime_error("failed to begin recording image upload command buffer!");
+    }
+
+    uint32_t stagingUsed = 0;
+    uint32_t numProcessed = 0;
+
+    for(; numProcessed < images.decoded.size(); numProcessed++)
+    {
+        DecodedImage& decoded = images.decoded[numProcessed];
+        ImageAsset& asset = images.assets[decoded.image];
+
+        if(decoded.pixels == nullptr)
+        {
+            asset.state = ImageState::FAILED;
+            continue;
+        }
+
+        const uint32_t sizeBytes = decoded.width * decoded.height * 4;
+
+        if(sizeBytes > vconfig::IMAGE_STAGING_SIZE)
+        {
+            ImageDecoder::releasePixels(decoded);
+            asset.state = ImageState::FAILED;
+            continue;
+        }
+
+        // Whatever doesn't fit goes in the next batch
+        if(stagingUsed + sizeBytes > vconfig::IMAGE_STAGING_SIZE) {
+            break;
+        }
+
+        asset.width = decoded.width;
+        asset.height = decoded.height;
+
+        AtlasRect rect;
+
+        const bool isSmall = (decoded.width <= vconfig::MAX_ATLAS_IMAGE_SIZE && decoded.height <= vconfig::MAX_ATLAS_IMAGE_SIZE);
+
+        if(isSmall && images.atlasPacker.insert(decoded.width, decoded.height, rect))
+        {
+            const float atlasSize = static_cast<float>(vconfig::IMAGE_ATLAS_SIZE);
+
+            asset.texture = images.atlasTexture;
+            asset.u0 = rect.x / atlasSize;
+            asset.v0 = rect.y / atlasSize;
+            asset.u1 = (rect.x + rect.width) / atlasSize;
+            asset.v1 = (rect.y + rect.height) / atlasSize;
+
+            atlasCopies[numAtlasCopies++] = stagingRegion(stagingUsed, static_cast<int32_t>(rect.x), static_cast<int32_t>(rect.y), rect.width, rect.height);
+        } else
+        {
+            // Estimate, including mipmaps. The actual size is known once the image exists
+            const uint64_t estimatedBytes = (images.canGenerateMipmaps) ? sizeBytes + sizeBytes / 3 : sizeBytes;
+
+            // Images in use are never evicted, so it's loaded anyway
+            if(! makeResidentRoom(app, estimatedBytes)) {
+                images.stats.overBudgetUploads++;
+            }
+
+            if(! createOwnImage(app, asset))
+            {
+                ImageDecoder::releasePixels(decoded);
+                asset.state = ImageState::FAILED;
+                continue;
+            }
+
+            recordOwnImageUpload(images.uploadCommandBuffer, images.stagingBuffer, stagingUsed, asset);
+        }
+
+        memcpy(images.mappedStaging + stagingUsed, decoded.pixels, sizeBytes);
+
+        // Only images that can be evicted need their pixels again
+        if(asset.image != VK_NULL_HANDLE) {
+            cachePixels(images, decoded);
+        } else {
+            ImageDecoder::releasePixels(decoded);
+        }
+
+        stagingUsed += sizeBytes;
+
+        asset.state = ImageState::UPLOADING;
+        images.uploading.push_back(decoded.image);
+    }
+
+    images.decoded.erase(images.decoded.begin(), images.decoded.begin() + numProcessed);
+
+    if(numAtlasCopies > 0)
+    {
+        // Frames already submitted may still be sampling the atlas
+        VkImageMemoryBarrier barrier = imageBarrier(    images.atlasImage, 0, 1,
+                                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                        VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT );
+
+        vkCmdPipelineBarrier(images.uploadCommandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage(images.uploadCommandBuffer, images.stagingBuffer, images.atlasImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, numAtlasCopies, atlasCopies);
+
+        barrier = imageBarrier( images.atlasImage, 0, 1,
+                                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT );
+
+        vkCmdPipelineBarrier(images.uploadCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    if (vkEndCommandBuffer(images.uploadCommandBuffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to record image upload command buffer!");
+    }
+
+    // Everything collected failed, nothing to submit
+    if(images.uploading.empty()) {
+        return;
+    }
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &images.uploadCommandBuffer;
+
+    if (vkQueueSubmit(app.graphicsQueue, 1, &submitInfo, images.uploadFence) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit image upload command buffer!");
+    }
+}
+
+void bindImage(VulkanApplication& app, Entity32 entity, uint32_t image)
+{
+    ImageAssets& images = app.images;
+    EntitySystemHandle& entities = app.entitySystem;
+
+    const uint32_t entityIndex = entities.resolve(entity);
+    const RelativeDataLocation& location = entities.verticesComponent.at(entityIndex);
+
+    assert(location.strideBytes == sizeof(Vertex) && location.spanElements == 4);
+
+    ImageAsset& asset = images.assets[image];
+    asset.lastUsedFrame = images.frame;
+
+    if(asset.state == ImageState::READY) {
+        images.stats.hits++;
+    } else
+    {
+        images.stats.misses++;
+
+        if(asset.state == ImageState::EVICTED) {
+            reloadImage(images, image);
+        }
+    }
+
+    const bool isPending = (asset.state != ImageState::READY);
+
+    if(isPending) {
+        writePlaceholderQuad(app, location.offsetBytes);
+    } else {
+        writeImageQuad(app, location.offsetBytes, asset);
+    }
+
+    const auto found = std::find_if(images.bindings.begin(), images.bindings.end(), [entity](const ImageBinding& binding) {
+        return binding.entity == entity;
+    });
+
+    if(found != images.bindings.end()) {
+        *found = { entity, image, location.offsetBytes, isPending };
+    } else {
+        images.bindings.push_back({ entity, image, location.offsetBytes, isPending });
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef IMAGEASSETS_H
+#define IMAGEASSETS_H
+
+// Images loaded from disk for image widgets. Files are decoded on worker threads (See ImageDecoder), then uploaded
+// from the render thread in one batch per frame through a persistent staging buffer. Small images are packed into a
+// shared atlas, larger ones get their own VkImage with mipmaps generated on the GPU. Either way they're drawn through
+// the texture table, so images need it to be bindless (See texturetable.h)
+//
+// Images with their own VkImage are kept within a memory budget. When an upload would go over it, the least recently
+// drawn of them are evicted, and reloaded when they're next bound. Their pixels are kept in a CPU cache (Also bounded)
+// where there's room, otherwise they're decoded from disk again. The atlas is never evicted
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "atlaspacker.h"
+#include "imagedecoder.h"
+#include "entity.h"
+
+struct VulkanApplication;
+
+// EVICTED images have no GPU copy, binding one reloads it. FAILED images couldn't be decoded, or didn't fit in the
+// staging buffer or the texture table, and draw as the placeholder
+enum class ImageState : uint8_t { DECODING = 0, UPLOADING, READY, FAILED, EVICTED };
+
+struct ImageAsset
+{
+    ImageState state;
+    uint32_t width;
+    uint32_t height;
+    std::string path;
+
+    // Where it's sampled from once READY. Atlased images share the atlas' texture
+    uint32_t texture;
+    float u0, v0, u1, v1;
+
+    // Only set for images that aren't in the atlas
+    VkImage image;
+    VkDeviceMemory memory;
+    VkImageView imageView;
+    uint32_t mipLevels;
+    uint64_t sizeBytes;         // Memory of image, counted against ImageAssets::budgetBytes
+
+    uint32_t lastUsedFrame;     // Last frame it was drawn by an entity that was alive
+    uint8_t * pixels;           // Held in the CPU cache for reloading after eviction. Freed with ImageDecoder::releasePixels
+};
+
+// Entity drawing an image. Pending until the image is READY, until then its vertices sample the placeholder
+struct ImageBinding
+{
+    Entity32 entity;
+    uint32_t image;
+    uint32_t verticesOffsetBytes;   // Kept so the quad can be pointed away from the image after the entity is released
+    bool isPending;
+};
+
+struct TextureResidencyStats
+{
+    uint64_t hits = 0;              // Images bound while READY
+    uint64_t misses = 0;            // Images bound while loading, or evicted
+    uint64_t evictions = 0;
+    uint64_t reloadsFromCache = 0;  // Evicted images uploaded again from the CPU cache
+    uint64_t reloadsFromDisk = 0;
+    uint64_t overBudgetUploads = 0; // Own images uploaded past budgetBytes, as the images in use left no room
+    uint64_t bytesResident = 0;     // Atlas and own images
+    uint64_t bytesCached = 0;       // Pixels held in the CPU cache
+};
+
+struct ImageAssets
+{
+    static const constexpr uint32_t INVALID_IMAGE = UINT32_MAX;
+
+    // False when the texture table couldn't take the atlas, in which case nothing can be loaded
+    bool isAvailable = false;
+    bool canGenerateMipmaps = false;
+
+    std::vector<ImageAsset> assets;
+    std::unordered_map<std::string, uint32_t> byPath;
+    std::vector<ImageBinding> bindings;     // Every entity drawing an image, dead ones are removed once per frame
+
+    std::unique_ptr<ImageDecoder> decoder;
+    std::vector<DecodedImage> decoded;      // Collected but not uploaded yet, E.g. the staging buffer was full
+
+    VkSampler sampler = VK_NULL_HANDLE;
+
+    VkImage atlasImage = VK_NULL_HANDLE;
+    VkDeviceMemory atlasMemory = VK_NULL_HANDLE;
+    VkImageView atlasImageView = VK_NULL_HANDLE;
+    uint32_t atlasTexture = UINT32_MAX;
+    AtlasPacker atlasPacker;
+    AtlasRect placeholder;                  // Transparent, sampled by images that aren't READY
+
+    VkBuffer stagingBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory stagingMemory = VK_NULL_HANDLE;
+    uint8_t * mappedStaging = nullptr;
+
+    VkCommandBuffer uploadCommandBuffer = VK_NULL_HANDLE;
+    VkFence uploadFence = VK_NULL_HANDLE;
+    std::vector<uint32_t> uploading;        // Images in the batch that uploadFence is waiting on
+
+    uint32_t frame = 0;                     // Counts calls to processImageAssets
+    uint64_t budgetBytes = 0;               // Starts as vconfig::TEXTURE_MEMORY_BUDGET
+
+    // Set when VK_EXT_memory_budget is enabled, uploads then also keep within what the driver says is left
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR getMemoryProperties2 = nullptr;
+    uint32_t deviceLocalHeap = 0;
+
+    TextureResidencyStats stats;
+};
+
+bool supportsMemoryBudget(VkPhysicalDevice physicalDevice);
+
+// Called once the command pool and texture table exist
+void createImageAssets(VulkanApplication& app);
+void destroyImageAssets(VulkanApplication& app);
+
+// Starts decoding the file, or returns the image already loaded from path. INVALID_IMAGE if images aren't available
+uint32_t loadImage(VulkanApplication& app, const std::string& path);
+
+// Collects finished decodes, submits them as one upload and marks the previous upload's images READY once it's done.
+// Evicts images as needed to keep uploads within budget. Never waits on the decoder or the GPU, anything that isn't
+// ready is left for a later frame
+void processImageAssets(VulkanApplication& app);
+
+// Points the entity's vertices at the image, or at the placeholder until it's READY, and reloads it if it was evicted.
+// Replaces any image the entity was bound to. Vertices must be Vertex
+void bindImage(VulkanApplication& app, Entity32 entity, uint32_t image);
+
+#endif // IMAGEASSETS_H
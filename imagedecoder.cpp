@@ -0,0 +1,124 @@
+#include "imagedecoder.h"
+
+#include <algorithm>
+#include <cassert>
+
+// The failure reason is a global that every worker would write to, and nothing reads it
+#define STBI_NO_FAILURE_STRINGS
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image.h"
+
+ImageDecoder::~ImageDecoder()
+{
+    stop();
+}
+
+void ImageDecoder::start(uint32_t numThreads)
+{
+    assert(workers.empty() && numThreads > 0);
+
+    stopping = false;
+
+    for(uint32_t i = 0; i < numThreads; i++) {
+        workers.emplace_back(&ImageDecoder::run, this);
+    }
+}
+
+void ImageDecoder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        requests.clear();
+    }
+
+    wake.notify_all();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+
+    workers.clear();
+
+    for(DecodedImage& decoded : finished) {
+        releasePixels(decoded);
+    }
+
+    finished.clear();
+}
+
+void ImageDecoder::request(uint32_t image, const std::string& path)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back({ image, path });
+    }
+
+    wake.notify_one();
+}
+
+uint32_t ImageDecoder::collect(std::vector<DecodedImage>& out, uint32_t maxResults)
+{
+    std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+
+    if(! lock.owns_lock() || finished.empty()) {
+        return 0;
+    }
+
+    const uint32_t numCollected = std::min(maxResults, static_cast<uint32_t>(finished.size()));
+
+    out.insert(out.end(), finished.begin(), finished.begin() + numCollected);
+    finished.erase(finished.begin(), finished.begin() + numCollected);
+
+    return numCollected;
+}
+
+void ImageDecoder::releasePixels(DecodedImage& decoded)
+{
+    releasePixels(decoded.pixels);
+}
+
+void ImageDecoder::releasePixels(uint8_t *& pixels)
+{
+    if(pixels != nullptr) {
+        stbi_image_free(pixels);
+        pixels = nullptr;
+    }
+}
+
+void ImageDecoder::run()
+{
+    for(;;)
+    {
+        Request request;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || ! requests.empty(); });
+
+            if(stopping) {
+                return;
+            }
+
+            request = std::move(requests.front());
+            requests.pop_front();
+        }
+
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+
+        uint8_t * pixels = stbi_load(request.path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+        DecodedImage decoded = { request.image, static_cast<uint32_t>(width), static_cast<uint32_t>(height), pixels };
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if(stopping) {
+            releasePixels(decoded);
+            return;
+        }
+
+        finished.push_back(decoded);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef IMAGEDECODER_H
+#define IMAGEDECODER_H
+
+#include <stdint.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes image files (Anything stb_image reads) on worker threads. Requests and results are handed over through
+// queues that are only locked long enough to push or pop, and collect gives up rather than wait for the lock, so
+// nothing on the render thread waits on a decode
+
+struct DecodedImage
+{
+    uint32_t image;         // Id given to request
+    uint32_t width;
+    uint32_t height;
+    uint8_t * pixels;       // RGBA8, tightly packed. Null if decoding failed. Freed with releasePixels
+};
+
+struct ImageDecoder
+{
+    struct Request
+    {
+        uint32_t image;
+        std::string path;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Request> requests;
+    std::vector<DecodedImage> finished;
+    bool stopping = false;
+
+    ImageDecoder() = default;
+    ImageDecoder(const ImageDecoder&) = delete;
+    ImageDecoder& operator=(const ImageDecoder&) = delete;
+
+    ~ImageDecoder();
+
+    void start(uint32_t numThreads);
+
+    // Waits for the decode in progress on each worker. Anything still queued is dropped
+    void stop();
+
+    void request(uint32_t image, const std::string& path);
+
+    // Appends finished decodes to out, up to maxResults. Returns how many were appended, which is 0 if a worker
+    // holds the lock
+    uint32_t collect(std::vector<DecodedImage>& out, uint32_t maxResults);
+
+    static void releasePixels(DecodedImage& decoded);
+    static void releasePixels(uint8_t *& pixels);
+
+private:
+
+    void run();
+};
+
+#endif // IMAGEDECODER_H
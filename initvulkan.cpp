@@ -1,4 +1,7 @@
 #include "initvulkan.h"
+#include "headless.h"
+#include "config.h"
+#include "texturetable.h"
 
 static VkDebugUtilsMessengerEXT debugUtilsMessenger = nullptr;
 
@@ -15,8 +18,7 @@ void cleanupSwapChain(VulkanApplication& app)
 
     for(VulkanApplicationPipeline& pipeline : app.pipelines)
     {
-        vkDestroyPipeline(app.device, pipeline.graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(app.device, pipeline.pipelineLayout, nullptr);
+        // The pipeline and its layout don't depend on the swapchain, they're kept for when it's recreated
         vkDestroyRenderPass(app.device, pipeline.renderPass, nullptr);
     }
 
@@ -24,7 +26,12 @@ void cleanupSwapChain(VulkanApplication& app)
         vkDestroyImageView(app.device, imageView, nullptr);
     }
 
-    vkDestroySwapchainKHR(app.device, app.swapChain, nullptr);
+    if(app.isHeadless) {
+        destroyOffscreenImages(app);
+    } else {
+        vkDestroySwapchainKHR(app.device, app.swapChain, nullptr);
+    }
+
     vkDestroyDescriptorPool(app.device, app.descriptorPool, nullptr);
 }
 
@@ -41,8 +48,7 @@ void cleanupSwapChain(VulkanApplication& app, std::vector<VulkanApplicationPipel
 
     for(VulkanApplicationPipeline * pipeline : pipelines)
     {
-        vkDestroyPipeline(app.device, pipeline->graphicsPipeline, nullptr);
-        vkDestroyPipelineLayout(app.device, pipeline->pipelineLayout, nullptr);
+        // The pipeline and its layout don't depend on the swapchain, they're kept for when it's recreated
         vkDestroyRenderPass(app.device, pipeline->renderPass, nullptr);
     }
 
@@ -60,11 +66,8 @@ void cleanup(VulkanApplication& app)
 
     for(VulkanApplicationPipeline& pipeline : app.pipelines)
     {
-
-        // Destory shader modules in setupCache
-        // TODO: There should be some sort of protection mechanism here for if cache didn't get initialised
-        vkDestroyShaderModule(app.device, pipeline.setupCache.shaderStages[0].module, nullptr);
-        vkDestroyShaderModule(app.device, pipeline.setupCache.shaderStages[1].module, nullptr);
+        // The pipeline itself is owned by pipelineVariants
+        vkDestroyPipelineLayout(app.device, pipeline.pipelineLayout, nullptr);
 
         if(pipeline.textureSampler != nullptr) {
             vkDestroySampler(app.device, pipeline.textureSampler, nullptr);
@@ -97,6 +100,15 @@ void cleanup(VulkanApplication& app)
         }
     }
 
+    destroyPipelineVariants(app.device, app.pipelineVariants);
+    destroyImageAssets(app);
+    destroyTextureTable(app.device, app.textures);
+
+    if(app.transformsBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(app.device, app.transformsBuffer, nullptr);
+        vkFreeMemory(app.device, app.transformsMemory, nullptr);
+    }
+
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
         vkDestroySemaphore(app.device, app.renderFinishedSemaphores[i], nullptr);
         vkDestroySemaphore(app.device, app.imageAvailableSemaphores[i], nullptr);
@@ -110,10 +122,16 @@ void cleanup(VulkanApplication& app)
         DestroyDebugUtilsMessengerEXT(app.instance, debugUtilsMessenger, nullptr);
     }
 
-    vkDestroySurfaceKHR(app.instance, app.surface, nullptr);
+    if(app.surface != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(app.instance, app.surface, nullptr);
+    }
+
     vkDestroyInstance(app.instance, nullptr);
-    glfwDestroyWindow(app.window);
-    glfwTerminate();
+
+    if(app.window != nullptr) {
+        glfwDestroyWindow(app.window);
+        glfwTerminate();
+    }
 }
 
 void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT& debugMessenger, const VkAllocationCallbacks* pAllocator) {
@@ -127,14 +145,17 @@ void initializeVulkan(VulkanApplication& app)
 {
 
     initWindow(&app.window);
-    createInstance(&app.instance);
+    createInstance(&app.instance, false);
     setupDebugMessenger(app.instance, debugUtilsMessenger);
 
     assert(debugUtilsMessenger != nullptr);
 
     createSurface(app.instance, app.window, &app.surface);
     pickPhysicalDevice(app.instance, app.physicalDevice, app.surface);
-    createLogicalDevice(app.physicalDevice, &app.device, app.graphicsQueue, app.presentQueue, app.surface);
+
+    app.descriptorIndexingEnabled = vconfig::ENABLE_DESCRIPTOR_INDEXING && supportsDescriptorIndexing(app.instance, app.physicalDevice);
+    app.memoryBudgetEnabled = supportsMemoryBudget(app.physicalDevice);
+    createLogicalDevice(app.physicalDevice, &app.device, app.graphicsQueue, app.presentQueue, app.surface, app.descriptorIndexingEnabled, app.memoryBudgetEnabled);
 
     createSwapChain(   app.physicalDevice,
                        app.device,
@@ -170,6 +191,26 @@ void initializeVulkan(VulkanApplication& app)
     }
 }
 
+// No window or surface is created. A null surface is what tells device selection and creation
+// not to require presentation support or the swapchain extension
+void initializeVulkanHeadless(VulkanApplication& app, uint32_t width, uint32_t height)
+{
+    app.isHeadless = true;
+    app.swapChainImageFinalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    app.swapChainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+
+    createInstance(&app.instance, true);
+    setupDebugMessenger(app.instance, debugUtilsMessenger);
+
+    pickPhysicalDevice(app.instance, app.physicalDevice, VK_NULL_HANDLE);
+
+    app.descriptorIndexingEnabled = vconfig::ENABLE_DESCRIPTOR_INDEXING && supportsDescriptorIndexing(app.instance, app.physicalDevice);
+    app.memoryBudgetEnabled = supportsMemoryBudget(app.physicalDevice);
+    createLogicalDevice(app.physicalDevice, &app.device, app.graphicsQueue, app.presentQueue, VK_NULL_HANDLE, app.descriptorIndexingEnabled, app.memoryBudgetEnabled);
+
+    createOffscreenImages(app, width, height, vconfig::HEADLESS_IMAGE_COUNT);
+}
+
 void initWindow(GLFWwindow ** window)
 {
     glfwInit();
@@ -217,7 +258,13 @@ QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice device, const VkSurf
         }
 
         VkBool32 presentSupport = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+
+        if(surface != VK_NULL_HANDLE) {
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+        } else {
+            // Headless, nothing is presented so the graphics queue stands in for the present queue
+            presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+        }
 
         if (queueFamily.queueCount > 0 && presentSupport) {
             indices.presentFamily = i;
@@ -233,7 +280,7 @@ QueueFamilyIndices findQueueFamilies(const VkPhysicalDevice device, const VkSurf
     return indices;
 }
 
-VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
+VkSurfaceFormatKHR chooseSwapSurfaceFormat(const decltype(SwapChainSupportDetails::formats)& availableFormats)
 {
     for (const auto& availableFormat : availableFormats) {
         if (availableFormat.format == VK_FORMAT_B8G8R8A8_UNORM && availableFormat.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
@@ -244,7 +291,7 @@ VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>
     return availableFormats[0];
 }
 
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
+VkPresentModeKHR chooseSwapPresentMode(const decltype(SwapChainSupportDetails::presentModes)& availablePresentModes)
 {
     for (const auto& availablePresentMode : availablePresentModes) {
         if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
@@ -361,16 +408,18 @@ SwapChainSupportDetails querySwapChainSupport(const VkPhysicalDevice& device, co
     vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, nullptr);
 
     if (formatCount != 0) {
-        details.formats.resize(formatCount);
+        formatCount = std::min(formatCount, details.formats.capacity());
         vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, details.formats.data());
+        details.formats.resize(formatCount);
     }
 
     uint32_t presentModeCount;
     vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, nullptr);
 
     if (presentModeCount != 0) {
-        details.presentModes.resize(presentModeCount);
+        presentModeCount = std::min(presentModeCount, details.presentModes.capacity());
         vkGetPhysicalDeviceSurfacePresentModesKHR(device, surface, &presentModeCount, details.presentModes.data());
+        details.presentModes.resize(presentModeCount);
     }
 
     return details;
@@ -380,6 +429,10 @@ bool isDeviceSuitable(const VkPhysicalDevice& device, const VkSurfaceKHR& surfac
 {
     QueueFamilyIndices indices = findQueueFamilies(device, surface);
 
+    if(surface == VK_NULL_HANDLE) {
+        return indices.isComplete();
+    }
+
     bool extensionsSupported = checkDeviceExtensionSupport(device);
 
     bool swapChainAdequate = false;
@@ -415,7 +468,7 @@ void pickPhysicalDevice(VkInstance instance, VkPhysicalDevice& physicalDevice, V
     }
 }
 
-void createLogicalDevice(const VkPhysicalDevice physicalDevice, VkDevice * device, VkQueue& graphicsQueue, VkQueue& presentQueue, const VkSurfaceKHR surface)
+void createLogicalDevice(const VkPhysicalDevice physicalDevice, VkDevice * device, VkQueue& graphicsQueue, VkQueue& presentQueue, const VkSurfaceKHR surface, bool enableDescriptorIndexing, bool enableMemoryBudget)
 {
     QueueFamilyIndices indices = findQueueFamilies(physicalDevice, surface);
 
@@ -444,8 +497,35 @@ void createLogicalDevice(const VkPhysicalDevice physicalDevice, VkDevice * devic
 
     createInfo.pEnabledFeatures = &deviceFeatures;
 
-    createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-    createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+    // Swapchain extension isn't required (Or necessarily available) when running headless
+    std::vector<const char*> enabledExtensions;
+
+    if(surface != VK_NULL_HANDLE) {
+        enabledExtensions = deviceExtensions;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    if(enableDescriptorIndexing)
+    {
+        enabledExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+        enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+
+        indexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        indexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        indexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        indexingFeatures.runtimeDescriptorArray = VK_TRUE;
+
+        createInfo.pNext = &indexingFeatures;
+    }
+
+    if(enableMemoryBudget) {
+        enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+    createInfo.ppEnabledExtensionNames = (enabledExtensions.empty()) ? nullptr : enabledExtensions.data();
 
     if (enableValidationLayers) {
         createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -487,22 +567,41 @@ bool checkValidationLayerSupport() {
     return true;
 }
 
-std::vector<const char*> getRequiredExtensions()
+std::vector<const char*> getRequiredExtensions(bool headless)
 {
-    uint32_t glfwExtensionCount = 0;
-    const char** glfwExtensions;
-    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    std::vector<const char*> extensions;
 
-    std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    if(! headless)
+    {
+        uint32_t glfwExtensionCount = 0;
+        const char** glfwExtensions;
+        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+        extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+    }
 
     if (enableValidationLayers) {
         extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
 
+    // Needed to query descriptor indexing support on a 1.0 instance. Optional, without it textures aren't bindless
+    uint32_t availableCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(availableCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &availableCount, availableExtensions.data());
+
+    for (const auto& extension : availableExtensions) {
+        if (strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+            break;
+        }
+    }
+
     return extensions;
 }
 
-void createInstance(VkInstance * instance)
+void createInstance(VkInstance * instance, bool headless)
 {
     if (enableValidationLayers && !checkValidationLayerSupport()) {
         throw std::runtime_error("validation layers requested, but not available!");
@@ -520,7 +619,7 @@ void createInstance(VkInstance * instance)
     createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
     createInfo.pApplicationInfo = &appInfo;
 
-    auto extensions = getRequiredExtensions();
+    auto extensions = getRequiredExtensions(headless);
     createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
     createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -41,10 +41,11 @@ struct QueueFamilyIndices {
     }
 };
 
+// Queried on every swapchain recreate. Anything past the capacities is ignored (As with VK_INCOMPLETE)
 struct SwapChainSupportDetails {
     VkSurfaceCapabilitiesKHR capabilities;
-    std::vector<VkSurfaceFormatKHR> formats;
-    std::vector<VkPresentModeKHR> presentModes;
+    FixedVector<VkSurfaceFormatKHR, 64> formats;
+    FixedVector<VkPresentModeKHR, 8> presentModes;
 };
 
 void cleanupSwapChain(VulkanApplication& app, std::vector<VulkanApplicationPipeline *> pipelines);
@@ -53,9 +54,10 @@ void cleanup(VulkanApplication& app);
 
 SwapChainSupportDetails querySwapChainSupport(const VkPhysicalDevice& device, const VkSurfaceKHR& surface);
 void initializeVulkan(VulkanApplication& app);
+void initializeVulkanHeadless(VulkanApplication& app, uint32_t width, uint32_t height);
 bool checkValidationLayerSupport();
-void createInstance(VkInstance * instance);
-std::vector<const char*> getRequiredExtensions();
+void createInstance(VkInstance * instance, bool headless);
+std::vector<const char*> getRequiredExtensions(bool headless);
 void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
 void setupDebugMessenger(VkInstance& instance, VkDebugUtilsMessengerEXT& debugMessenger);
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(    VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
@@ -71,8 +73,8 @@ VkResult CreateDebugUtilsMessengerEXT(  VkInstance instance,
 void DestroyDebugUtilsMessengerEXT(VkInstance instance, VkDebugUtilsMessengerEXT& debugMessenger, const VkAllocationCallbacks* pAllocator);
 
 VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities, GLFWwindow * window);
-VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
-VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
+VkPresentModeKHR chooseSwapPresentMode(const decltype(SwapChainSupportDetails::presentModes)& availablePresentModes);
+VkSurfaceFormatKHR chooseSwapSurfaceFormat(const decltype(SwapChainSupportDetails::formats)& availableFormats);
 
 void createSwapChain(   VkPhysicalDevice physicalDevice,
                         VkDevice device,
@@ -90,7 +92,8 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice& device);
 
 void createSurface(VkInstance instance, GLFWwindow * window, VkSurfaceKHR * surface);
 void pickPhysicalDevice(VkInstance instance, VkPhysicalDevice& physicalDevice, VkSurfaceKHR surface);
-void createLogicalDevice(const VkPhysicalDevice physicalDevice, VkDevice * device, VkQueue& graphicsQueue, VkQueue& presentQueue, const VkSurfaceKHR surface);
+// enableDescriptorIndexing also enables the features the bindless texture table needs (See texturetable.h)
+void createLogicalDevice(const VkPhysicalDevice physicalDevice, VkDevice * device, VkQueue& graphicsQueue, VkQueue& presentQueue, const VkSurfaceKHR surface, bool enableDescriptorIndexing, bool enableMemoryBudget);
 
 void initWindow(GLFWwindow ** window);
 
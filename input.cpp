@@ -1,6 +1,78 @@
 #include "input.h"
 
+static_assert((Input::QUEUE_CAPACITY & (Input::QUEUE_CAPACITY - 1)) == 0, "Input::QUEUE_CAPACITY must be a power of 2");
+
 Input::Input()
 {
 
 }
+
+void Input::pushCursorMove(double xPos, double yPos)
+{
+    // Only the latest position matters for hit testing
+    InputEvent * last = tail();
+
+    if(last && last->type == InputEventType::CURSOR_MOVE) {
+        last->x = xPos;
+        last->y = yPos;
+        return;
+    }
+
+    push({ InputEventType::CURSOR_MOVE, 0, 0, 0, xPos, yPos });
+}
+
+void Input::pushMouseButton(int button, int action, int mods)
+{
+    push({ InputEventType::MOUSE_BUTTON, static_cast<uint8_t>(action), static_cast<uint16_t>(mods), button, 0.0, 0.0 });
+}
+
+void Input::pushKey(int key, int action, int mods)
+{
+    push({ InputEventType::KEY, static_cast<uint8_t>(action), static_cast<uint16_t>(mods), key, 0.0, 0.0 });
+}
+
+void Input::pushScroll(double xOffset, double yOffset)
+{
+    InputEvent * last = tail();
+
+    if(last && last->type == InputEventType::SCROLL) {
+        last->x += xOffset;
+        last->y += yOffset;
+        return;
+    }
+
+    push({ InputEventType::SCROLL, 0, 0, 0, xOffset, yOffset });
+}
+
+bool Input::pop(InputEvent& event)
+{
+    if(count == 0) {
+        return false;
+    }
+
+    event = events[head];
+    head = (head + 1) & (QUEUE_CAPACITY - 1);
+    count--;
+
+    return true;
+}
+
+InputEvent * Input::tail()
+{
+    if(count == 0) {
+        return nullptr;
+    }
+
+    return &events[(head + count - 1) & (QUEUE_CAPACITY - 1)];
+}
+
+void Input::push(const InputEvent& event)
+{
+    if(count == QUEUE_CAPACITY) {
+        numDropped++;
+        return;
+    }
+
+    events[(head + count) & (QUEUE_CAPACITY - 1)] = event;
+    count++;
+}
@@ -1,11 +1,55 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include <stdint.h>
 
+enum class InputEventType : uint8_t { CURSOR_MOVE = 0, MOUSE_BUTTON, KEY, SCROLL };
+
+// Positions are window pixels and scroll offsets are as given by GLFW. code is the GLFW button or key
+struct InputEvent
+{
+    InputEventType type;
+    uint8_t action;
+    uint16_t mods;
+    int32_t code;
+    double x;
+    double y;
+};
+
+// Preallocated queue of input events. GLFW callbacks only push, and the queue is drained once per frame (See processInput).
+// Consecutive cursor moves are coalesced into the latest position and consecutive scrolls are summed, so a fast
+// mouse can't grow the work done per frame. Events that arrive while the queue is full are dropped
 class Input
 {
 public:
+    static const constexpr uint32_t QUEUE_CAPACITY = 256;
+
     Input();
+
+    void pushCursorMove(double xPos, double yPos);
+    void pushMouseButton(int button, int action, int mods);
+    void pushKey(int key, int action, int mods);
+    void pushScroll(double xOffset, double yOffset);
+
+    // Removes the oldest event. Returns false if the queue is empty
+    bool pop(InputEvent& event);
+
+    inline uint32_t size() const {
+        return count;
+    }
+
+    inline uint64_t droppedEvents() const {
+        return numDropped;
+    }
+
+private:
+    InputEvent * tail();
+    void push(const InputEvent& event);
+
+    InputEvent events[QUEUE_CAPACITY];
+    uint32_t head = 0;
+    uint32_t count = 0;
+    uint64_t numDropped = 0;
 };
 
 #endif // INPUT_H
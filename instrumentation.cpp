@@ -0,0 +1,283 @@
+#include "instrumentation.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace instrumentation {
+
+    static constexpr uint32_t SAMPLE_RING_CAPACITY = 4096;
+
+    static SampleRing<PhaseSample, SAMPLE_RING_CAPACITY> sampleRing;
+    static LatencyHistogram histograms[static_cast<uint8_t>(FramePhase::SIZE)];
+    static uint32_t currentFrameIndex = 0;
+
+    static VkQueryPool timestampQueryPool = VK_NULL_HANDLE;
+    static double timestampPeriodNs = 1.0;
+    static std::vector<bool> gpuFramePending;
+
+    const char * framePhaseName(FramePhase phase)
+    {
+        switch(phase)
+        {
+            case FramePhase::INPUT: return "input";
+            case FramePhase::PER_FRAME_OPERATIONS: return "per_frame_operations";
+            case FramePhase::ANIMATIONS: return "animations";
+            case FramePhase::LAYOUT: return "layout";
+            case FramePhase::TRANSFORMS: return "transforms";
+            case FramePhase::IMAGES: return "images";
+            case FramePhase::COMMAND_RECORDING: return "command_recording";
+            case FramePhase::FENCE_WAIT: return "fence_wait";
+            case FramePhase::ACQUIRE: return "acquire";
+            case FramePhase::SUBMIT: return "submit";
+            case FramePhase::PRESENT: return "present";
+            case FramePhase::GPU_FRAME: return "gpu_frame";
+            default: return "unknown";
+        }
+    }
+
+    static uint16_t bucketIndex(uint64_t value)
+    {
+        if(value < (1u << LatencyHistogram::SUB_BUCKET_BITS)) {
+            return static_cast<uint16_t>(value);
+        }
+
+        const uint8_t msb = static_cast<uint8_t>(63 - __builtin_clzll(value));
+        const uint8_t subBucket = static_cast<uint8_t>((value >> (msb - LatencyHistogram::SUB_BUCKET_BITS)) & ((1u << LatencyHistogram::SUB_BUCKET_BITS) - 1));
+
+        return static_cast<uint16_t>(((msb - LatencyHistogram::SUB_BUCKET_BITS + 1) << LatencyHistogram::SUB_BUCKET_BITS) + subBucket);
+    }
+
+    // Returns the midpoint of the range covered by a bucket
+    static uint64_t bucketValue(uint16_t index)
+    {
+        if(index < (1u << LatencyHistogram::SUB_BUCKET_BITS)) {
+            return index;
+        }
+
+        const uint8_t msb = static_cast<uint8_t>((index >> LatencyHistogram::SUB_BUCKET_BITS) + LatencyHistogram::SUB_BUCKET_BITS - 1);
+        const uint64_t subBucket = index & ((1u << LatencyHistogram::SUB_BUCKET_BITS) - 1);
+        const uint8_t shift = msb - LatencyHistogram::SUB_BUCKET_BITS;
+
+        const uint64_t lowerBound = ((1ull << LatencyHistogram::SUB_BUCKET_BITS) + subBucket) << shift;
+        return lowerBound + ((1ull << shift) >> 1);
+    }
+
+    void LatencyHistogram::record(uint64_t durationNs)
+    {
+        counts[bucketIndex(durationNs)]++;
+        totalCount++;
+        sumNs += durationNs;
+
+        if(durationNs > maxNs) {
+            maxNs = durationNs;
+        }
+    }
+
+    uint64_t LatencyHistogram::percentile(double percent) const
+    {
+        if(totalCount == 0) {
+            return 0;
+        }
+
+        uint64_t target = static_cast<uint64_t>((percent / 100.0) * static_cast<double>(totalCount) + 0.5);
+
+        if(target == 0) {
+            target = 1;
+        }
+
+        uint64_t cumulative = 0;
+
+        for(uint16_t i = 0; i < NUM_BUCKETS; i++)
+        {
+            cumulative += counts[i];
+
+            if(cumulative >= target) {
+                return (bucketValue(i) < maxNs) ? bucketValue(i) : maxNs;
+            }
+        }
+
+        return maxNs;
+    }
+
+    void initialize(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t numCommandBuffers)
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        if(! properties.limits.timestampComputeAndGraphics) {
+            puts("Warning: Device doesn't support timestamp queries, GPU timings disabled");
+            return;
+        }
+
+        timestampPeriodNs = static_cast<double>(properties.limits.timestampPeriod);
+
+        VkQueryPoolCreateInfo queryPoolInfo = {};
+        queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount = numCommandBuffers * 2;
+
+        if(vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timestampQueryPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+
+        gpuFramePending.assign(numCommandBuffers, false);
+    }
+
+    void shutdown(VkDevice device)
+    {
+        if(timestampQueryPool != VK_NULL_HANDLE) {
+            vkDestroyQueryPool(device, timestampQueryPool, nullptr);
+            timestampQueryPool = VK_NULL_HANDLE;
+        }
+
+        gpuFramePending.clear();
+    }
+
+    void beginFrame()
+    {
+        currentFrameIndex++;
+    }
+
+    void recordPhase(FramePhase phase, uint64_t durationNs)
+    {
+        sampleRing.push({ currentFrameIndex, phase, durationNs });
+    }
+
+    void writeGpuFrameBegin(VkCommandBuffer commandBuffer, uint32_t commandBufferIndex)
+    {
+        if(timestampQueryPool == VK_NULL_HANDLE || commandBufferIndex >= gpuFramePending.size()) {
+            return;
+        }
+
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool, commandBufferIndex * 2, 2);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampQueryPool, commandBufferIndex * 2);
+    }
+
+    void writeGpuFrameEnd(VkCommandBuffer commandBuffer, uint32_t commandBufferIndex)
+    {
+        if(timestampQueryPool == VK_NULL_HANDLE || commandBufferIndex >= gpuFramePending.size()) {
+            return;
+        }
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampQueryPool, (commandBufferIndex * 2) + 1);
+    }
+
+    void markGpuFrameSubmitted(uint32_t commandBufferIndex)
+    {
+        if(commandBufferIndex < gpuFramePending.size()) {
+            gpuFramePending[commandBufferIndex] = true;
+        }
+    }
+
+    void collectGpuTimestamps(VkDevice device)
+    {
+        for(uint32_t i = 0; i < gpuFramePending.size(); i++)
+        {
+            if(! gpuFramePending[i]) {
+                continue;
+            }
+
+            uint64_t timestamps[2];
+
+            if(vkGetQueryPoolResults(device, timestampQueryPool, i * 2, 2, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+                continue;
+            }
+
+            gpuFramePending[i] = false;
+
+            if(timestamps[1] > timestamps[0]) {
+                recordPhase(FramePhase::GPU_FRAME, static_cast<uint64_t>(static_cast<double>(timestamps[1] - timestamps[0]) * timestampPeriodNs));
+            }
+        }
+    }
+
+    void aggregate()
+    {
+        PhaseSample sample;
+
+        while(sampleRing.pop(sample)) {
+            histograms[static_cast<uint8_t>(sample.phase)].record(sample.durationNs);
+        }
+    }
+
+    void printSummary()
+    {
+        aggregate();
+
+        printf("%-22s %8s %10s %10s %10s %10s\n", "phase", "count", "p50 (us)", "p95 (us)", "p99 (us)", "max (us)");
+
+        for(uint8_t i = 0; i < static_cast<uint8_t>(FramePhase::SIZE); i++)
+        {
+            const LatencyHistogram& histogram = histograms[i];
+
+            if(histogram.totalCount == 0) {
+                continue;
+            }
+
+            printf("%-22s %8llu %10.1f %10.1f %10.1f %10.1f\n",
+                   framePhaseName(static_cast<FramePhase>(i)),
+                   static_cast<unsigned long long>(histogram.totalCount),
+                   histogram.percentile(50.0) / 1000.0,
+                   histogram.percentile(95.0) / 1000.0,
+                   histogram.percentile(99.0) / 1000.0,
+                   histogram.maxNs / 1000.0);
+        }
+    }
+
+    bool dump(const char * path)
+    {
+        aggregate();
+
+        FILE * file = fopen(path, "w");
+
+        if(file == nullptr) {
+            printf("Failed to open '%s' for writing instrumentation data\n", path);
+            return false;
+        }
+
+        const size_t pathLength = strlen(path);
+        const bool writeCSV = (pathLength >= 4 && strcmp(path + pathLength - 4, ".csv") == 0);
+
+        if(writeCSV) {
+            fputs("phase,count,mean_us,p50_us,p95_us,p99_us,max_us\n", file);
+        } else {
+            fprintf(file, "{\n  \"frames\": %u,\n  \"droppedSamples\": %u,\n  \"phases\": [\n", currentFrameIndex, sampleRing.numDropped);
+        }
+
+        bool firstEntry = true;
+
+        for(uint8_t i = 0; i < static_cast<uint8_t>(FramePhase::SIZE); i++)
+        {
+            const LatencyHistogram& histogram = histograms[i];
+            const char * name = framePhaseName(static_cast<FramePhase>(i));
+
+            const double meanUs = histogram.meanNs() / 1000.0;
+            const double p50Us = histogram.percentile(50.0) / 1000.0;
+            const double p95Us = histogram.percentile(95.0) / 1000.0;
+            const double p99Us = histogram.percentile(99.0) / 1000.0;
+            const double maxUs = histogram.maxNs / 1000.0;
+            const unsigned long long count = static_cast<unsigned long long>(histogram.totalCount);
+
+            if(writeCSV) {
+                fprintf(file, "%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f\n", name, count, meanUs, p50Us, p95Us, p99Us, maxUs);
+                continue;
+            }
+
+            fprintf(file, "%s    { \"name\": \"%s\", \"count\": %llu, \"meanUs\": %.3f, \"p50Us\": %.3f, \"p95Us\": %.3f, \"p99Us\": %.3f, \"maxUs\": %.3f }",
+                    (firstEntry) ? "" : ",\n", name, count, meanUs, p50Us, p95Us, p99Us, maxUs);
+
+            firstEntry = false;
+        }
+
+        if(! writeCSV) {
+            fputs("\n  ]\n}\n", file);
+        }
+
+        fclose(file);
+        printf("Instrumentation data written to '%s'\n", path);
+
+        return true;
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+// Frame timing instrumentation
+// Enabled with the ENABLE_INSTRUMENTATION CMake option, which defines VKGUI_ENABLE_INSTRUMENTATION.
+// When disabled, every INSTRUMENT_* macro expands to nothing so there is no cost in release builds
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+namespace instrumentation {
+
+    enum class FramePhase : uint8_t { INPUT = 0, PER_FRAME_OPERATIONS, ANIMATIONS, LAYOUT, TRANSFORMS, IMAGES, COMMAND_RECORDING, FENCE_WAIT, ACQUIRE, SUBMIT, PRESENT, GPU_FRAME, SIZE };
+
+    const char * framePhaseName(FramePhase phase);
+
+    struct PhaseSample
+    {
+        uint32_t frameIndex;
+        FramePhase phase;
+        uint64_t durationNs;
+    };
+
+    // Single producer (render thread) / single consumer ring. Samples are dropped rather than blocking when full
+    template <typename T, uint32_t Capacity>
+    struct SampleRing
+    {
+        static_assert((Capacity & (Capacity - 1)) == 0, "SampleRing capacity must be a power of 2");
+
+        T samples[Capacity];
+        std::atomic<uint32_t> head { 0 };
+        std::atomic<uint32_t> tail { 0 };
+        uint32_t numDropped = 0;
+
+        inline bool push(const T& sample)
+        {
+            const uint32_t currentHead = head.load(std::memory_order_relaxed);
+
+            if(currentHead - tail.load(std::memory_order_acquire) == Capacity) {
+                numDropped++;
+                return false;
+            }
+
+            samples[currentHead & (Capacity - 1)] = sample;
+            head.store(currentHead + 1, std::memory_order_release);
+            return true;
+        }
+
+        inline bool pop(T& outSample)
+        {
+            const uint32_t currentTail = tail.load(std::memory_order_relaxed);
+
+            if(currentTail == head.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            outSample = samples[currentTail & (Capacity - 1)];
+            tail.store(currentTail + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    // Log-linear histogram over nanoseconds. Each power of 2 is split into 8 sub buckets (~12% precision)
+    struct LatencyHistogram
+    {
+        static constexpr uint8_t SUB_BUCKET_BITS = 3;
+        static constexpr uint16_t NUM_BUCKETS = 64 << SUB_BUCKET_BITS;
+
+        uint32_t counts[NUM_BUCKETS] = {};
+        uint64_t totalCount = 0;
+        uint64_t sumNs = 0;
+        uint64_t maxNs = 0;
+
+        void record(uint64_t durationNs);
+        uint64_t percentile(double percent) const;
+        uint64_t meanNs() const { return (totalCount == 0) ? 0 : sumNs / totalCount; }
+    };
+
+    void initialize(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t numCommandBuffers);
+    void shutdown(VkDevice device);
+
+    void beginFrame();
+    void recordPhase(FramePhase phase, uint64_t durationNs);
+
+    // GPU timestamps are written at the top and bottom of each command buffer
+    void writeGpuFrameBegin(VkCommandBuffer commandBuffer, uint32_t commandBufferIndex);
+    void writeGpuFrameEnd(VkCommandBuffer commandBuffer, uint32_t commandBufferIndex);
+    void markGpuFrameSubmitted(uint32_t commandBufferIndex);
+    // Must be called once the device is idle and before command buffers are re-recorded
+    void collectGpuTimestamps(VkDevice device);
+
+    // Moves samples out of the ring and into the histograms
+    void aggregate();
+    void printSummary();
+    // Writes CSV if the path ends in ".csv", otherwise JSON
+    bool dump(const char * path);
+
+    class ScopedPhaseTimer
+    {
+    public:
+        explicit ScopedPhaseTimer(FramePhase phase)
+            : phase(phase), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopedPhaseTimer()
+        {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            recordPhase(phase, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+    private:
+        FramePhase phase;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#define INSTRUMENT_CONCAT_IMPL(a, b) a##b
+#define INSTRUMENT_CONCAT(a, b) INSTRUMENT_CONCAT_IMPL(a, b)
+
+#ifdef VKGUI_ENABLE_INSTRUMENTATION
+    #define INSTRUMENT_PHASE(phase) instrumentation::ScopedPhaseTimer INSTRUMENT_CONCAT(phaseTimer_, __LINE__)(instrumentation::FramePhase::phase)
+    #define INSTRUMENT_INITIALIZE(device, physicalDevice, numCommandBuffers) instrumentation::initialize(device, physicalDevice, numCommandBuffers)
+    #define INSTRUMENT_SHUTDOWN(device) instrumentation::shutdown(device)
+    #define INSTRUMENT_BEGIN_FRAME() instrumentation::beginFrame()
+    #define INSTRUMENT_GPU_FRAME_BEGIN(commandBuffer, index) instrumentation::writeGpuFrameBegin(commandBuffer, index)
+    #define INSTRUMENT_GPU_FRAME_END(commandBuffer, index) instrumentation::writeGpuFrameEnd(commandBuffer, index)
+    #define INSTRUMENT_GPU_FRAME_SUBMITTED(index) instrumentation::markGpuFrameSubmitted(index)
+    #define INSTRUMENT_COLLECT_GPU(device) instrumentation::collectGpuTimestamps(device)
+    #define INSTRUMENT_AGGREGATE() instrumentation::aggregate()
+    #define INSTRUMENT_PRINT_SUMMARY() instrumentation::printSummary()
+    #define INSTRUMENT_DUMP(path) instrumentation::dump(path)
+#else
+    #define INSTRUMENT_PHASE(phase)
+    #define INSTRUMENT_INITIALIZE(device, physicalDevice, numCommandBuffers)
+    #define INSTRUMENT_SHUTDOWN(device)
+    #define INSTRUMENT_BEGIN_FRAME()
+    #define INSTRUMENT_GPU_FRAME_BEGIN(commandBuffer, index)
+    #define INSTRUMENT_GPU_FRAME_END(commandBuffer, index)
+    #define INSTRUMENT_GPU_FRAME_SUBMITTED(index)
+    #define INSTRUMENT_COLLECT_GPU(device)
+    #define INSTRUMENT_AGGREGATE()
+    #define INSTRUMENT_PRINT_SUMMARY()
+    #define INSTRUMENT_DUMP(path)
+#endif
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,545 @@
+#include "layout.h"
+
+#include <cassert>
+#include <algorithm>
+
+static int32_t resolveLength(const LayoutLength& length, int32_t available, int32_t measuredSize)
+{
+    switch(length.unit)
+    {
+        case LayoutUnit::FIXED: return length.value;
+        case LayoutUnit::PERCENT: return static_cast<int32_t>((static_cast<int64_t>(available) * length.value) / fixed16::ONE);
+        default: return measuredSize;
+    }
+}
+
+// Main axis is x for ROW and y for COLUMN
+static inline int32_t mainOf(const LayoutSize& size, bool row) {
+    return row ? size.width : size.height;
+}
+
+static inline int32_t crossOf(const LayoutSize& size, bool row) {
+    return row ? size.height : size.width;
+}
+
+void LayoutTree::reserve(uint32_t maxNodes)
+{
+    assert(maxNodes > 0);
+
+    capacity = maxNodes;
+
+    styles.reserve(capacity);
+    contentSizes.reserve(capacity);
+    measured.reserve(capacity);
+    rects.reserve(capacity);
+    owners.reserve(capacity);
+    parents.reserve(capacity);
+    firstChildren.reserve(capacity);
+    lastChildren.reserve(capacity);
+    nextSiblings.reserve(capacity);
+    depths.reserve(capacity);
+    measureDirty.reserve(capacity);
+    layoutDirty.reserve(capacity);
+    dirtyNodes.reserve(capacity);
+    walkStack.reserve(capacity);
+    changedNodes.reserve(capacity);
+
+    styles.assign(1, LayoutStyle());
+    contentSizes.assign(1, { 0, 0 });
+    measured.assign(1, { 0, 0 });
+    rects.assign(1, { 0, 0, 0, 0 });
+    owners.assign(1, NO_OWNER);
+    parents.assign(1, INVALID_NODE);
+    firstChildren.assign(1, INVALID_NODE);
+    lastChildren.assign(1, INVALID_NODE);
+    nextSiblings.assign(1, INVALID_NODE);
+    depths.assign(1, 0);
+    measureDirty.assign(1, 1);
+    layoutDirty.assign(1, 1);
+    dirtyNodes.assign(1, ROOT);
+
+    freeNodes.clear();
+    changedNodes.clear();
+}
+
+uint32_t LayoutTree::create(uint32_t parent, const LayoutStyle& style)
+{
+    assert(isValid(parent) && "Invalid parent layout node");
+
+    uint32_t node;
+
+    if(! freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else
+    {
+        if(styles.size() == capacity) {
+            return INVALID_NODE;
+        }
+
+        node = static_cast<uint32_t>(styles.size());
+
+        styles.push_back({});
+        contentSizes.push_back({});
+        measured.push_back({});
+        rects.push_back({});
+        owners.push_back(NO_OWNER);
+        parents.push_back(INVALID_NODE);
+        firstChildren.push_back(INVALID_NODE);
+        lastChildren.push_back(INVALID_NODE);
+        nextSiblings.push_back(INVALID_NODE);
+        depths.push_back(0);
+        measureDirty.push_back(0);
+        layoutDirty.push_back(0);
+    }
+
+    styles[node] = style;
+    contentSizes[node] = { 0, 0 };
+    measured[node] = { 0, 0 };
+    rects[node] = { 0, 0, 0, 0 };
+    owners[node] = NO_OWNER;
+    firstChildren[node] = INVALID_NODE;
+    lastChildren[node] = INVALID_NODE;
+    nextSiblings[node] = INVALID_NODE;
+    depths[node] = static_cast<uint16_t>(depths[parent] + 1);
+
+    parents[node] = parent;
+
+    if(lastChildren[parent] == INVALID_NODE) {
+        firstChildren[parent] = node;
+    } else {
+        nextSiblings[lastChildren[parent]] = node;
+    }
+
+    lastChildren[parent] = node;
+
+    markMeasureDirty(node);
+    markLayoutDirty(node);
+    markLayoutDirty(parent);
+
+    return node;
+}
+
+void LayoutTree::release(uint32_t node)
+{
+    assert(node != ROOT && isValid(node));
+
+    const uint32_t parent = parents[node];
+
+    unlink(node);
+    markMeasureDirty(parent);
+    markLayoutDirty(parent);
+
+    walkStack.clear();
+    walkStack.push_back(node);
+
+    while(! walkStack.empty())
+    {
+        const uint32_t released = walkStack.back();
+        walkStack.pop_back();
+
+        for(uint32_t child = firstChildren[released]; child != INVALID_NODE; child = nextSiblings[child]) {
+            walkStack.push_back(child);
+        }
+
+        parents[released] = INVALID_NODE;
+        firstChildren[released] = INVALID_NODE;
+        lastChildren[released] = INVALID_NODE;
+        nextSiblings[released] = INVALID_NODE;
+        owners[released] = NO_OWNER;
+
+        // Left in dirtyNodes if it's there, update skips released nodes
+        measureDirty[released] = 0;
+        layoutDirty[released] = 0;
+
+        freeNodes.push_back(released);
+    }
+}
+
+void LayoutTree::setStyle(uint32_t node, const LayoutStyle& style)
+{
+    assert(isValid(node));
+
+    styles[node] = style;
+
+    // Affects how the node places its children, and where its parent places it
+    markMeasureDirty(node);
+    markLayoutDirty(node);
+
+    if(node != ROOT) {
+        markLayoutDirty(parents[node]);
+    }
+}
+
+void LayoutTree::setContentSize(uint32_t node, int32_t width, int32_t height)
+{
+    assert(isValid(node));
+
+    if(contentSizes[node].width == width && contentSizes[node].height == height) {
+        return;
+    }
+
+    contentSizes[node] = { width, height };
+    markMeasureDirty(node);
+}
+
+uint32_t LayoutTree::update(const FixedRect& viewport)
+{
+    changedNodes.clear();
+
+    if(measureDirty[ROOT]) {
+        measure(ROOT);
+    }
+
+    const FixedRect& rootRect = rects[ROOT];
+
+    if(rootRect.left != viewport.left || rootRect.top != viewport.top || rootRect.right != viewport.right || rootRect.bottom != viewport.bottom)
+    {
+        rects[ROOT] = viewport;
+        changedNodes.push_back(ROOT);
+        markLayoutDirty(ROOT);
+    }
+
+    // Parents before children, so a rect is final before it's used to place anything
+    std::sort(dirtyNodes.begin(), dirtyNodes.end(), [&](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+    for(uint32_t root : dirtyNodes)
+    {
+        // Released, or already placed while walking an ancestor
+        if(! layoutDirty[root]) {
+            continue;
+        }
+
+        walkStack.clear();
+        walkStack.push_back(root);
+
+        while(! walkStack.empty())
+        {
+            const uint32_t node = walkStack.back();
+            walkStack.pop_back();
+
+            layoutDirty[node] = 0;
+            placeChildren(node);
+
+            // Children that moved, resized or were already dirty
+            for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+            {
+                if(layoutDirty[child]) {
+                    walkStack.push_back(child);
+                }
+            }
+        }
+    }
+
+    dirtyNodes.clear();
+
+    return static_cast<uint32_t>(changedNodes.size());
+}
+
+void LayoutTree::markMeasureDirty(uint32_t node)
+{
+    // Anything above an already dirty node is dirty too
+    for(; node != INVALID_NODE && ! measureDirty[node]; node = parents[node]) {
+        measureDirty[node] = 1;
+    }
+}
+
+void LayoutTree::markLayoutDirty(uint32_t node)
+{
+    if(! layoutDirty[node]) {
+        layoutDirty[node] = 1;
+        dirtyNodes.push_back(node);
+    }
+}
+
+// Only walks into children that are dirty, everything else uses the cached measurement
+void LayoutTree::measure(uint32_t node)
+{
+    const LayoutStyle& style = styles[node];
+
+    LayoutSize content = contentSizes[node];
+
+    if(firstChildren[node] != INVALID_NODE)
+    {
+        const bool grid = (style.kind == LayoutKind::GRID);
+        const bool row = (style.kind == LayoutKind::ROW);
+        const uint32_t columns = std::max<uint32_t>(style.columns, 1);
+
+        int32_t main = 0;
+        int32_t cross = 0;
+        int32_t gridWidth = 0;
+        int32_t gridHeight = 0;
+        int32_t rowHeight = 0;
+        uint32_t numInFlow = 0;
+
+        for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+        {
+            if(measureDirty[child]) {
+                measure(child);
+            }
+
+            if(styles[child].absolute) {
+                continue;
+            }
+
+            const LayoutSize& childSize = measured[child];
+
+            if(grid)
+            {
+                gridWidth = std::max(gridWidth, childSize.width);
+                rowHeight = std::max(rowHeight, childSize.height);
+
+                if((numInFlow % columns) == columns - 1) {
+                    gridHeight += rowHeight + style.gap;
+                    rowHeight = 0;
+                }
+            } else
+            {
+                main += mainOf(childSize, row);
+                cross = std::max(cross, crossOf(childSize, row));
+            }
+
+            numInFlow++;
+        }
+
+        if(numInFlow > 0)
+        {
+            if(grid)
+            {
+                const uint32_t usedColumns = std::min(numInFlow, columns);
+
+                // Last row isn't full
+                if((numInFlow % columns) != 0) {
+                    gridHeight += rowHeight + style.gap;
+                }
+
+                content.width = gridWidth * static_cast<int32_t>(usedColumns) + style.gap * static_cast<int32_t>(usedColumns - 1);
+                content.height = gridHeight - style.gap;
+            } else
+            {
+                main += style.gap * static_cast<int32_t>(numInFlow - 1);
+                content = row ? LayoutSize { main, cross } : LayoutSize { cross, main };
+            }
+        }
+    }
+
+    const LayoutSize size = {
+        resolveLength(style.width, 0, content.width + style.padding * 2),
+        resolveLength(style.height, 0, content.height + style.padding * 2)
+    };
+
+    measureDirty[node] = 0;
+
+    if(size.width != measured[node].width || size.height != measured[node].height)
+    {
+        measured[node] = size;
+
+        if(node != ROOT) {
+            markLayoutDirty(parents[node]);
+        }
+    }
+}
+
+void LayoutTree::placeChild(uint32_t child, int32_t left, int32_t top, int32_t width, int32_t height)
+{
+    FixedRect& rect = rects[child];
+
+    if(rect.left == left && rect.top == top && rect.right == left + width && rect.bottom == top + height) {
+        return;
+    }
+
+    rect = { left, top, left + width, top + height };
+    changedNodes.push_back(child);
+
+    // Its own children are placed relative to it
+    layoutDirty[child] = 1;
+}
+
+void LayoutTree::placeChildren(uint32_t node)
+{
+    if(firstChildren[node] == INVALID_NODE) {
+        return;
+    }
+
+    const LayoutStyle& style = styles[node];
+    const FixedRect& rect = rects[node];
+
+    const int32_t contentLeft = rect.left + style.padding;
+    const int32_t contentTop = rect.top + style.padding;
+    const LayoutSize content = {
+        std::max(rect.right - rect.left - style.padding * 2, 0),
+        std::max(rect.bottom - rect.top - style.padding * 2, 0)
+    };
+
+    uint32_t numInFlow = 0;
+    uint32_t totalGrow = 0;
+
+    for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+    {
+        const LayoutStyle& childStyle = styles[child];
+
+        if(childStyle.absolute)
+        {
+            placeChild( child,
+                        contentLeft + childStyle.left,
+                        contentTop + childStyle.top,
+                        resolveLength(childStyle.width, content.width, measured[child].width),
+                        resolveLength(childStyle.height, content.height, measured[child].height) );
+            continue;
+        }
+
+        numInFlow++;
+        totalGrow += childStyle.grow;
+    }
+
+    if(numInFlow == 0) {
+        return;
+    }
+
+    if(style.kind == LayoutKind::GRID)
+    {
+        const int32_t columns = std::max<int32_t>(style.columns, 1);
+        const int32_t numRows = (static_cast<int32_t>(numInFlow) + columns - 1) / columns;
+        const int32_t cellWidth = std::max((content.width - style.gap * (columns - 1)) / columns, 0);
+
+        rowSizes.assign(numRows, 0);
+
+        int32_t index = 0;
+
+        for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+        {
+            const LayoutStyle& childStyle = styles[child];
+
+            if(! childStyle.absolute)
+            {
+                int32_t& rowSize = rowSizes[index / columns];
+                rowSize = std::max(rowSize, resolveLength(childStyle.height, content.height, measured[child].height));
+                index++;
+            }
+        }
+
+        index = 0;
+        int32_t rowTop = contentTop;
+
+        for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+        {
+            const LayoutStyle& childStyle = styles[child];
+
+            if(childStyle.absolute) {
+                continue;
+            }
+
+            const int32_t column = index % columns;
+            const int32_t rowSize = rowSizes[index / columns];
+
+            const int32_t width = (childStyle.width.unit == LayoutUnit::AUTO) ? cellWidth : resolveLength(childStyle.width, cellWidth, 0);
+            const int32_t height = (childStyle.height.unit == LayoutUnit::AUTO) ? rowSize : resolveLength(childStyle.height, rowSize, 0);
+
+            placeChild(child, contentLeft + column * (cellWidth + style.gap), rowTop, width, height);
+
+            index++;
+
+            if(column == columns - 1) {
+                rowTop += rowSize + style.gap;
+            }
+        }
+
+        return;
+    }
+
+    const bool row = (style.kind == LayoutKind::ROW);
+
+    const int32_t availableMain = mainOf(content, row);
+    const int32_t availableCross = crossOf(content, row);
+
+    int32_t usedMain = style.gap * static_cast<int32_t>(numInFlow - 1);
+
+    for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+    {
+        const LayoutStyle& childStyle = styles[child];
+
+        if(! childStyle.absolute) {
+            usedMain += resolveLength(row ? childStyle.width : childStyle.height, availableMain, mainOf(measured[child], row));
+        }
+    }
+
+    const int32_t freeMain = std::max(availableMain - usedMain, 0);
+
+    int32_t position = row ? contentLeft : contentTop;
+    int32_t remainingGrow = static_cast<int32_t>(totalGrow);
+    int32_t remainingFree = freeMain;
+
+    for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child])
+    {
+        const LayoutStyle& childStyle = styles[child];
+
+        if(childStyle.absolute) {
+            continue;
+        }
+
+        const LayoutLength& mainLength = row ? childStyle.width : childStyle.height;
+        const LayoutLength& crossLength = row ? childStyle.height : childStyle.width;
+
+        int32_t mainSize = resolveLength(mainLength, availableMain, mainOf(measured[child], row));
+
+        // The last growing child takes whatever is left, so rounding never leaves a gap at the end
+        if(childStyle.grow > 0)
+        {
+            const int32_t extra = (remainingGrow == childStyle.grow)
+                                  ? remainingFree
+                                  : static_cast<int32_t>((static_cast<int64_t>(freeMain) * childStyle.grow) / totalGrow);
+
+            mainSize += extra;
+            remainingFree -= extra;
+            remainingGrow -= childStyle.grow;
+        }
+
+        int32_t crossSize;
+
+        if(style.align == LayoutAlign::STRETCH && crossLength.unit == LayoutUnit::AUTO) {
+            crossSize = availableCross;
+        } else {
+            crossSize = resolveLength(crossLength, availableCross, crossOf(measured[child], row));
+        }
+
+        int32_t crossOffset = 0;
+
+        if(style.align == LayoutAlign::CENTER) {
+            crossOffset = (availableCross - crossSize) / 2;
+        } else if(style.align == LayoutAlign::END) {
+            crossOffset = availableCross - crossSize;
+        }
+
+        if(row) {
+            placeChild(child, position, contentTop + crossOffset, mainSize, crossSize);
+        } else {
+            placeChild(child, contentLeft + crossOffset, position, crossSize, mainSize);
+        }
+
+        position += mainSize + style.gap;
+    }
+}
+
+void LayoutTree::unlink(uint32_t node)
+{
+    const uint32_t parent = parents[node];
+
+    uint32_t previous = INVALID_NODE;
+
+    for(uint32_t sibling = firstChildren[parent]; sibling != node; sibling = nextSiblings[sibling]) {
+        previous = sibling;
+    }
+
+    if(previous == INVALID_NODE) {
+        firstChildren[parent] = nextSiblings[node];
+    } else {
+        nextSiblings[previous] = nextSiblings[node];
+    }
+
+    if(lastChildren[parent] == node) {
+        lastChildren[parent] = previous;
+    }
+
+    nextSiblings[node] = INVALID_NODE;
+}
@@ -0,0 +1,126 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "fixedpoint.h"
+
+// Retained layout tree. Nodes are sized and placed inside their parent according to a LayoutStyle, and the results are
+// kept between updates. Changing a style or a content size only marks that node's path to the root for measuring,
+// and only the parents whose children could move are placed again, so an update after a single change touches the
+// changed node's ancestors and siblings rather than the whole tree.
+//
+// Everything is in fixed16 units (See fixedpoint.h). Percentages are also in fixed16 units, where ONE is 100%
+
+enum class LayoutUnit : uint8_t { AUTO = 0, FIXED, PERCENT };
+
+// How a node places the children that aren't absolute
+enum class LayoutKind : uint8_t { COLUMN = 0, ROW, GRID };
+
+// Cross axis alignment of ROW and COLUMN children
+enum class LayoutAlign : uint8_t { START = 0, CENTER, END, STRETCH };
+
+// AUTO is the measured size, FIXED is `value` and PERCENT is `value` of the parent's content box
+struct LayoutLength
+{
+    LayoutUnit unit;
+    int32_t value;
+};
+
+struct LayoutSize
+{
+    int32_t width;
+    int32_t height;
+};
+
+struct LayoutStyle
+{
+    LayoutKind kind = LayoutKind::COLUMN;
+    LayoutAlign align = LayoutAlign::START;
+
+    // Placed at left / top inside the parent's content box, and left out of the parent's flow and measured size
+    bool absolute = false;
+
+    LayoutLength width = { LayoutUnit::AUTO, 0 };
+    LayoutLength height = { LayoutUnit::AUTO, 0 };
+
+    int32_t left = 0;
+    int32_t top = 0;
+
+    int32_t padding = 0;
+    int32_t gap = 0;        // Between children, on both axes for GRID
+
+    // Share of the space left on the parent's main axis. Only used by ROW and COLUMN parents
+    uint16_t grow = 0;
+
+    // Children fill their cell unless they have a FIXED or PERCENT size. Rows are as tall as their tallest child
+    uint16_t columns = 1;
+};
+
+struct LayoutTree
+{
+    static const constexpr uint32_t ROOT = 0;
+    static const constexpr uint32_t INVALID_NODE = UINT32_MAX;
+    static const constexpr uint32_t NO_OWNER = UINT32_MAX;
+
+    std::vector<LayoutStyle> styles;
+    std::vector<LayoutSize> contentSizes;   // Set on leaves, E.g. the size of some text
+    std::vector<LayoutSize> measured;       // Size the node wants, cached until its subtree changes
+    std::vector<FixedRect> rects;           // Right and bottom are left + width and top + height
+    std::vector<uint32_t> owners;           // Left to the caller, E.g. the Entity32 placed by the node
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> firstChildren;
+    std::vector<uint32_t> lastChildren;
+    std::vector<uint32_t> nextSiblings;
+    std::vector<uint16_t> depths;
+    std::vector<uint8_t> measureDirty;      // Set on every node between a change and the root
+    std::vector<uint8_t> layoutDirty;       // Children need placing again
+    std::vector<uint32_t> dirtyNodes;
+    std::vector<uint32_t> freeNodes;
+    std::vector<uint32_t> walkStack;        // Scratch space for update and release
+    std::vector<int32_t> rowSizes;          // Scratch space for GRID
+
+    // Nodes whose rect changed in the last update
+    std::vector<uint32_t> changedNodes;
+
+    uint32_t capacity = 0;
+
+    void reserve(uint32_t maxNodes);
+
+    // Appended after the parent's last child. Returns INVALID_NODE if capacity nodes are in use
+    uint32_t create(uint32_t parent, const LayoutStyle& style);
+
+    // Releases the node and everything under it
+    void release(uint32_t node);
+
+    void setStyle(uint32_t node, const LayoutStyle& style);
+    void setContentSize(uint32_t node, int32_t width, int32_t height);
+
+    // Measures and places everything that changed since the last update, with ROOT filling viewport.
+    // Returns the number of nodes written to changedNodes
+    uint32_t update(const FixedRect& viewport);
+
+    inline const LayoutStyle& styleOf(uint32_t node) const {
+        return styles[node];
+    }
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(styles.size() - freeNodes.size());
+    }
+
+    inline bool isValid(uint32_t node) const {
+        return node < parents.size() && (node == ROOT || parents[node] != INVALID_NODE);
+    }
+
+private:
+
+    void markMeasureDirty(uint32_t node);
+    void markLayoutDirty(uint32_t node);
+    void measure(uint32_t node);
+    void placeChildren(uint32_t node);
+    void placeChild(uint32_t child, int32_t left, int32_t top, int32_t width, int32_t height);
+    void unlink(uint32_t node);
+};
+
+#endif // LAYOUT_H
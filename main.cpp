@@ -0,0 +1,51 @@
+#include "mainvulkan.h"
+
+int main(int argc, char ** argv)
+{
+    // Usage: vulkanGui [--headless] [--frames <count>] [--output <path.png>] [--expect <path.png>]
+    bool headless = false;
+    uint32_t numHeadlessFrames = vconfig::DEFAULT_HEADLESS_FRAMES;
+    const char * outputImagePath = nullptr;
+    const char * expectedImagePath = nullptr;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if(strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            numHeadlessFrames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        } else if(strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputImagePath = argv[++i];
+        } else if(strcmp(argv[i], "--expect") == 0 && i + 1 < argc) {
+            expectedImagePath = argv[++i];
+        } else {
+            printf("Unknown argument '%s'\n", argv[i]);
+            return 1;
+        }
+    }
+
+    VulkanApplication app = setupApplication(headless);
+    INSTRUMENT_INITIALIZE(app.device, app.physicalDevice, static_cast<uint32_t>(app.swapChainImages.size()));
+
+    loadInitialMeshData(app, 0);
+
+    bool frameMatches = true;
+
+    if(headless) {
+        frameMatches = headlessLoop(app, numHeadlessFrames, outputImagePath, expectedImagePath);
+    } else {
+        mainLoop(app);
+    }
+
+    INSTRUMENT_PRINT_SUMMARY();
+    INSTRUMENT_DUMP(vconfig::INSTRUMENTATION_OUTPUT_PATH);
+    INSTRUMENT_SHUTDOWN(app.device);
+
+    TRACE_WRITE(vconfig::TRACE_OUTPUT_PATH);
+
+    cleanup(app);
+
+    puts("Clean termination");
+
+    return frameMatches ? 0 : 1;
+}
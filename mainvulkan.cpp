@@ -2,6 +2,7 @@
 
 static size_t currentFrame = 0;
 static bool framebufferResized = false;
+static bool redrawRequired = true;
 
 static double updatedFrameWidthRatio = 1.0;
 static double updatedFrameHeightRatio = 1.0;
@@ -12,10 +13,110 @@ static uint16_t currentWindowWidth = vconfig::INITIAL_WINDOW_WIDTH;
 const uint8_t VERTICES_PER_SQUARE = 4;
 const uint8_t INDICES_PER_SQUARE = 6;
 
+// Bounds that can contain the cursor at once, the same as the length of activeBoundsIndices
+const uint8_t MAX_HOVER_HITS = 10;
+
+// Scroll steps in each direction that are run per scroll event
+const int32_t MAX_SCROLL_STEPS = 8;
+
+// Binding of the transforms storage buffer in every pipeline's descriptor set layout. Textures are in their own set
+// (See TextureTable), binding 0 is unused
+const uint32_t TRANSFORMS_BINDING = 1;
+
+// Every pipeline is a variant of the UI shaders (See shadervariants.h). The fragment shader is built with and without
+// BINDLESS, as sampling the texture table through a runtime array needs capabilities that only bindless devices have
+const char * const UI_VERTEX_SHADER_PATH = "shaders/ui_vert.spv";
+const char * const UI_FRAGMENT_SHADER_PATH = "shaders/ui_frag.spv";
+const char * const UI_BINDLESS_FRAGMENT_SHADER_PATH = "shaders/ui_frag_bindless.spv";
+
+static VkDescriptorSetLayoutBinding transformsLayoutBinding()
+{
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = TRANSFORMS_BINDING;
+    binding.descriptorCount = 1;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.pImmutableSamplers = nullptr;
+    binding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+    return binding;
+}
+
+// Creates the descriptor pool and one descriptor set per swapchain image for every pipeline with a descriptor set layout.
+// These only hold the transforms buffer, the texture table's set is created once at startup
+static void createDescriptorSets(VulkanApplication& app)
+{
+    const uint32_t numImages = static_cast<uint32_t>(app.swapChainImages.size());
+
+    std::array<VkDescriptorPoolSize, 1> descriptorPoolSizes = {};
+
+    descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    descriptorPoolSizes[0].descriptorCount = numImages * PipelineType::SIZE;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
+    poolInfo.pPoolSizes = descriptorPoolSizes.data();
+    poolInfo.maxSets = numImages * PipelineType::SIZE;
+
+    if (vkCreateDescriptorPool(app.device, &poolInfo, nullptr, &app.descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create descriptor pool!");
+    }
+
+    for(VulkanApplicationPipeline& pipeline : app.pipelines)
+    {
+        if(pipeline.descriptorSetLayout == nullptr) {
+            continue;
+        }
+
+        VkDescriptorSetLayout * layouts = app.frameArena.allocate<VkDescriptorSetLayout>(numImages);
+        std::fill(layouts, layouts + numImages, pipeline.descriptorSetLayout);
+
+        VkDescriptorSetAllocateInfo descriptorAllocInfo = {};
+        descriptorAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        descriptorAllocInfo.descriptorPool = app.descriptorPool;
+        descriptorAllocInfo.descriptorSetCount = numImages;
+        descriptorAllocInfo.pSetLayouts = layouts;
+
+        pipeline.descriptorSets.resize(numImages);
+
+        if (vkAllocateDescriptorSets(app.device, &descriptorAllocInfo, pipeline.descriptorSets.data()) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate descriptor sets!");
+        }
+
+        VkDescriptorBufferInfo transformsInfo = {};
+        transformsInfo.buffer = app.transformsBuffer;
+        transformsInfo.offset = 0;
+        transformsInfo.range = VK_WHOLE_SIZE;
+
+        for (size_t i = 0; i < numImages; i++)
+        {
+            VkWriteDescriptorSet transformsWrite = {};
+            transformsWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            transformsWrite.dstSet = pipeline.descriptorSets[i];
+            transformsWrite.dstBinding = TRANSFORMS_BINDING;
+            transformsWrite.dstArrayElement = 0;
+            transformsWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            transformsWrite.descriptorCount = 1;
+            transformsWrite.pBufferInfo = &transformsInfo;
+
+            vkUpdateDescriptorSets(app.device, 1, &transformsWrite, 0, nullptr);
+        }
+    }
+}
+
 void recreateSwapChain(VulkanApplication& app)
 {
+    TRACE_FUNCTION();
+
     int width = 0, height = 0;
 
+    // In headless mode the new size has already been written to swapChainExtent (See resizeHeadless)
+    if(app.isHeadless)
+    {
+        width = static_cast<int>(app.swapChainExtent.width);
+        height = static_cast<int>(app.swapChainExtent.height);
+    }
+
     while(width == 0 || height == 0)
     {
         glfwGetFramebufferSize(app.window, &width, &height);
@@ -26,12 +127,17 @@ void recreateSwapChain(VulkanApplication& app)
 
     cleanupSwapChain(app);
 
-    createSwapChain(app.physicalDevice, app.device, app.surface, app.swapChain, app.swapChainImages, app.swapChainImageFormat, app.swapChainExtent, app.window);
+    if(app.isHeadless) {
+        createOffscreenImages(app, static_cast<uint32_t>(width), static_cast<uint32_t>(height), vconfig::HEADLESS_IMAGE_COUNT);
+    } else {
+        createSwapChain(app.physicalDevice, app.device, app.surface, app.swapChain, app.swapChainImages, app.swapChainImageFormat, app.swapChainExtent, app.window);
+    }
 
     // Create Image View BEGIN
     app.swapChainImageViews.resize(app.swapChainImages.size());
 
-    for (size_t i = 0; i < app.swapChainImages.size(); i++)
+    // Offscreen images already have their views created
+    for (size_t i = 0; i < app.swapChainImages.size() && !app.isHeadless; i++)
     {
         VkImageViewCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -63,8 +169,6 @@ void recreateSwapChain(VulkanApplication& app)
 
     for(VulkanApplicationPipeline& pipeline : app.pipelines)
     {
-        vkDestroyDescriptorSetLayout(app.device, pipeline.descriptorSetLayout, nullptr);
-
         GenericGraphicsPipelineTargets pipelineSetup
         {
             & pipeline.graphicsPipeline,
@@ -74,7 +178,7 @@ void recreateSwapChain(VulkanApplication& app)
             & pipeline.swapChainFramebuffers
         };
 
-        if(! updateGenericGraphicsPipeline(app.device, app.swapChainExtent, app.swapChainImageViews, static_cast<uint8_t>(app.swapChainImages.size()), pipelineSetup, pipeline.setupCache)) {
+        if(! updateGenericGraphicsPipeline(app.device, app.pipelineVariants, app.swapChainExtent, app.swapChainImageViews, static_cast<uint8_t>(app.swapChainImages.size()), pipelineSetup, pipeline.setupCache)) {
             throw std::runtime_error("Failed to update pipeline");
         }
 
@@ -105,77 +209,24 @@ void recreateSwapChain(VulkanApplication& app)
 
             currentVertex += vertexStride;
         }
+
+        app.frameStats.bytesUploaded += numVertices * sizeof(glm::vec2);
     }
 
+    // Transforms are in the same space as the vertices they apply to, so they're remapped the same way
+    const float widthScale = static_cast<float>(1.0 / updatedFrameWidthRatio);
+    const float heightScale = static_cast<float>(1.0 / updatedFrameHeightRatio);
+
+    app.entitySystem.transforms.remap(  { widthScale, 0.0f, 0.0f, heightScale, widthScale - 1.0f, heightScale - 1.0f },
+                                        { 1.0f / widthScale, 0.0f, 0.0f, 1.0f / heightScale, 1.0f / widthScale - 1.0f, 1.0f / heightScale - 1.0f } );
+
     assert(width > 0);
     assert(height > 0);
 
     currentWindowWidth = static_cast<uint16_t>(width);
     currentWindowHeight = static_cast<uint16_t>(height);
 
-    // Create Description Pool Begin
-
-    std::array<VkDescriptorPoolSize, 1> descriptorPoolSizes = {};
-
-    descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorPoolSizes[0].descriptorCount = static_cast<uint32_t>(app.swapChainImages.size());
-
-    VkDescriptorPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-    poolInfo.pPoolSizes = descriptorPoolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(app.swapChainImages.size());
-
-    if (vkCreateDescriptorPool(app.device, &poolInfo, nullptr, &app.descriptorPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-
-    // Create Description Pool END
-
-    for(VulkanApplicationPipeline& pipeline : app.pipelines)
-    {
-        if(pipeline.descriptorSetLayout != nullptr)
-        {
-            std::vector<VkDescriptorSetLayout> layouts(app.swapChainImages.size(), pipeline.descriptorSetLayout);
-
-            VkDescriptorSetAllocateInfo descriptorAllocInfo = {};
-            descriptorAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-            descriptorAllocInfo.descriptorPool = app.descriptorPool;
-            descriptorAllocInfo.descriptorSetCount = static_cast<uint32_t>(app.swapChainImages.size());
-            descriptorAllocInfo.pSetLayouts = layouts.data();
-
-            pipeline.descriptorSets.resize(app.swapChainImages.size());
-
-            if (vkAllocateDescriptorSets(app.device, &descriptorAllocInfo, pipeline.descriptorSets.data()) != VK_SUCCESS) {
-                throw std::runtime_error("failed to allocate descriptor sets!");
-            }
-
-            // TODO: This isn't generic..
-            for (size_t i = 0; i < app.swapChainImages.size(); i++) {
-
-                VkDescriptorImageInfo imageInfo = {};
-
-                imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                imageInfo.imageView = pipeline.textureImageView;
-                imageInfo.sampler = pipeline.textureSampler;
-
-                assert(pipeline.textureImageView && "Image view -> null");
-                assert(pipeline.textureSampler && "Sampler -> null");
-
-                std::array<VkWriteDescriptorSet, 1> descriptorWrites = {};
-
-                descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrites[0].dstSet = pipeline.descriptorSets[i];
-                descriptorWrites[0].dstBinding = 0;
-                descriptorWrites[0].dstArrayElement = 0;
-                descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptorWrites[0].descriptorCount = 1;
-                descriptorWrites[0].pImageInfo = &imageInfo;
-
-                vkUpdateDescriptorSets(app.device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-            }
-        }
-    }
+    createDescriptorSets(app);
 
     app.commandBuffers.resize(app.swapChainImages.size());
 
@@ -192,77 +243,32 @@ void recreateSwapChain(VulkanApplication& app)
         throw std::runtime_error("failed to allocate command buffers!");
     }
 
-    VkClearValue clearColor = { /* .color = */  {  /* .float32 = */  { 1.0f, 1.0f, 1.0f, 1.0f } } };
-
-    for (size_t i = 0; i < app.commandBuffers.size(); i++)
-    {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-        if (vkBeginCommandBuffer(app.commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
-
-        for(size_t layerIndex = 0; layerIndex < PipelineType::SIZE; layerIndex++)
-        {
-            VulkanApplicationPipeline& pipeline = app.pipelines[ app.pipelineDrawOrder[layerIndex] ];
-
-            VkRenderPassBeginInfo renderPassInfo = {};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = pipeline.renderPass;
-            renderPassInfo.framebuffer = pipeline.swapChainFramebuffers[i];
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = app.swapChainExtent;
-
-            bool requiresInitialClear = (layerIndex == 0);
-
-            renderPassInfo.clearValueCount = (requiresInitialClear) ? 1 : 0;
-            renderPassInfo.pClearValues = (requiresInitialClear) ? &clearColor : nullptr;
-
-            vkCmdBeginRenderPass(app.commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-                vkCmdBindPipeline(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.graphicsPipeline);
-
-                VkBuffer vertexBuffers[] = {pipeline.vertexBuffer};
-                VkDeviceSize offsets[] = {0};
-                vkCmdBindVertexBuffers(app.commandBuffers[i], 0, 1, vertexBuffers, offsets);
-
-                vkCmdBindIndexBuffer(app.commandBuffers[i], pipeline.indexBuffer, 0, VK_INDEX_TYPE_UINT16);
-
-                if(pipeline.pipelineLayout != nullptr && pipeline.descriptorSets.size() != 0) {
-                    vkCmdBindDescriptorSets(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout, 0, 1, &pipeline.descriptorSets[i], 0, nullptr);
-                }
-
-                vkCmdDrawIndexed(app.commandBuffers[i], pipeline.numIndices, 1, 0, 0, 0);
-
-            vkCmdEndRenderPass(app.commandBuffers[i]);
-        }
-
-        if (vkEndCommandBuffer(app.commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to record command buffer!");
-        }
-    }
-}
-
-int main()
-{
-    VulkanApplication app = setupApplication();
-    loadInitialMeshData(app, 0);
-
-    mainLoop(app);
-    cleanup(app);
-
-    puts("Clean termination");
-
-    return 1;
+    recordCommandBuffers(app);
 }
 
 void drawFrame(VulkanApplication& app)
 {
-    vkWaitForFences(app.device, 1, & app.inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    TRACE_FUNCTION();
+
+    {
+        INSTRUMENT_PHASE(FENCE_WAIT);
+        TRACE_SCOPE("vkWaitForFences");
+        vkWaitForFences(app.device, 1, & app.inFlightFences[currentFrame], VK_TRUE, UINT64_MAX);
+    }
 
     uint32_t imageIndex;
-    VkResult result = vkAcquireNextImageKHR(app.device, app.swapChain, UINT64_MAX, app.imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    VkResult result;
+
+    if(app.isHeadless)
+    {
+        imageIndex = acquireOffscreenImage(app);
+        result = VK_SUCCESS;
+    } else
+    {
+        INSTRUMENT_PHASE(ACQUIRE);
+        TRACE_SCOPE("vkAcquireNextImageKHR");
+        result = vkAcquireNextImageKHR(app.device, app.swapChain, UINT64_MAX, app.imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         recreateSwapChain(app);
@@ -274,9 +280,10 @@ void drawFrame(VulkanApplication& app)
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+    // Offscreen images aren't acquired or presented, so there's nothing to synchronize with other than the fence
     VkSemaphore waitSemaphores[] = { app.imageAvailableSemaphores[currentFrame]};
     VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
+    submitInfo.waitSemaphoreCount = (app.isHeadless) ? 0 : 1;
     submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
 
@@ -284,13 +291,27 @@ void drawFrame(VulkanApplication& app)
     submitInfo.pCommandBuffers = &app.commandBuffers[imageIndex];
 
     VkSemaphore signalSemaphores[] = { app.renderFinishedSemaphores[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.signalSemaphoreCount = (app.isHeadless) ? 0 : 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
     vkResetFences(app.device, 1, & app.inFlightFences[currentFrame]);
 
-    if (vkQueueSubmit(app.graphicsQueue, 1, &submitInfo, app.inFlightFences[currentFrame]) != VK_SUCCESS) {
-        throw std::runtime_error("failed to submit draw command buffer!");
+    {
+        INSTRUMENT_PHASE(SUBMIT);
+        TRACE_SCOPE("vkQueueSubmit");
+
+        if (vkQueueSubmit(app.graphicsQueue, 1, &submitInfo, app.inFlightFences[currentFrame]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit draw command buffer!");
+        }
+    }
+
+    INSTRUMENT_GPU_FRAME_SUBMITTED(imageIndex);
+
+    app.lastRenderedImage = imageIndex;
+
+    if(app.isHeadless) {
+        currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+        return;
     }
 
     VkPresentInfoKHR presentInfo = {};
@@ -305,7 +326,11 @@ void drawFrame(VulkanApplication& app)
 
     presentInfo.pImageIndices = &imageIndex;
 
-    result = vkQueuePresentKHR(app.presentQueue, &presentInfo);
+    {
+        INSTRUMENT_PHASE(PRESENT);
+        TRACE_SCOPE("vkQueuePresentKHR");
+        result = vkQueuePresentKHR(app.presentQueue, &presentInfo);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || framebufferResized)
     {
@@ -318,55 +343,176 @@ void drawFrame(VulkanApplication& app)
     currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 }
 
-void mainLoop(VulkanApplication& app)
+static std::chrono::nanoseconds queryFramePeriod(GLFWwindow * window)
 {
-    using namespace std::chrono_literals;
+    GLFWmonitor * monitor = glfwGetWindowMonitor(window);
+
+    if(monitor == nullptr) {
+        monitor = glfwGetPrimaryMonitor();
+    }
 
-    uint32_t framesPerSec = 0;
+    const GLFWvidmode * videoMode = (monitor != nullptr) ? glfwGetVideoMode(monitor) : nullptr;
+    const int refreshRate = (videoMode != nullptr && videoMode->refreshRate > 0) ? videoMode->refreshRate : vconfig::FALLBACK_REFRESH_RATE;
 
-    constexpr uint16_t targetFPS = 50;
-    constexpr std::chrono::duration<long, std::milli> msPerFrame(1000 / targetFPS);
+    return std::chrono::nanoseconds(1000000000 / refreshRate);
+}
 
-    std::chrono::milliseconds sinceLastFPSPrint = 0ms;
+void mainLoop(VulkanApplication& app)
+{
+    using namespace std::chrono_literals;
+    using Clock = std::chrono::steady_clock;
 
-    std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<long, std::milli>>  frameStart;
-    std::chrono::time_point<std::chrono::steady_clock, std::chrono::duration<long, std::milli>>  frameEnd;
+    const std::chrono::nanoseconds framePeriod = queryFramePeriod(app.window);
 
-    std::chrono::duration<long, std::milli> frameLength;
+    Clock::time_point lastAggregate = Clock::now();
+    Clock::time_point lastFrame = Clock::now();
+    Clock::time_point nextFrameDeadline = Clock::now();
 
     while(!glfwWindowShouldClose(app.window))
     {
-        frameStart = std::chrono::time_point_cast<std::chrono::duration<long, std::milli>>( std::chrono::steady_clock::now() );
+        // While something is animating we only poll so the frame deadline below controls pacing.
+        // Otherwise block until input arrives, waking occasionally in case the window was damaged
+        const bool isAnimating = (app.perFrameOperations.count > 0 || app.animations.size() > 0);
+        const bool isPolling = (isAnimating || redrawRequired);
 
-        glfwPollEvents();
-        //glfwWaitEventsTimeout(0.0005);
+        if(!isPolling) {
+            glfwWaitEventsTimeout(vconfig::IDLE_EVENT_WAIT_TIMEOUT_SECONDS);
+        }
 
-        if(sinceLastFPSPrint >= 1000ms)
         {
-            printf("FPS: %d\n", framesPerSec);
-            framesPerSec = 0;
-            sinceLastFPSPrint = 0ms;
+            INSTRUMENT_PHASE(INPUT);
+
+            if(isPolling) {
+                glfwPollEvents();
+            }
+
+            // Callbacks above only queue events, all hit testing and dispatch happens here
+            processInput(app);
         }
 
-        loopLogic(app, msPerFrame);
+        Clock::time_point now = Clock::now();
 
-        drawFrame(app);
-        framesPerSec++;
+        if(now - lastAggregate >= 1s)
+        {
+            INSTRUMENT_AGGREGATE();
+            lastAggregate = now;
+        }
+
+        if(!isAnimating && !redrawRequired)
+        {
+            // Nothing to draw, restart the deadline so the next active frame isn't treated as late
+            nextFrameDeadline = now;
+            lastFrame = now;
+            continue;
+        }
+
+        redrawRequired = false;
 
-        frameEnd = std::chrono::time_point_cast<std::chrono::duration<long, std::milli>>( std::chrono::steady_clock::now() );
-        sinceLastFPSPrint += msPerFrame;
+        INSTRUMENT_BEGIN_FRAME();
 
-        frameLength = frameEnd - frameStart;
+        // Only whole milliseconds are consumed, the remainder carries over so animations don't drift behind real time
+        const std::chrono::milliseconds delta = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastFrame);
+        loopLogic(app, delta);
+        lastFrame += delta;
 
-        if(frameLength >= msPerFrame) {
-            printf("No sleep this frame :(\n");
+        drawFrame(app);
+
+        nextFrameDeadline += framePeriod;
+        now = Clock::now();
+
+        // If we've fallen more than a frame behind, drop the missed frames instead of trying to catch up
+        if(nextFrameDeadline < now - framePeriod) {
+            nextFrameDeadline = now;
             continue;
         }
 
-        std::this_thread::sleep_for(msPerFrame - frameLength);
+        std::this_thread::sleep_until(nextFrameDeadline);
+    }
+
+    vkDeviceWaitIdle(app.device);
+}
+
+// The red square from loadInitialMeshData covers the top left quarter of each axis, and only moves while the cursor is
+// over it, which it never is in headless mode
+static bool exampleSceneRendered(const std::vector<uint8_t>& pixelsRGBA, VkExtent2D extent)
+{
+    const size_t x = extent.width / 8;
+    const size_t y = extent.height / 8;
+    const uint8_t * pixel = pixelsRGBA.data() + (y * extent.width + x) * 4;
+
+    return pixel[0] >= 200 && pixel[1] <= 55 && pixel[2] <= 55;
+}
+
+bool headlessLoop(VulkanApplication& app, uint32_t numFrames, const char * outputImagePath, const char * expectedImagePath)
+{
+    using Clock = std::chrono::steady_clock;
+
+    const Clock::time_point start = Clock::now();
+    Clock::time_point lastFrame = start;
+
+    for(uint32_t i = 0; i < numFrames; i++)
+    {
+        INSTRUMENT_BEGIN_FRAME();
+
+        const std::chrono::milliseconds delta = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - lastFrame);
+        loopLogic(app, delta);
+        lastFrame += delta;
+
+        drawFrame(app);
     }
 
     vkDeviceWaitIdle(app.device);
+
+    const double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    printf("Rendered %u headless frames in %.2fms (%.3fms / frame)\n", numFrames, elapsedMs, (numFrames > 0) ? elapsedMs / numFrames : 0.0);
+
+    if(numFrames == 0) {
+        return true;
+    }
+
+    std::vector<uint8_t> pixels;
+    readbackOffscreenImage(app, app.lastRenderedImage, pixels);
+
+    if(outputImagePath != nullptr && writePNG(outputImagePath, pixels.data(), app.swapChainExtent.width, app.swapChainExtent.height)) {
+        printf("Wrote final frame to '%s'\n", outputImagePath);
+    }
+
+    if(! exampleSceneRendered(pixels, app.swapChainExtent)) {
+        printf("Final frame doesn't show the example scene\n");
+        return false;
+    }
+
+    if(expectedImagePath == nullptr) {
+        return true;
+    }
+
+    std::vector<uint8_t> expectedPixels;
+    uint32_t expectedWidth = 0;
+    uint32_t expectedHeight = 0;
+
+    if(! readImageRGBA(expectedImagePath, expectedPixels, expectedWidth, expectedHeight)) {
+        return false;
+    }
+
+    if(expectedWidth != app.swapChainExtent.width || expectedHeight != app.swapChainExtent.height) {
+        printf("Expected image is %ux%u, the frame is %ux%u\n", expectedWidth, expectedHeight, app.swapChainExtent.width, app.swapChainExtent.height);
+        return false;
+    }
+
+    const uint32_t numDifferent = countDifferentPixels(pixels.data(), expectedPixels.data(), expectedWidth * expectedHeight, vconfig::GOLDEN_IMAGE_TOLERANCE);
+
+    printf("%u pixels differ from '%s'\n", numDifferent, expectedImagePath);
+
+    return numDifferent <= vconfig::GOLDEN_IMAGE_MAX_DIFFERENT_PIXELS;
+}
+
+void resizeHeadless(VulkanApplication& app, uint32_t width, uint32_t height)
+{
+    assert(app.isHeadless);
+    assert(width > 0 && height > 0);
+
+    app.swapChainExtent = { width, height };
+    recreateSwapChain(app);
 }
 
 void createVertexBuffer(    const VkDevice device,
@@ -379,6 +525,7 @@ void createVertexBuffer(    const VkDevice device,
                             VkDeviceMemory& outVertexBufferMemory,
                             void ** outMappedMemory )
 {
+    TRACE_FUNCTION();
 
     if(vertexDataSize == 0) {
         return;
@@ -438,6 +585,8 @@ void createIndexBuffer( const VkDevice device,
                         VkBuffer &outIndicesBuffer,
                         VkDeviceMemory& outIndicesBufferMemory)
 {
+    TRACE_FUNCTION();
+
     VkDeviceSize bufferSize = sizeof(indices[0]) * indices.size();
 
     if(bufferSize == 0) {
@@ -488,58 +637,464 @@ static void framebufferResizeCallback(GLFWwindow* window, int width, int height)
     (void)height;
 
     framebufferResized = true;
+    redrawRequired = true;
 }
 
-void onTimeUpdate(VulkanApplication& app, uint32_t delta)
+static void onKeyEvent(GLFWwindow* window, int key, int scancode, int action, int mods)
 {
-    //    VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
-    VulkanApplicationPipeline& primativeShapesPipeline = app.pipelines[PipelineType::PrimativeShapes];
+    (void)scancode;
 
-    updateAddVertexPositions(   reinterpret_cast<glm::vec2 *>(primativeShapesPipeline.pipelineMappedMemory),
-                                primativeShapesPipeline.numVertices,
-                                primativeShapesPipeline.vertexStride,
-                                static_cast<float>(delta) / 50.0f,
-                                0 );
+    VulkanApplication& app = *reinterpret_cast<VulkanApplication*>( glfwGetWindowUserPointer(window) );
+    app.input.pushKey(key, action, mods);
 }
 
-// TODO: Remove
-void onTimeUpdateExperimental(VulkanApplication& app, uint32_t delta)
+static void onMouseButtonEvent(GLFWwindow* window, int button, int action, int mods)
 {
-    for(uint16_t i = 0; i < app.entitySystem.exampleTimeUpdateListSize; i++) {
-        RelativeDataLocation& verticesTarget = app.entitySystem.verticesComponent[app.entitySystem.exampleTimeUpdateList[i]];
-        updateAddVertexPositions(reinterpret_cast<glm::vec2*>(app.entitySystem.verticesComponentBasePtr + verticesTarget.offsetBytes), verticesTarget.spanElements, verticesTarget.strideBytes, 0.001f, 0.001f);
-    }
+    VulkanApplication& app = *reinterpret_cast<VulkanApplication*>( glfwGetWindowUserPointer(window) );
+    app.input.pushMouseButton(button, action, mods);
 }
 
-void doPerFrameOperations(VulkanApplication& app)
+static void onScrollEvent(GLFWwindow* window, double xOffset, double yOffset)
 {
-    for(uint16_t i = 0; i < app.numPerFrameOperations; i++) {
-        handleOperation(app, app.perFrameOperationIndices[i]);
-    }
+    VulkanApplication& app = *reinterpret_cast<VulkanApplication*>( glfwGetWindowUserPointer(window) );
+    app.input.pushScroll(xOffset, yOffset);
 }
 
-void loopLogic(VulkanApplication& app, std::chrono::milliseconds delta)
+// Number of onLClickOperation / onRClickOperation / onMClickOperation slots (In that order) that are used as extra
+// hover operations. See the hover enter / exit handling in handleCursorMove
+static uint8_t numClickSlotsUsedForHover(const MouseBounds& mouseBounds)
 {
-    doPerFrameOperations(app);
-
-//    updateAddVertexPositions(reinterpret_cast<glm::vec2*>(app.mappedVerticesMemory), 24, sizeof(Vertex), 0.001f, 0.001f);
-
-    VkClearValue clearColor = { /* .color = */  {  /* .float32 = */  { 1.0f, 1.0f, 1.0f, 1.0f } } };
+    if(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_CHAINS) {
+        return 0;
+    }
 
-    vkDeviceWaitIdle(app.device);
+    uint8_t numEnter = 0;
+    uint8_t numExit = 0;
 
-    for (size_t i = 0; i < app.commandBuffers.size(); i++)
+    switch(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_ENTER_MASK)
     {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        case MOUSE_BOUNDS_FLAGS_1_ON_HOVER_ENTER: numEnter = 1; break;
+        case MOUSE_BOUNDS_FLAGS_2_ON_HOVER_ENTER: numEnter = 2; break;
+        case MOUSE_BOUNDS_FLAGS_3_ON_HOVER_ENTER: numEnter = 3; break;
+        default: return 0;
+    }
 
-        if (vkBeginCommandBuffer(app.commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
+    switch(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_EXIT_MASK)
+    {
+        case MOUSE_BOUNDS_FLAGS_1_ON_HOVER_EXIT: numExit = 1; break;
+        case MOUSE_BOUNDS_FLAGS_2_ON_HOVER_EXIT: numExit = 2; break;
+        case MOUSE_BOUNDS_FLAGS_3_ON_HOVER_EXIT: numExit = 3; break;
+    }
 
-        for(size_t layerIndex = 0; layerIndex < PipelineType::SIZE; layerIndex++)
-        {
-            VulkanApplicationPipeline& pipeline = app.pipelines[ app.pipelineDrawOrder[layerIndex] ];
+    // onHoverEnterOperation and onHoverExitOperation hold the first two
+    return (numEnter + numExit > 2) ? numEnter + numExit - 2 : 0;
+}
+
+static void runBinding(VulkanApplication& app, const KeyPressOperation& binding)
+{
+    if(binding.operationIndex == OPERATION_INDEX_INVALID) {
+        return;
+    }
+
+    if(binding.flags & KEY_BINDING_FLAGS_CHAIN) {
+        runOperationChain(app, binding.operationIndex);
+    } else {
+        handleOperation(app, binding.operationIndex);
+    }
+}
+
+void handleKey(VulkanApplication& app, int key, int action, int mods)
+{
+    if(key < 0 || key >= InputBindings::NUM_KEYS) {
+        return;
+    }
+
+    const KeyPressOperation& binding = app.inputBindings.keys[key];
+
+    uint8_t requiredFlag = 0;
+
+    switch(action)
+    {
+        case GLFW_PRESS: requiredFlag = KEY_BINDING_FLAGS_ON_PRESS; break;
+        case GLFW_REPEAT: requiredFlag = KEY_BINDING_FLAGS_ON_REPEAT; break;
+        case GLFW_RELEASE: requiredFlag = KEY_BINDING_FLAGS_ON_RELEASE; break;
+    }
+
+    // Lower 4 bits are shift, control, alt and super
+    if((binding.flags & requiredFlag) && binding.mods == (mods & 0x0F)) {
+        runBinding(app, binding);
+    }
+}
+
+void handleClick(VulkanApplication& app, int button)
+{
+    uint8_t slot = 0;
+
+    switch(button)
+    {
+        case GLFW_MOUSE_BUTTON_LEFT: slot = 0; break;
+        case GLFW_MOUSE_BUTTON_RIGHT: slot = 1; break;
+        case GLFW_MOUSE_BUTTON_MIDDLE: slot = 2; break;
+        default: return;
+    }
+
+    for(uint16_t i = 0; i < app.numHoveredBounds; i++)
+    {
+        const MouseBounds& mouseBounds = app.onMouseEventOpBindings.bounds[ app.hoveredBoundsIndices[i] ];
+
+        if(slot < numClickSlotsUsedForHover(mouseBounds)) {
+            continue;
+        }
+
+        if(slot == 0 && (mouseBounds.flags & MOUSE_BOUNDS_FLAGS_0_ON_LCLICK) == MOUSE_BOUNDS_FLAGS_0_ON_LCLICK) {
+            continue;
+        }
+
+        const OperationIndex clickOperations[3] = { mouseBounds.onLClickOperation, mouseBounds.onRClickOperation, mouseBounds.onMClickOperation };
+        const OperationIndex operation = clickOperations[slot];
+
+        if(operation == OPERATION_INDEX_INVALID) {
+            continue;
+        }
+
+        if(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_CHAINS) {
+            runOperationChain(app, operation);
+        } else {
+            handleOperation(app, operation);
+        }
+    }
+}
+
+void handleScroll(VulkanApplication& app, double xOffset, double yOffset)
+{
+    InputBindings& bindings = app.inputBindings;
+
+    const double totalX = bindings.scrollRemainderX + xOffset;
+    const double totalY = bindings.scrollRemainderY + yOffset;
+
+    // Whole steps only, limited so one huge scroll can't stall a frame
+    const int32_t stepsX = std::max(-MAX_SCROLL_STEPS, std::min(MAX_SCROLL_STEPS, static_cast<int32_t>(totalX)));
+    const int32_t stepsY = std::max(-MAX_SCROLL_STEPS, std::min(MAX_SCROLL_STEPS, static_cast<int32_t>(totalY)));
+
+    bindings.scrollRemainderX = totalX - static_cast<int32_t>(totalX);
+    bindings.scrollRemainderY = totalY - static_cast<int32_t>(totalY);
+
+    for(int32_t i = 0; i < std::abs(stepsY); i++) {
+        runBinding(app, (stepsY > 0) ? bindings.scrollUp : bindings.scrollDown);
+    }
+
+    for(int32_t i = 0; i < std::abs(stepsX); i++) {
+        runBinding(app, (stepsX > 0) ? bindings.scrollRight : bindings.scrollLeft);
+    }
+}
+
+void processInput(VulkanApplication& app)
+{
+    TRACE_FUNCTION();
+
+    InputEvent event;
+
+    while(app.input.pop(event))
+    {
+        switch(event.type)
+        {
+            case InputEventType::CURSOR_MOVE:
+                handleCursorMove(app, event.x, event.y);
+                break;
+            case InputEventType::KEY:
+                if(event.code == GLFW_KEY_F12 && event.action == GLFW_PRESS) {
+                    TRACE_WRITE(vconfig::TRACE_OUTPUT_PATH);
+                    break;
+                }
+
+                handleKey(app, event.code, event.action, event.mods);
+                break;
+            case InputEventType::MOUSE_BUTTON:
+                if(event.action == GLFW_PRESS) {
+                    handleClick(app, event.code);
+                }
+                break;
+            case InputEventType::SCROLL:
+                handleScroll(app, event.x, event.y);
+                break;
+        }
+    }
+}
+
+static void windowRefreshCallback(GLFWwindow* window)
+{
+    (void)window;
+
+    redrawRequired = true;
+}
+
+void requestRedraw()
+{
+    redrawRequired = true;
+}
+
+void onTimeUpdate(VulkanApplication& app, uint32_t delta)
+{
+    //    VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
+    VulkanApplicationPipeline& primativeShapesPipeline = app.pipelines[PipelineType::PrimativeShapes];
+
+    updateAddVertexPositions(   reinterpret_cast<glm::vec2 *>(primativeShapesPipeline.pipelineMappedMemory),
+                                primativeShapesPipeline.numVertices,
+                                primativeShapesPipeline.vertexStride,
+                                static_cast<float>(delta) / 50.0f,
+                                0 );
+}
+
+// Entities with a transform are moved by changing it, everything else has its vertices rewritten.
+// Returns the number of vertices rewritten
+static inline uint32_t moveEntity(VulkanApplication& app, uint32_t entityIndex, float x, float y)
+{
+    EntitySystemHandle& entities = app.entitySystem;
+
+    if(entities.transformComponent.contains(entityIndex)) {
+        entities.transforms.translate(entities.transformComponent.at(entityIndex), x, y);
+        return 0;
+    }
+
+    const RelativeDataLocation& verticesTarget = entities.verticesComponent.at(entityIndex);
+
+    updateAddVertexPositions(   reinterpret_cast<glm::vec2*>(entities.verticesComponentBasePtr + verticesTarget.offsetBytes),
+                                verticesTarget.spanElements,
+                                verticesTarget.strideBytes,
+                                x, y );
+
+    return verticesTarget.spanElements;
+}
+
+// TODO: Remove
+void onTimeUpdateExperimental(VulkanApplication& app, uint32_t delta)
+{
+    for(uint16_t i = 0; i < app.entitySystem.exampleTimeUpdateListSize; i++) {
+        moveEntity(app, app.entitySystem.resolve(app.entitySystem.exampleTimeUpdateList[i]), 0.001f, 0.001f);
+    }
+}
+
+// Points every vertex of the entity at node. Returns the number of bytes written
+static uint32_t writeTransformIndices(EntitySystemHandle& entities, uint32_t entityIndex, uint32_t node)
+{
+    if(! entities.verticesComponent.contains(entityIndex)) {
+        return 0;
+    }
+
+    const RelativeDataLocation& vertices = entities.verticesComponent.at(entityIndex);
+
+    // transformIndex is the last member of every vertex type
+    uint8_t * transformIndex = entities.verticesComponentBasePtr + vertices.offsetBytes + vertices.strideBytes - sizeof(uint32_t);
+
+    for(uint16_t i = 0; i < vertices.spanElements; i++)
+    {
+        *reinterpret_cast<uint32_t *>(transformIndex) = node;
+        transformIndex += vertices.strideBytes;
+    }
+
+    return vertices.spanElements * sizeof(uint32_t);
+}
+
+uint32_t attachTransform(VulkanApplication& app, Entity32 entity, uint32_t parentNode, const Affine2D& localTransform)
+{
+    EntitySystemHandle& entities = app.entitySystem;
+    const uint32_t entityIndex = entities.resolve(entity);
+
+    assert(! entities.transformComponent.contains(entityIndex) && "Entity already has a transform");
+
+    const uint32_t node = entities.transforms.create(parentNode, localTransform);
+
+    if(node == TransformHierarchy::INVALID_NODE) {
+        printf("Transform limit (%u) reached\n", entities.transforms.capacity);
+        return node;
+    }
+
+    entities.transformComponent.set(entityIndex, node);
+    app.frameStats.bytesUploaded += writeTransformIndices(entities, entityIndex, node);
+
+    redrawRequired = true;
+
+    return node;
+}
+
+bool bindLayout(VulkanApplication& app, Entity32 entity, uint32_t layoutNode, NormalizedPoint origin)
+{
+    EntitySystemHandle& entities = app.entitySystem;
+    const uint32_t entityIndex = entities.resolve(entity);
+
+    assert(! entities.layoutComponent.contains(entityIndex) && "Entity is already placed by a layout");
+    assert(! entities.transformComponent.contains(entityIndex) && "Entity already has a transform");
+    assert(app.layout.isValid(layoutNode) && app.layout.owners[layoutNode] == LayoutTree::NO_OWNER);
+
+    const uint32_t transformNode = entities.transforms.create(TransformHierarchy::ROOT, transform::identity());
+
+    if(transformNode == TransformHierarchy::INVALID_NODE) {
+        printf("Transform limit (%u) reached\n", entities.transforms.capacity);
+        return false;
+    }
+
+    if(attachTransform(app, entity, transformNode, transform::identity()) == TransformHierarchy::INVALID_NODE) {
+        entities.transforms.release(transformNode);
+        return false;
+    }
+
+    entities.layoutComponent.set(entityIndex, { layoutNode, transformNode, origin.x.data, origin.y.data });
+    app.layout.owners[layoutNode] = entity;
+
+    // A node that's already been laid out won't be listed as changed until it moves again, so place it now
+    const FixedRect& rect = app.layout.rects[layoutNode];
+    entities.transforms.setLocal(transformNode, transform::translation( fixed16::toFloat(rect.left - origin.x.data),
+                                                                        fixed16::toFloat(rect.top - origin.y.data) ));
+
+    return true;
+}
+
+void applyLayout(VulkanApplication& app)
+{
+    static const FixedRect screen = { NORMFLOAT_MIN, NORMFLOAT_MIN, NORMFLOAT_MAX, NORMFLOAT_MAX };
+
+    if(app.layout.update(screen) == 0) {
+        return;
+    }
+
+    EntitySystemHandle& entities = app.entitySystem;
+
+    for(uint32_t node : app.layout.changedNodes)
+    {
+        const Entity32 owner = app.layout.owners[node];
+
+        if(owner == LayoutTree::NO_OWNER || ! entities.isAlive(owner)) {
+            continue;
+        }
+
+        const LayoutAnchor& anchor = entities.layoutComponent.at(entity::indexOf(owner));
+        const FixedRect& rect = app.layout.rects[node];
+
+        entities.transforms.setLocal(anchor.transformNode, transform::translation(  fixed16::toFloat(rect.left - anchor.originX),
+                                                                                    fixed16::toFloat(rect.top - anchor.originY) ));
+    }
+}
+
+void flushTransforms(VulkanApplication& app)
+{
+    const uint32_t numWritten = app.entitySystem.transforms.flush(app.mappedTransforms);
+
+    if(numWritten > 0) {
+        app.frameStats.bytesUploaded += numWritten * sizeof(GpuTransform);
+        redrawRequired = true;
+    }
+}
+
+void doPerFrameOperations(VulkanApplication& app)
+{
+    PerFrameOperations& perFrame = app.perFrameOperations;
+
+    if(perFrame.count == 0) {
+        return;
+    }
+
+    redrawRequired = true;
+
+    // Relative moves BEGIN
+    const PerFrameOperations::RelativeMoves& relativeMoves = perFrame.relativeMoves;
+    const size_t numRelativeMoves = relativeMoves.targets.size();
+
+    uint64_t verticesUpdated = 0;
+
+    // Targets are validated every frame in debug builds, as the entity may be released while the operation is active
+    for(size_t i = 0; i < numRelativeMoves; i++) {
+        verticesUpdated += moveEntity(app, app.entitySystem.resolve(relativeMoves.targets[i]), relativeMoves.addX[i].toFloat(), relativeMoves.addY[i].toFloat());
+    }
+
+    app.frameStats.bytesUploaded += verticesUpdated * sizeof(glm::vec2);
+    // Relative moves END
+
+    // Bounds moves BEGIN
+    const PerFrameOperations::BoundsMoves& boundsMoves = perFrame.boundsMoves;
+    const size_t numBoundsMoves = boundsMoves.boundsIndices.size();
+
+    for(size_t i = 0; i < numBoundsMoves; i++) {
+        app.onMouseEventOpBindings.moveBounds(boundsMoves.boundsIndices[i], boundsMoves.addX[i], boundsMoves.addY[i]);
+    }
+    // Bounds moves END
+
+    // Anything without a batch goes through the generic path. An operation may activate or deactivate others (Or
+    // itself), and removing one moves the last into its slot, so this runs from a copy taken before any of them.
+    // Operations deactivated by an earlier one in the same frame are skipped
+    const size_t numOther = perFrame.other.size();
+    OperationIndex * otherOperations = app.frameArena.allocate<OperationIndex>(numOther);
+    std::copy(perFrame.other.begin(), perFrame.other.end(), otherOperations);
+
+    for(size_t i = 0; i < numOther; i++)
+    {
+        if(perFrame.contains(otherOperations[i])) {
+            handleOperation(app, otherOperations[i]);
+        }
+    }
+}
+
+void loopLogic(VulkanApplication& app, std::chrono::milliseconds delta)
+{
+    TRACE_FUNCTION();
+
+    app.frameArena.reset();
+
+    {
+        INSTRUMENT_PHASE(PER_FRAME_OPERATIONS);
+        doPerFrameOperations(app);
+    }
+
+    {
+        INSTRUMENT_PHASE(ANIMATIONS);
+        advanceAnimations(app, delta);
+    }
+
+    {
+        INSTRUMENT_PHASE(LAYOUT);
+        applyLayout(app);
+    }
+
+    {
+        INSTRUMENT_PHASE(TRANSFORMS);
+        flushTransforms(app);
+    }
+
+    {
+        INSTRUMENT_PHASE(IMAGES);
+        processImageAssets(app);
+    }
+
+//    updateAddVertexPositions(reinterpret_cast<glm::vec2*>(app.mappedVerticesMemory), 24, sizeof(Vertex), 0.001f, 0.001f);
+
+    vkDeviceWaitIdle(app.device);
+    INSTRUMENT_COLLECT_GPU(app.device);
+
+    recordCommandBuffers(app);
+}
+
+void recordCommandBuffers(VulkanApplication& app)
+{
+    TRACE_FUNCTION();
+    INSTRUMENT_PHASE(COMMAND_RECORDING);
+
+    VkClearValue clearColor = { /* .color = */  {  /* .float32 = */  { 1.0f, 1.0f, 1.0f, 1.0f } } };
+
+    uint32_t numDraws = 0;
+
+    for (size_t i = 0; i < app.commandBuffers.size(); i++)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+        if (vkBeginCommandBuffer(app.commandBuffers[i], &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+
+        INSTRUMENT_GPU_FRAME_BEGIN(app.commandBuffers[i], static_cast<uint32_t>(i));
+
+        for(size_t layerIndex = 0; layerIndex < PipelineType::SIZE; layerIndex++)
+        {
+            VulkanApplicationPipeline& pipeline = app.pipelines[ app.pipelineDrawOrder[layerIndex] ];
 
             VkRenderPassBeginInfo renderPassInfo = {};
             renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -557,6 +1112,13 @@ void loopLogic(VulkanApplication& app, std::chrono::milliseconds delta)
 
                 vkCmdBindPipeline(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.graphicsPipeline);
 
+                // Dynamic, so pipelines are shared across swapchain sizes (See findOrCreatePipeline)
+                VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(app.swapChainExtent.width), static_cast<float>(app.swapChainExtent.height), 0.0f, 1.0f };
+                VkRect2D scissor = { { 0, 0 }, app.swapChainExtent };
+
+                vkCmdSetViewport(app.commandBuffers[i], 0, 1, &viewport);
+                vkCmdSetScissor(app.commandBuffers[i], 0, 1, &scissor);
+
                 VkBuffer vertexBuffers[] = {pipeline.vertexBuffer};
                 VkDeviceSize offsets[] = {0};
                 vkCmdBindVertexBuffers(app.commandBuffers[i], 0, 1, vertexBuffers, offsets);
@@ -567,15 +1129,26 @@ void loopLogic(VulkanApplication& app, std::chrono::milliseconds delta)
                     vkCmdBindDescriptorSets(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout, 0, 1, &pipeline.descriptorSets[i], 0, nullptr);
                 }
 
+                if(pipeline.setupCache.textureSetLayout != VK_NULL_HANDLE) {
+                    vkCmdBindDescriptorSets(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout,
+                                            TextureTable::DESCRIPTOR_SET, 1, &app.textures.descriptorSet, 0, nullptr);
+                }
+
                 vkCmdDrawIndexed(app.commandBuffers[i], pipeline.numIndices, 1, 0, 0, 0);
+                numDraws++;
 
             vkCmdEndRenderPass(app.commandBuffers[i]);
         }
 
+        INSTRUMENT_GPU_FRAME_END(app.commandBuffers[i], static_cast<uint32_t>(i));
+
         if (vkEndCommandBuffer(app.commandBuffers[i]) != VK_SUCCESS) {
             throw std::runtime_error("failed to record command buffer!");
         }
     }
+
+    app.frameStats.drawsPerFrame = (app.commandBuffers.empty()) ? 0 : numDraws / static_cast<uint32_t>(app.commandBuffers.size());
+    app.frameStats.commandBufferRecordings++;
 }
 
 int16_t doublePercentageToInt16(double value) {
@@ -597,7 +1170,151 @@ struct PageSetupState
     uint8_t currentMouseBoundsIndex;
 };
 
-void button(VulkanApplication& app, glm::vec3 color, std::string& text, NormalizedPoint tlPoint)
+// BEGIN Widget meshes
+
+static uint32_t packColor(glm::vec3 color)
+{
+    const auto channel = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return (channel(color.r) << 16) | (channel(color.g) << 8) | channel(color.b);
+}
+
+// Quad of BasicVertex, with its top left at 0, 0
+static CachedMesh generateRectMesh(NormFloat16 width, NormFloat16 height, glm::vec3 color)
+{
+    const float right = width.toFloat();
+    const float bottom = height.toFloat();
+
+    CachedMesh mesh;
+    mesh.numVertices = VERTICES_PER_SQUARE;
+    mesh.vertexStride = sizeof(BasicVertex);
+    mesh.vertices.resize(VERTICES_PER_SQUARE * sizeof(BasicVertex));
+    mesh.indices = { 0, 1, 2, 2, 3, 0 };
+
+    BasicVertex * vertices = reinterpret_cast<BasicVertex *>(mesh.vertices.data());
+
+    vertices[0] = { {right, 0.0f},  {color.r, color.g, color.b}, 0 };   // Top right
+    vertices[1] = { {right, bottom},{color.r, color.g, color.b}, 0 };   // Bottom right
+    vertices[2] = { {0.0f, bottom}, {color.r, color.g, color.b}, 0 };   // Bottom left
+    vertices[3] = { {0.0f, 0.0f},   {color.r, color.g, color.b}, 0 };   // Top left
+
+    return mesh;
+}
+
+// Text of Vertex, with its top left at 0, 0
+static CachedMesh generateTextMesh(VulkanApplication& app, std::string& text)
+{
+    const uint16_t numVertices = static_cast<uint16_t>(text.size()) * VERTICES_PER_SQUARE;
+
+    CachedMesh mesh;
+    mesh.numVertices = numVertices;
+    mesh.vertexStride = sizeof(Vertex);
+    mesh.vertices.assign(numVertices * sizeof(Vertex), 0);
+    mesh.indices.resize(text.size() * INDICES_PER_SQUARE);
+
+    uint8_t * vertices = mesh.vertices.data();
+
+    generateTextMeshes(mesh.indices.data(),
+                       reinterpret_cast<glm::vec2 *>(vertices + offsetof(Vertex, pos)),
+                       sizeof(Vertex),
+                       0,
+                       app.fontBitmap,
+                       reinterpret_cast<glm::vec2 *>(vertices + offsetof(Vertex, texCoord)),
+                       sizeof(Vertex),
+                       text, 0, 0);
+
+    // Pixel 0, 0 is -1, -1
+    translateVertices(reinterpret_cast<float *>(vertices), numVertices, sizeof(Vertex), 1.0f, 1.0f);
+
+    return mesh;
+}
+
+// Quad of Vertex, with its top left at 0, 0. Texture coordinates and index are written per entity (See bindImage)
+static CachedMesh generateImageMesh(NormFloat16 width, NormFloat16 height)
+{
+    const float right = width.toFloat();
+    const float bottom = height.toFloat();
+
+    CachedMesh mesh;
+    mesh.numVertices = VERTICES_PER_SQUARE;
+    mesh.vertexStride = sizeof(Vertex);
+    mesh.vertices.assign(VERTICES_PER_SQUARE * sizeof(Vertex), 0);
+    mesh.indices = { 0, 1, 2, 2, 3, 0 };
+
+    Vertex * vertices = reinterpret_cast<Vertex *>(mesh.vertices.data());
+
+    vertices[0].pos = { right, 0.0f };      // Top right
+    vertices[1].pos = { right, bottom };    // Bottom right
+    vertices[2].pos = { 0.0f, bottom };     // Bottom left
+    vertices[3].pos = { 0.0f, 0.0f };       // Top left
+
+    for(uint32_t i = 0; i < VERTICES_PER_SQUARE; i++) {
+        vertices[i].color = { 1.0f, 1.0f, 1.0f };
+    }
+
+    return mesh;
+}
+
+static uint32_t findOrGenerateMesh(VulkanApplication& app, const MeshKey& key, CachedMesh (*generate)(VulkanApplication&, const MeshKey&))
+{
+    MeshCache& meshes = app.entitySystem.meshes;
+
+    uint32_t mesh = meshes.find(key);
+
+    if(mesh == MeshCache::INVALID_MESH)
+    {
+        mesh = meshes.insert(key, generate(app, key));
+
+        if(mesh == MeshCache::INVALID_MESH) {
+            throw std::runtime_error("failed to cache widget mesh, limit reached!");
+        }
+    }
+
+    return mesh;
+}
+
+static uint32_t textMesh(VulkanApplication& app, std::string& text)
+{
+    const MeshKey key = { static_cast<uint8_t>(UIType::TEXT), 0, 0, 0, text };
+
+    return findOrGenerateMesh(app, key, [](VulkanApplication& app, const MeshKey& key) {
+        std::string text = key.text;
+        return generateTextMesh(app, text);
+    });
+}
+
+// Copies a cached mesh into the pipeline with its top left at x, y and gives it to a new entity
+static Entity32 placeMesh(VulkanApplication& app, VulkanApplicationPipeline& pipeline, uint32_t mesh, float x, float y)
+{
+    EntitySystemHandle& entities = app.entitySystem;
+    const CachedMesh& cached = entities.meshes.meshes[mesh];
+
+    assert(cached.vertexStride == pipeline.vertexStride);
+
+    const uint16_t firstVertex = static_cast<uint16_t>(pipeline.numVertices);
+
+    uint16_t * indices = pipeline.writeIndices(app.mappedIndicesMemory, static_cast<uint16_t>(cached.indices.size()));
+    uint8_t * vertices = reinterpret_cast<uint8_t *>(pipeline.writeVertices(app.mappedVerticesMemory, cached.numVertices, static_cast<uint8_t>(cached.vertexStride), 0));
+
+    entities.meshes.write(mesh, vertices, indices, firstVertex, x, y);
+    entities.meshes.retain(mesh);
+
+    const Entity32 entity = requestEntity(entities);
+    const uint32_t entityIndex = entities.resolve(entity);
+
+    entities.verticesComponent.set(entityIndex, {   static_cast<uint32_t>(vertices - app.mappedVerticesMemory),
+                                                    cached.numVertices,
+                                                    cached.vertexStride });
+
+    entities.meshComponent.set(entityIndex, { mesh, static_cast<uint32_t>(reinterpret_cast<uint8_t *>(indices) - app.mappedIndicesMemory) });
+
+    app.frameStats.bytesUploaded += cached.vertices.size() + cached.indices.size() * sizeof(uint16_t);
+
+    return entity;
+}
+
+// END Widget meshes
+
+Entity32 button(VulkanApplication& app, glm::vec3 color, std::string& text, NormalizedPoint tlPoint)
 {
     NormFloat16 height;
     height.set(0.07);
@@ -605,116 +1322,218 @@ void button(VulkanApplication& app, glm::vec3 color, std::string& text, Normaliz
     NormFloat16 width;
     width.set(0.2);
 
-    VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
-    VulkanApplicationPipeline& primativeShapesPipeline = app.pipelines[PipelineType::PrimativeShapes];
+    const MeshKey key = { static_cast<uint8_t>(UIType::BUTTON), packColor(color), width.data, height.data, "" };
+
+    // Every button of the same size and colour shares one mesh
+    const uint32_t mesh = findOrGenerateMesh(app, key, [](VulkanApplication& app, const MeshKey& key) {
+        (void)app;
+
+        const glm::vec3 color = {   ((key.style >> 16) & 0xFF) / 255.0f,
+                                    ((key.style >> 8) & 0xFF) / 255.0f,
+                                    (key.style & 0xFF) / 255.0f };
+
+        return generateRectMesh({ static_cast<uint16_t>(key.width) }, { static_cast<uint16_t>(key.height) }, color);
+    });
+
+    const Entity32 background = placeMesh(app, app.pipelines[PipelineType::PrimativeShapes], mesh, tlPoint.x.toFloat(), tlPoint.y.toFloat());
+
+    const uint32_t style = key.style;
+    app.entitySystem.colorComponent.set(app.entitySystem.resolve(background), { static_cast<uint8_t>(style >> 16),
+                                                                                static_cast<uint8_t>(style >> 8),
+                                                                                static_cast<uint8_t>(style),
+                                                                                255 });
+
+    return drawText(app, tlPoint, text);
+}
+
+Entity32 image(VulkanApplication& app, uint32_t imageAsset, NormalizedPoint tlPoint, NormFloat16 width, NormFloat16 height)
+{
+    if(imageAsset == ImageAssets::INVALID_IMAGE) {
+        return ENTITY_INVALID;
+    }
+
+    const MeshKey key = { static_cast<uint8_t>(UIType::IMAGE), 0, width.data, height.data, "" };
+
+    const uint32_t mesh = findOrGenerateMesh(app, key, [](VulkanApplication& app, const MeshKey& key) {
+        (void)app;
+        return generateImageMesh({ static_cast<uint16_t>(key.width) }, { static_cast<uint16_t>(key.height) });
+    });
+
+    const Entity32 entity = placeMesh(app, app.pipelines[PipelineType::Texture], mesh, tlPoint.x.toFloat(), tlPoint.y.toFloat());
+    bindImage(app, entity, imageAsset);
+
+    return entity;
+}
+
+// Points outside of the screen are clamped to its edges
+Point unnormalizePoint(NormalizedPoint point, uint16_t widthPixels, uint16_t heightPixels)
+{
+    const int32_t x = fixed16::toPixels(point.x.data, widthPixels);
+    const int32_t y = fixed16::toPixels(point.y.data, heightPixels);
+
+    return Point {
+        static_cast<uint16_t>(std::clamp(x, 0, static_cast<int32_t>(widthPixels))),
+        static_cast<uint16_t>(std::clamp(y, 0, static_cast<int32_t>(heightPixels)))
+    };
+}
+
+Entity32 drawText(VulkanApplication& app, NormalizedPoint point, std::string& text)
+{
+    assert(text.size() == 8);
+
+    // Text is placed on whole pixels of the initial window size, the same as it's generated
+    const Point pointPixels = unnormalizePoint(point, vconfig::INITIAL_WINDOW_WIDTH, vconfig::INITIAL_WINDOW_HEIGHT);
+
+    const Entity32 entity = placeMesh(  app,
+                                        app.pipelines[PipelineType::Texture],
+                                        textMesh(app, text),
+                                        fixed16::toFloat(fixed16::fromPixels(pointPixels.x, vconfig::INITIAL_WINDOW_WIDTH)),
+                                        fixed16::toFloat(fixed16::fromPixels(pointPixels.y, vconfig::INITIAL_WINDOW_HEIGHT)) );
+
+    // Text meshes leave the vertex colour at zero, so glyphs are drawn in black
+    app.entitySystem.colorComponent.set(app.entitySystem.resolve(entity), { 0, 0, 0, 255 });
+
+    return entity;
+}
+
+uint16_t bindBounds(VulkanApplication& app, Entity32 entity, const MouseBounds& mouseBounds)
+{
+    const uint16_t boundsIndex = app.onMouseEventOpBindings.addBounds(mouseBounds);
+    app.entitySystem.boundsComponent.set(app.entitySystem.resolve(entity), boundsIndex);
+
+    return boundsIndex;
+}
+
+void releaseEntity(VulkanApplication& app, Entity32 entity)
+{
+    EntitySystemHandle& entities = app.entitySystem;
 
-    std::vector<BasicVertex> simpleShapesVertices = {
-        {{tlPoint.x.get() + width.get(), tlPoint.y.get()},                  {color.r, color.g, color.b}},   // Top right
-        {{tlPoint.x.get() + width.get(), tlPoint.x.get() + height.get()},   {color.r, color.g, color.b}},   // Bottom right
-        {{tlPoint.x.get(), tlPoint.x.get() + height.get()},                 {color.r, color.g, color.b}},   // Bottom left
-        {{tlPoint.x.get(), tlPoint.y.get()},                                {color.r, color.g, color.b}}    // Top left
-    };
+    if(! entities.isAlive(entity)) {
+        return;
+    }
 
-    memcpy(primativeShapesPipeline.writeVertices(app.mappedVerticesMemory, VERTICES_PER_SQUARE, sizeof(BasicVertex), offsetof(BasicVertex, pos)),
-           simpleShapesVertices.data(), simpleShapesVertices.size() * sizeof(BasicVertex));
+    const uint32_t entityIndex = entity::indexOf(entity);
 
-    std::vector<uint16_t> drawIndices = {
-        0, 1, 2, 2, 3, 0
-    };
+    // Only entities that fit in an Entity16 can be targeted by operations. Backwards, as removing swaps the last into the hole
+    if(entityIndex <= ENTITY16_INDEX_MASK)
+    {
+        AnimationTracks& tracks = app.animations;
 
-    memcpy(primativeShapesPipeline.writeIndices(app.mappedIndicesMemory, INDICES_PER_SQUARE), drawIndices.data(), drawIndices.size() * sizeof(uint16_t));
+        for(uint32_t i = tracks.size(); i-- > 0;)
+        {
+            if(entity::indexOf16(tracks.targets[i]) == entityIndex) {
+                stopAnimation(app, tracks.operations[i]);
+            }
+        }
 
-//    NormalizedPoint point;
-//    point.x.set(0.0);
-//    point.y.set(0.0);
+        PerFrameOperations& perFrame = app.perFrameOperations;
 
-    drawText(app, tlPoint, text);
+        for(size_t i = perFrame.relativeMoves.targets.size(); i-- > 0;)
+        {
+            if(entity::indexOf16(perFrame.relativeMoves.targets[i]) == entityIndex)
+            {
+                const OperationIndex operationIndex = perFrame.relativeMoves.operations[i];
+                perFrame.remove(operationIndex);
+                app.opAt(operationIndex).flags &= ~OPERATION_FLAGS_ACTIVE;
+            }
+        }
+    }
 
-//    uint16_t requiredIndices = static_cast<uint16_t>(text.size() * INDICES_PER_SQUARE);
-//    uint16_t requiredVertices = static_cast<uint16_t>(text.size() * VERTICES_PER_SQUARE);
+    if(entities.meshComponent.contains(entityIndex))
+    {
+        // Every index repeats the first, so nothing is rasterized
+        const MeshBinding& binding = entities.meshComponent.at(entityIndex);
+        const size_t numIndices = entities.meshes.meshes[binding.mesh].indices.size();
 
-//    glm::vec2 * startTexCoordPos = texturesPipeline.getFreeVertices(app.mappedVerticesMemory, sizeof(Vertex), offsetof(Vertex, texCoord));
-//    uint16_t verticesStartIndex = static_cast<uint16_t>(texturesPipeline.numVertices);
+        uint16_t * indices = reinterpret_cast<uint16_t *>(app.mappedIndicesMemory + binding.indicesOffsetBytes);
 
-//    generateTextMeshes(texturesPipeline.writeIndices(app.mappedIndicesMemory, requiredIndices),
-//                       texturesPipeline.writeVertices(app.mappedVerticesMemory, requiredVertices, sizeof(Vertex), offsetof(Vertex, pos)),
-//                       sizeof(Vertex),
-//                       verticesStartIndex,
-//                       app.fontBitmap,
-//                       startTexCoordPos,
-//                       texturesPipeline.vertexStride,
-//                       text, 500, 280);
+        if(numIndices > 0) {
+            std::fill(indices, indices + numIndices, indices[0]);
+        }
 
-//    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] = { vconfig::PIPELINE_MEMORY_SIZE / 2, 4, primativeShapesPipeline.vertexStride };
-//    app.entitySystem.numberVerticesComponents++;
-//    app.entitySystem.nextEntity++;
+        app.frameStats.bytesUploaded += numIndices * sizeof(uint16_t);
+    } else if(entities.verticesComponent.contains(entityIndex))
+    {
+        // Indices weren't recorded, so every vertex is moved onto the first instead
+        const RelativeDataLocation& location = entities.verticesComponent.at(entityIndex);
+        uint8_t * vertices = entities.verticesComponentBasePtr + location.offsetBytes;
+        const glm::vec2 first = *reinterpret_cast<const glm::vec2 *>(vertices);
 
-//    assert(texturesPipeline.numIndices == requiredIndices);
+        for(uint16_t i = 1; i < location.spanElements; i++) {
+            *reinterpret_cast<glm::vec2 *>(vertices + i * location.strideBytes) = first;
+        }
 
-     // TODO: Audit and refactor
-//    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] =
-//    {
-//        vconfig::PIPELINE_MEMORY_SIZE / 2,
-//        static_cast<uint16_t>(4),
-//        sizeof(BasicVertex)
-//    };
+        app.frameStats.bytesUploaded += location.spanElements * sizeof(glm::vec2);
+    }
 
-//    app.entitySystem.numberVerticesComponents++;
-//    app.entitySystem.nextEntity++;
+    releaseEntity(entities, entity);
+    redrawRequired = true;
 }
 
-Point unnormalizePoint(NormalizedPoint point, uint16_t widthPixels, uint16_t heightPixels)
+bool setText(VulkanApplication& app, Entity32 textEntity, std::string& text)
 {
-    double x = point.x.get();
-    x += 1.0;
-    x /= 2;
-    point.x.set(x);
+    EntitySystemHandle& entities = app.entitySystem;
+    const uint32_t entityIndex = entities.resolve(textEntity);
 
-    double y = point.y.get();
-    y += 1.0;
-    y /= 2;
-    point.y.set(y);
+    MeshBinding& binding = entities.meshComponent.at(entityIndex);
 
-    return Point {
-        static_cast<uint16_t>(point.x.get() * static_cast<double>(widthPixels)),
-        static_cast<uint16_t>(point.y.get() * static_cast<double>(heightPixels))
-    };
-}
+    if(entities.meshes.keys[binding.mesh].text == text) {
+        return false;
+    }
 
-uint32_t drawText(VulkanApplication& app, NormalizedPoint point, std::string& text)
-{
-    uint16_t requiredVertices = static_cast<uint16_t>(text.size()) * VERTICES_PER_SQUARE;
-    uint16_t requiredIndices = static_cast<uint16_t>(text.size()) * INDICES_PER_SQUARE;
+    const uint32_t mesh = textMesh(app, text);
+    const CachedMesh& cached = entities.meshes.meshes[mesh];
+    const CachedMesh& previous = entities.meshes.meshes[binding.mesh];
 
-    assert(text.size() == 8);
+    const RelativeDataLocation& location = entities.verticesComponent.at(entityIndex);
 
-    VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
+    if(cached.numVertices != location.spanElements || cached.indices.size() != previous.indices.size()) {
+        return false;
+    }
 
-    glm::vec2 * startTexCoordPos = texturesPipeline.getFreeVertices(app.mappedVerticesMemory, sizeof(Vertex), offsetof(Vertex, texCoord));
-    uint16_t verticesStartIndex = static_cast<uint16_t>(texturesPipeline.numVertices);
+    uint8_t * vertices = entities.verticesComponentBasePtr + location.offsetBytes;
 
-    Point pointPixels = unnormalizePoint(point, 800, 600);
+    // Wherever the entity has been moved to since it was placed
+    const float * currentTopLeft = reinterpret_cast<const float *>(vertices);
+    const float * previousTopLeft = reinterpret_cast<const float *>(previous.vertices.data());
 
-    generateTextMeshes(texturesPipeline.writeIndices(app.mappedIndicesMemory, requiredIndices),
-                       texturesPipeline.writeVertices(app.mappedVerticesMemory, requiredVertices, sizeof(Vertex), offsetof(Vertex, pos)),
-                       sizeof(Vertex),
-                       verticesStartIndex,
-                       app.fontBitmap,
-                       startTexCoordPos,
-                       texturesPipeline.vertexStride,
-                       text, pointPixels.x, pointPixels.y);
+    const float x = currentTopLeft[0] - previousTopLeft[0];
+    const float y = currentTopLeft[1] - previousTopLeft[1];
+
+    const VulkanApplicationPipeline& texturesPipeline = app.pipelines[PipelineType::Texture];
+    const uint32_t firstVertex = (location.offsetBytes - texturesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)].offset) / location.strideBytes;
+
+    entities.meshes.write(  mesh,
+                            vertices,
+                            reinterpret_cast<uint16_t *>(app.mappedIndicesMemory + binding.indicesOffsetBytes),
+                            static_cast<uint16_t>(firstVertex),
+                            x, y );
+
+    entities.meshes.retain(mesh);
+    entities.meshes.release(binding.mesh);
+    binding.mesh = mesh;
+
+    // The copy doesn't know which transform the entity uses
+    if(entities.transformComponent.contains(entityIndex)) {
+        writeTransformIndices(entities, entityIndex, entities.transformComponent.at(entityIndex));
+    }
 
-    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] = { 0, requiredVertices, texturesPipeline.vertexStride };
-    app.entitySystem.numberVerticesComponents++;
-    app.entitySystem.nextEntity++;
+    app.frameStats.bytesUploaded += cached.vertices.size() + cached.indices.size() * sizeof(uint16_t);
+    redrawRequired = true;
 
-    return app.entitySystem.nextEntity - 1;
+    return true;
 }
 
 void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 {
     int width = 0, height = 0;
 
+    if(app.isHeadless)
+    {
+        width = static_cast<int>(app.swapChainExtent.width);
+        height = static_cast<int>(app.swapChainExtent.height);
+    }
+
     while(width == 0 || height == 0)
     {
         glfwGetFramebufferSize(app.window, &width, &height);
@@ -728,6 +1547,7 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
     VulkanApplicationPipeline& primativeShapesPipeline = app.pipelines[PipelineType::PrimativeShapes];
 
     texturesPipeline.vertexStride = sizeof(Vertex);
+    primativeShapesPipeline.vertexStride = sizeof(BasicVertex);
 
     NormalizedPoint point;
     point.x.set( 0.0 );
@@ -755,21 +1575,11 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
                        texturesPipeline.vertexStride,
                        otherText, 150, 25);
 
-    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] = { 0, requiredVertices, texturesPipeline.vertexStride };
-    app.entitySystem.numberVerticesComponents++;
-    app.entitySystem.nextEntity++;
+    const Entity32 otherTextEntity = requestEntity(app.entitySystem);
+    app.entitySystem.verticesComponent.set(app.entitySystem.resolve(otherTextEntity), { 0, requiredVertices, texturesPipeline.vertexStride });
 
 //    assert(texturesPipeline.numVertices == requiredVertices);
 
-//    texturesPipeline.uiComponentsMap[0] = {
-//        UIType::TEXT,
-//        GraphicsUpdateDependency::STATIC,
-//        0,
-//        0,
-//        requiredVertices,
-//        requiredIndices
-//    };
-
 //    assert(texturesPipeline.numIndices == requiredIndices);
 
     std::string moreText = "New text would be pretty nice actually..";
@@ -797,45 +1607,26 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 
 //    assert(texturesPipeline.numIndices == (moreText.size() * INDICES_PER_SQUARE) + (static_cast<uint16_t>(otherText.size()) * INDICES_PER_SQUARE));
 
-//    assert(app.entitySystem.verticesComponent[app.entitySystem.nextEntity - 1].spanElements == requiredVertices);
+//    assert(app.entitySystem.verticesComponent.at(app.entitySystem.resolve(otherTextEntity)).spanElements == requiredVertices);
+
+    const Entity32 moreTextEntity = requestEntity(app.entitySystem);
 
-    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] =
+    app.entitySystem.verticesComponent.set(app.entitySystem.resolve(moreTextEntity),
     {
-        app.entitySystem.verticesComponent[app.entitySystem.nextEntity - 1].spanElements,
+        app.entitySystem.verticesComponent.at(app.entitySystem.resolve(otherTextEntity)).spanElements,
         moreRequiredVertices,
         texturesPipeline.vertexStride
-    };
-
-    app.entitySystem.numberVerticesComponents++;
-    app.entitySystem.nextEntity++;
-
-//    texturesPipeline.uiComponentsMap[1] = {
-//        UIType::TEXT,
-//        GraphicsUpdateDependency::STATIC,
-//        requiredVertices,
-//        requiredIndices,
-//        static_cast<uint16_t>(moreText.size() * VERTICES_PER_SQUARE),
-//        static_cast<uint16_t>(moreText.size() * INDICES_PER_SQUARE)
-//    };
+    });
 
     // Second pipeline
 
-    std::vector<BasicVertex> simpleShapesVertices = {
+    const BasicVertex simpleShapesVertices[] = {
         {{-0.5f, -1.0f}, {1.0f, 0.0f, 0.0f}},
         {{-0.5f, -0.5f}, {1.0f, 0.0f, 0.0f}},
         {{-1.0f, -0.5f}, {1.0f, 0.0f, 0.0f}},
         {{-1.0f, -1.0f}, {1.0f, 0.0f, 0.0f}}
     };
 
-//    primativeShapesPipeline.uiComponentsMap[0] = {
-//        UIType::SHAPE,
-//        GraphicsUpdateDependency::ALL,
-//        0,
-//        0,
-//        4,
-//        6
-//    };
-
 //    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] =
 //    {
 //        primativeShapesPipeline.numVertices,
@@ -854,7 +1645,7 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 //           reinterpret_cast<glm::vec2*>( app.mappedVerticesMemory + primativeShapesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)].offset ));
 
     memcpy(primativeShapesPipeline.writeVertices(app.mappedVerticesMemory, VERTICES_PER_SQUARE * 1, sizeof(BasicVertex), offsetof(BasicVertex, pos)),
-           simpleShapesVertices.data(), simpleShapesVertices.size() * sizeof(BasicVertex));
+           simpleShapesVertices, sizeof(simpleShapesVertices));
 
 //    assert(primativeShapesPipeline.getFreeVertices(app.mappedVerticesMemory, sizeof(BasicVertex), offsetof(BasicVertex, pos)) ==
 //           reinterpret_cast<glm::vec2*>( app.mappedVerticesMemory + primativeShapesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)].offset + (4 * sizeof(BasicVertex)) ));
@@ -867,7 +1658,7 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 //        0, 1, 2, 2, 3, 0
 //    };
 
-    std::vector<uint16_t> drawIndices = {
+    const uint16_t drawIndices[] = {
         4, 5, 6, 6, 7, 4
     };
 
@@ -876,24 +1667,23 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 //    assert(primativeShapesPipeline.getFreeIndices(app.mappedIndicesMemory) ==
 //           reinterpret_cast<uint16_t*>(app.mappedIndicesMemory + primativeShapesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::INDICES_BUFFER)].offset));
 
-    memcpy(primativeShapesPipeline.writeIndices(app.mappedIndicesMemory, INDICES_PER_SQUARE * 1), drawIndices.data(), drawIndices.size() * sizeof(uint16_t));
+    memcpy(primativeShapesPipeline.writeIndices(app.mappedIndicesMemory, INDICES_PER_SQUARE * 1), drawIndices, sizeof(drawIndices));
 
 //    assert(primativeShapesPipeline.numIndices == 6);
 
-    app.entitySystem.verticesComponent[app.entitySystem.nextEntity] =
+    const Entity32 shapeEntity = requestEntity(app.entitySystem);
+
+    app.entitySystem.verticesComponent.set(app.entitySystem.resolve(shapeEntity),
     {
         vconfig::PIPELINE_MEMORY_SIZE / 2,
-        static_cast<uint16_t>(simpleShapesVertices.size()),
+        static_cast<uint16_t>(sizeof(simpleShapesVertices) / sizeof(BasicVertex)),
         sizeof(BasicVertex)
-    };
+    });
 
-    app.entitySystem.numberVerticesComponents++;
-    app.entitySystem.nextEntity++;
-
-    app.entitySystem.exampleTimeUpdateList[0] = app.entitySystem.nextEntity - 1;
+    app.entitySystem.exampleTimeUpdateList[0] = shapeEntity;
     app.entitySystem.exampleTimeUpdateListSize++;
 
-    RelativeMoveOperation relativeMove = { static_cast<Entity16>(app.entitySystem.nextEntity - 1), {30}, {30} };
+    RelativeMoveOperation relativeMove = { entity::toEntity16(shapeEntity), {30}, {30} };
     Operation8Union op8;
     op8.relativeMove = relativeMove;
 
@@ -916,30 +1706,43 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
     op4.operationIndex = 1;
     app.insertOp4(OPERATION_CODE_DEACTIVATE_OP, 0, op4);
 
+    // Hover enter starts both moves, hover exit stops them
+    OperationChainBuilder chainBuilder(app.operationChains);
+
+    const uint16_t onHoverEnterChain = chainBuilder.begin();
+    chainBuilder.runOperation(0);
+    chainBuilder.runOperation(1);
+    chainBuilder.end();
+
+    const uint16_t onHoverExitChain = chainBuilder.begin();
+    chainBuilder.runOperation(2);
+    chainBuilder.runOperation(3);
+    chainBuilder.end();
+
 //    assert((app.opAt(2).flags & OPERATION_FLAGS_SIZE_4) == OPERATION_FLAGS_SIZE_4);
 //    assert(app.opAt(2).opCode == OPERATION_CODE_DEACTIVATE_OP);
 
     app.onMouseEventOpBindings.numAreas = 0;
-    app.onMouseEventOpBindings.numBounds = 1;
+    app.onMouseEventOpBindings.clearBounds();
 
-    app.onMouseEventOpBindings.bounds[0] =
+    // Covers the shape, which moves along with it while hovered
+    bindBounds(app, shapeEntity,
     {
         { /* Point*/ { { NORMFLOAT_MIN }, { NORMFLOAT_MIN } }, { 5000 }, { 5000 } },
-        MOUSE_BOUNDS_FLAGS_2_ON_HOVER_ENTER | MOUSE_BOUNDS_FLAGS_2_ON_HOVER_EXIT,
-        0,
-        1,
-        2,
-        3,
-        UINT8_MAX,
+        MOUSE_BOUNDS_FLAGS_CHAINS,
+        onHoverEnterChain,
+        onHoverExitChain,
+        OPERATION_INDEX_INVALID,
+        OPERATION_INDEX_INVALID,
+        OPERATION_INDEX_INVALID,
         0
-    };
+    });
 
 //    assert(primativeShapesPipeline.numVertices == static_cast<uint32_t>(simpleShapesVertices.size()));
 //    assert(primativeShapesPipeline.numIndices == static_cast<uint32_t>(drawIndices.size()));
 
 //    primativeShapesPipeline.numVertices = static_cast<uint32_t>(simpleShapesVertices.size());
 //    primativeShapesPipeline.numIndices = static_cast<uint32_t>(drawIndices.size());
-    primativeShapesPipeline.vertexStride = sizeof(BasicVertex);
 
 //    NormalizedPoint point2;
 //    point.x.set( 0.3 );
@@ -949,60 +1752,9 @@ void loadInitialMeshData(VulkanApplication& app, uint32_t delta)
 
 //    button(app, {0.0, 1.0, 0.0}, buttonText, point2);
 
-    VkClearValue clearColor = { /* .color = */  {  /* .float32 = */  { 1.0f, 1.0f, 1.0f, 1.0f } } };
-
     vkDeviceWaitIdle(app.device);
 
-    for (size_t i = 0; i < app.commandBuffers.size(); i++)
-    {
-        VkCommandBufferBeginInfo beginInfo = {};
-        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-
-        if (vkBeginCommandBuffer(app.commandBuffers[i], &beginInfo) != VK_SUCCESS) {
-            throw std::runtime_error("failed to begin recording command buffer!");
-        }
-
-        for(size_t layerIndex = 0; layerIndex < PipelineType::SIZE; layerIndex++)
-        {
-            VulkanApplicationPipeline& pipeline = app.pipelines[ app.pipelineDrawOrder[layerIndex] ];
-
-            VkRenderPassBeginInfo renderPassInfo = {};
-            renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassInfo.renderPass = pipeline.renderPass;
-            renderPassInfo.framebuffer = pipeline.swapChainFramebuffers[i];
-            renderPassInfo.renderArea.offset = {0, 0};
-            renderPassInfo.renderArea.extent = app.swapChainExtent;
-
-            bool requiresInitialClear = (layerIndex == 0);
-
-            renderPassInfo.clearValueCount = (requiresInitialClear) ? 1 : 0;
-            renderPassInfo.pClearValues = (requiresInitialClear) ? &clearColor : nullptr;
-
-            vkCmdBeginRenderPass(app.commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-                vkCmdBindPipeline(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.graphicsPipeline);
-
-                VkBuffer vertexBuffers[] = {pipeline.vertexBuffer};
-                VkDeviceSize offsets[] = {0};
-                vkCmdBindVertexBuffers(app.commandBuffers[i], 0, 1, vertexBuffers, offsets);
-
-                vkCmdBindIndexBuffer(app.commandBuffers[i], pipeline.indexBuffer, 0, VK_INDEX_TYPE_UINT16);
-
-                if(pipeline.pipelineLayout != nullptr && pipeline.descriptorSets.size() != 0) {
-                    vkCmdBindDescriptorSets(app.commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipelineLayout, 0, 1, &pipeline.descriptorSets[i], 0, nullptr);
-                }
-
-                assert(pipeline.numIndices >= 6);
-
-                vkCmdDrawIndexed(app.commandBuffers[i], pipeline.numIndices, 1, 0, 0, 0);
-
-            vkCmdEndRenderPass(app.commandBuffers[i]);
-        }
-
-        if (vkEndCommandBuffer(app.commandBuffers[i]) != VK_SUCCESS) {
-            throw std::runtime_error("failed to record command buffer!");
-        }
-    }
+    recordCommandBuffers(app);
 }
 
 uint16_t unnormalize(double percentage, double max)
@@ -1013,44 +1765,40 @@ uint16_t unnormalize(double percentage, double max)
     return static_cast<uint16_t>(max * percentage);
 }
 
-static void handleOperation4(VulkanApplication& app, Operation4& operation)
+void handleOperation4(VulkanApplication& app, Operation4& operation)
 {
     switch(operation.opCode)
     {
         case OPERATION_CODE_DEACTIVATE_OP:
         {
-            for(uint16_t i = 0; i < app.numPerFrameOperations; i++) {
-                if(app.perFrameOperationIndices[i] == operation.opData.operationIndex) {
-                    // TODO: Hack, do proper removal of array element after testing
-//                    printf("Removing active index -> %u\n", i);
-                    removeArrayIndex(app.perFrameOperationIndices, app.numPerFrameOperations, i);
-                    app.numPerFrameOperations--;
-                    app.opAt(operation.opData.operationIndex).flags ^= OPERATION_FLAGS_ACTIVE;
-                }
+            const OperationIndex targetIndex = operation.opData.operationIndex;
+
+            if(app.perFrameOperations.contains(targetIndex)) {
+                app.perFrameOperations.remove(targetIndex);
+                app.opAt(targetIndex).flags &= ~OPERATION_FLAGS_ACTIVE;
             }
 
+            stopAnimation(app, targetIndex);
+
             break;
         }
     }
 }
 
-static void handleOperation8(VulkanApplication& app, Operation8& operation)
+void handleOperation8(VulkanApplication& app, Operation8& operation)
 {
     switch(operation.opCode)
     {
         case OPERATION_CODE_RELATIVE_MOVE: {
 //            printf("move op\n");
             RelativeMoveOperation& relativeMove = operation.opData.relativeMove;
-            RelativeDataLocation& verticesTarget = app.entitySystem.verticesComponent[relativeMove.targetEntity];
 
-//            assert(verticesTarget.spanElements > 10);
-//            assert(verticesTarget.strideBytes == sizeof(Vertex));
-//            assert(verticesTarget.offsetBytes == 0);
+            const uint32_t verticesUpdated = moveEntity(    app,
+                                                            app.entitySystem.resolve(relativeMove.targetEntity),
+                                                            relativeMove.addX.toFloat(),
+                                                            relativeMove.addY.toFloat() );
 
-            updateAddVertexPositions(   reinterpret_cast<glm::vec2*>(app.entitySystem.verticesComponentBasePtr + verticesTarget.offsetBytes),
-                                        verticesTarget.spanElements,
-                                        verticesTarget.strideBytes,
-                                        relativeMove.addX.get(), relativeMove.addY.get());
+            app.frameStats.bytesUploaded += verticesUpdated * sizeof(glm::vec2);
 
 //            printf("X -> %f\n", relativeMove.addX.get());
 //            printf("Y -> %f\n", relativeMove.addY.get());
@@ -1064,11 +1812,10 @@ static void handleOperation8(VulkanApplication& app, Operation8& operation)
         {
 
             const SimpleMouseBoundsMoveOperation& boundsMove = operation.opData.mouseBoundsMove;
-            NormalizedRect& targetBounds = app.onMouseEventOpBindings.bounds[boundsMove.boundsIndex].boundsArea;
 //            assert(boundsMove.addX == 10);
 //            assert(boundsMove.addY == 10);
-            targetBounds.topLeftPoint.x.addTo(boundsMove.addX);   // TODO: You need to decide whether the main unit is going to be pixels or screen percentages within the loop
-            targetBounds.topLeftPoint.y.addTo(boundsMove.addY);
+            // TODO: You need to decide whether the main unit is going to be pixels or screen percentages within the loop
+            app.onMouseEventOpBindings.moveBounds(boundsMove.boundsIndex, boundsMove.addX, boundsMove.addY);
 
 //            printf("Bounds X -> %f\n", targetBounds.topLeftPoint.x.get());
 //            printf("Bounds Y -> %f\n", targetBounds.topLeftPoint.y.get());
@@ -1079,15 +1826,22 @@ static void handleOperation8(VulkanApplication& app, Operation8& operation)
     }
 }
 
-static void handleOperation(VulkanApplication& app, uint16_t operationIndex)
+void handleOperation(VulkanApplication& app, uint16_t operationIndex)
 {
+    TRACE_FUNCTION();
+
     Operation2& operation = app.opAt(operationIndex);
 
+    redrawRequired = true;
+
     if((operation.flags & OPERATION_FLAGS_PER_FRAME) && !(operation.flags & OPERATION_FLAGS_ACTIVE))
     {
-        app.perFrameOperationIndices[ app.numPerFrameOperations ] = operationIndex;
-        app.numPerFrameOperations++;
-        operation.flags |= OPERATION_FLAGS_ACTIVE;
+        if(app.perFrameOperations.add(operationIndex, operation)) {
+            operation.flags |= OPERATION_FLAGS_ACTIVE;
+        } else {
+            printf("Per frame operation limit (%u) reached\n", app.perFrameOperations.capacity);
+        }
+
         return;
     }
 
@@ -1111,6 +1865,18 @@ static void handleOperation(VulkanApplication& app, uint16_t operationIndex)
         case OPERATION_FLAGS_SIZE_16: {
             Operation16& operation16 = *reinterpret_cast<Operation16*>(&operation);
 
+            switch(operation16.opCode)
+            {
+                case OPERATION_CODE_ANIMATED_MOVE:
+                    // Running an animation that is already in progress doesn't restart it
+                    if(startAnimation(app, operationIndex, operation16.opData.animatedMove)) {
+                        operation.flags |= OPERATION_FLAGS_ACTIVE;
+                    }
+                    break;
+                default:
+                    assert(false && "invalid operation opCode [OPCODE_OFFSET_SIZE_16]");
+            }
+
             break;
         }
         default: {
@@ -1131,6 +1897,18 @@ bool isActiveBoundsIndex(VulkanApplication& app, uint16_t boundsIndex)
     return false;
 }
 
+bool isHoveredBoundsIndex(VulkanApplication& app, uint16_t boundsIndex)
+{
+    for(uint16_t i = 0; i < app.numHoveredBounds; i++)
+    {
+        if(app.hoveredBoundsIndices[i] == boundsIndex) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool removeArrayIndex(uint16_t *array, uint16_t arraySize, uint16_t arrayIndex)
 {
     if(arrayIndex == arraySize - 1) {
@@ -1176,37 +1954,57 @@ static void onCursorPosChanged(GLFWwindow * window, double xPos, double yPos)
 //    assert(false && "onCursorPosChanged disabled\n");
 
     VulkanApplication& app = *reinterpret_cast<VulkanApplication*>( glfwGetWindowUserPointer(window) );
+    app.input.pushCursorMove(xPos, yPos);
+}
 
-//    uint16_t xPixelPos = static_cast<uint16_t>(xPos);
-//    uint16_t yPixelPos = static_cast<uint16_t>(yPos);
+void handleCursorMove(VulkanApplication& app, double xPos, double yPos)
+{
+    // Minimized, nothing can be under the cursor
+    if(app.swapChainExtent.width == 0 || app.swapChainExtent.height == 0) {
+        return;
+    }
+
+    // Hit testing is done in SNormFloat16 units, the same as the bounds. The cursor is taken to be in the
+    // pixel it's over, after which the conversion is exact
+    const int32_t xFixed = fixed16::fromPixels(static_cast<int32_t>(std::floor(xPos)), static_cast<uint16_t>(app.swapChainExtent.width));
+    const int32_t yFixed = fixed16::fromPixels(static_cast<int32_t>(std::floor(yPos)), static_cast<uint16_t>(app.swapChainExtent.height));
 
-    xPos *= 2;
-    yPos *= 2;
+    const MouseBoundsGrid& boundsGrid = app.onMouseEventOpBindings.grid;
 
-    xPos -= 800;
-    yPos -= 600;
+    // Only bounds whose boundsArea contains the cursor are returned, compound bounds still need their sub areas tested.
+    // Done before any hover operation runs, so chains that test which bounds are hovered see where the cursor is now
+    uint16_t hitIndices[MAX_HOVER_HITS];
+    const uint16_t numHits = boundsGrid.query(xFixed, yFixed, hitIndices, MAX_HOVER_HITS);
 
-    xPos /= 800;
-    yPos /= 600;
+    app.numHoveredBounds = 0;
 
-//    printf("X pos -> %f\n", xPos);
-//    printf("Y pos -> %f\n", yPos);
+    for(uint16_t hit = 0; hit < numHits; hit++)
+    {
+        const MouseBounds& mouseBounds = app.onMouseEventOpBindings.bounds[hitIndices[hit]];
+
+        if(mouseBounds.numSubAreas == 0 || hitTestSubAreas(app.onMouseEventOpBindings, mouseBounds, xFixed, yFixed, app.swapChainExtent)) {
+            app.hoveredBoundsIndices[app.numHoveredBounds++] = hitIndices[hit];
+        }
+    }
 
     for(uint16_t i = 0; i < app.numActiveBounds; i++)
     {
         const MouseBounds& mouseBounds = app.onMouseEventOpBindings.bounds[ app.activeBoundsIndices[i] ];
-        const NormalizedRect& boundsArea = mouseBounds.boundsArea;
 
-        if( boundsArea.topLeftPoint.x.get() > xPos ||
-            normfloat16::add(boundsArea.topLeftPoint.x, boundsArea.width) < xPos ||
-            boundsArea.topLeftPoint.y.get() > yPos ||
-            normfloat16::add(boundsArea.topLeftPoint.y, boundsArea.height) < yPos)
+        if(! hitTestBounds(app.onMouseEventOpBindings, app.activeBoundsIndices[i], xFixed, yFixed, app.swapChainExtent))
         {
             printf("left active area\n");
 
             removeArrayIndex(app.activeBoundsIndices, 10, i);
             app.numActiveBounds--;
 
+            if(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_CHAINS)
+            {
+                runOperationChain(app, mouseBounds.onHoverExitOperation);
+                assert(app.numActiveBounds == 0);
+                continue;
+            }
+
             // TODO: If this works, remove all the function calls and add indices to a temp array and call in a loop
             switch(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_ENTER_MASK)
             {
@@ -1214,7 +2012,8 @@ static void onCursorPosChanged(GLFWwindow * window, double xPos, double yPos)
                     switch(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_EXIT_MASK)
                     {
                         case MOUSE_BOUNDS_FLAGS_3_ON_HOVER_EXIT:
-                            handleOperation(app, mouseBounds.numSubAreas);
+                            // Would need a sixth operation slot, numSubAreas is not an operation index
+                            assert(false && "3 ON_HOVER_ENTER with 3 ON_HOVER_EXIT is not supported, use MOUSE_BOUNDS_FLAGS_CHAINS");
                         [[fallthrough]];
                         case MOUSE_BOUNDS_FLAGS_2_ON_HOVER_EXIT:
                             handleOperation(app, mouseBounds.onMClickOperation);
@@ -1257,28 +2056,17 @@ static void onCursorPosChanged(GLFWwindow * window, double xPos, double yPos)
         }
     }
 
-    for(uint16_t i = 0; i < app.onMouseEventOpBindings.numBounds; i++)
+    for(uint16_t hovered = 0; hovered < app.numHoveredBounds; hovered++)
     {
+        const uint16_t i = app.hoveredBoundsIndices[hovered];
         const MouseBounds& mouseBounds = app.onMouseEventOpBindings.bounds[i];
-        const NormalizedRect& boundsArea = mouseBounds.boundsArea;
-
-//        printf("TL X %f\n", boundsArea.topLeftPoint.x.get());
-//        printf("TL Y %f\n", boundsArea.topLeftPoint.y.get());
-//        printf("Width %f\n", boundsArea.width.get());
-//        printf("Height %f\n", boundsArea.height.get());
-//        printf("TL X + Width %f\n", normfloat16::add(boundsArea.topLeftPoint.x, boundsArea.width));
-//        printf("TL Y + Height %f\n", normfloat16::add(boundsArea.topLeftPoint.y, boundsArea.height));
 
         if((mouseBounds.flags & MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_ENTER_MASK) == MOUSE_BOUNDS_FLAGS_0_ON_HOVER_ENTER) {
             continue;
         }
 
         if( (!isActiveBoundsIndex(app, i)) &&
-            mouseBounds.onHoverEnterOperation != UINT8_MAX &&
-            xPos >= boundsArea.topLeftPoint.x.get() &&
-            xPos <= normfloat16::add(boundsArea.topLeftPoint.x, boundsArea.width) &&
-            yPos >= boundsArea.topLeftPoint.y.get() &&
-            yPos <= normfloat16::add(boundsArea.topLeftPoint.y, boundsArea.height))
+            mouseBounds.onHoverEnterOperation != OPERATION_INDEX_INVALID)
         {
             printf("Entered bounds\n");
 
@@ -1288,6 +2076,11 @@ static void onCursorPosChanged(GLFWwindow * window, double xPos, double yPos)
                 app.numActiveBounds++;
             }
 
+            if(mouseBounds.flags & MOUSE_BOUNDS_FLAGS_CHAINS) {
+                runOperationChain(app, mouseBounds.onHoverEnterOperation);
+                continue;
+            }
+
             if(mouseBounds.flags == 0) {
                 handleOperation(app, app.onMouseEventOpBindings.bounds[i].onHoverEnterOperation);
                 continue;
@@ -1310,18 +2103,28 @@ static void onCursorPosChanged(GLFWwindow * window, double xPos, double yPos)
     }
 }
 
-VulkanApplication setupApplication()
+VulkanApplication setupApplication(bool headless)
 {
     setvbuf(stdout, nullptr, _IOLBF, 0);
 
     VulkanApplication app;
 
-    initializeVulkan(app);
+    if(headless)
+    {
+        initializeVulkanHeadless(app, vconfig::INITIAL_WINDOW_WIDTH, vconfig::INITIAL_WINDOW_HEIGHT);
+    } else
+    {
+        initializeVulkan(app);
 
-    glfwSetWindowUserPointer(app.window, reinterpret_cast<void *>(&app));
-    glfwSetCursorPosCallback(app.window, onCursorPosChanged);
+        glfwSetWindowUserPointer(app.window, reinterpret_cast<void *>(&app));
+        glfwSetCursorPosCallback(app.window, onCursorPosChanged);
 
-    glfwSetFramebufferSizeCallback(app.window, framebufferResizeCallback);
+        glfwSetFramebufferSizeCallback(app.window, framebufferResizeCallback);
+        glfwSetWindowRefreshCallback(app.window, windowRefreshCallback);
+        glfwSetKeyCallback(app.window, onKeyEvent);
+        glfwSetMouseButtonCallback(app.window, onMouseButtonEvent);
+        glfwSetScrollCallback(app.window, onScrollEvent);
+    }
 
     app.pipelineDrawOrder[0] = PipelineType::PrimativeShapes;
     app.pipelineDrawOrder[1] = PipelineType::Texture;
@@ -1331,29 +2134,29 @@ VulkanApplication setupApplication()
 
 {   // BEGIN `texturesPipeline` CREATION
 
-    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+    // Created before the pipeline as its layout is part of the pipeline layout
+    createTextureTable(app.device, app.descriptorIndexingEnabled, vconfig::MAX_TEXTURES, app.textures);
 
-    VkDescriptorSetLayoutBinding samplerLayoutBinding = {};
-    samplerLayoutBinding.binding = 0;
-    samplerLayoutBinding.descriptorCount = 1;
-    samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerLayoutBinding.pImmutableSamplers = nullptr;
-    samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-
-    descriptorSetLayoutBindings.push_back(samplerLayoutBinding);
+    DescriptorSetLayoutBindings descriptorSetLayoutBindings;
+    descriptorSetLayoutBindings.push_back(transformsLayoutBinding());
 
     GenericGraphicsPipelineSetup textureGraphicsPipelineCreateInfo;
 
-    textureGraphicsPipelineCreateInfo.vertexShaderPath = "shaders/vert.spv";
-    textureGraphicsPipelineCreateInfo.fragmentShaderPath = "shaders/frag.spv";
+    textureGraphicsPipelineCreateInfo.vertexShaderPath = UI_VERTEX_SHADER_PATH;
+    textureGraphicsPipelineCreateInfo.fragmentShaderPath = (app.textures.isBindless) ? UI_BINDLESS_FRAGMENT_SHADER_PATH : UI_FRAGMENT_SHADER_PATH;
+    textureGraphicsPipelineCreateInfo.features = SHADER_FEATURE_TEXTURED;
     textureGraphicsPipelineCreateInfo.device = app.device;
+    textureGraphicsPipelineCreateInfo.variants = &app.pipelineVariants;
     textureGraphicsPipelineCreateInfo.swapChainImageFormat = app.swapChainImageFormat;
     textureGraphicsPipelineCreateInfo.vertexBindingDescription = Vertex::getBindingDescription();
     textureGraphicsPipelineCreateInfo.vertexAttributeDescriptions = Vertex::getAttributeDescriptions();
     textureGraphicsPipelineCreateInfo.swapChainExtent = app.swapChainExtent;
     textureGraphicsPipelineCreateInfo.descriptorSetLayoutBindings = descriptorSetLayoutBindings;
+    textureGraphicsPipelineCreateInfo.textureSetLayout = app.textures.descriptorSetLayout;
+    textureGraphicsPipelineCreateInfo.texturesAreBindless = app.textures.isBindless;
     textureGraphicsPipelineCreateInfo.swapChainSize = static_cast<uint8_t>(app.swapChainImages.size());
     textureGraphicsPipelineCreateInfo.swapChainImageViews = app.swapChainImageViews;
+    textureGraphicsPipelineCreateInfo.finalLayout = app.swapChainImageFinalLayout;
 
     GenericGraphicsPipelineTargets texturesPipelineSetup
     {
@@ -1380,8 +2183,17 @@ VulkanApplication setupApplication()
     vkMapMemory(app.device, app.verticesMemory, 0, vconfig::PIPELINE_MEMORY_SIZE, 0, reinterpret_cast<void**>(&app.mappedVerticesMemory));
     vkMapMemory(app.device, app.indicesMemory, 0, vconfig::PIPELINE_MEMORY_SIZE, 0, reinterpret_cast<void**>(&app.mappedIndicesMemory));
 
+    // Vertices reference transform 0 (The identity) until they're given their own (See attachTransform)
+    memset(app.mappedVerticesMemory, 0, vconfig::PIPELINE_MEMORY_SIZE);
+
     app.entitySystem = {};
     app.entitySystem.verticesComponentBasePtr = app.mappedVerticesMemory;
+    app.perFrameOperations.reserve(vconfig::MAX_PER_FRAME_OPERATIONS);
+    app.animations.reserve(vconfig::MAX_ANIMATIONS);
+    app.entitySystem.transforms.reserve(vconfig::MAX_TRANSFORMS);
+    app.layout.reserve(vconfig::MAX_LAYOUT_NODES);
+    app.entitySystem.meshes.reserve(vconfig::MAX_CACHED_MESHES);
+    app.frameArena.reserve(vconfig::FRAME_ARENA_SIZE);
 
     texturesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)] = { 0, vconfig::PIPELINE_MEMORY_SIZE / 2 };
     texturesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::INDICES_BUFFER)] = { 0, vconfig::PIPELINE_MEMORY_SIZE / 2 };
@@ -1393,23 +2205,29 @@ VulkanApplication setupApplication()
 
 {   // BEGIN `primativeShapesPipeline` CREATION
 
-    // There aren't any descriptorSets being used for this pipeline
-    std::vector<VkDescriptorSetLayoutBinding> primativeShapesPipelineDescriptorSetLayoutBindings;
-
-    GenericGraphicsPipelineSetup graphicsPipelineCreateInfo;
+    // Only the transforms buffer
+    DescriptorSetLayoutBindings primativeShapesPipelineDescriptorSetLayoutBindings;
+    primativeShapesPipelineDescriptorSetLayoutBindings.push_back(transformsLayoutBinding());
 
     GenericGraphicsPipelineSetup primativeShapesGraphicsPipelineCreateInfo;
 
-    primativeShapesGraphicsPipelineCreateInfo.vertexShaderPath = "shaders/simple_vert.spv";
-    primativeShapesGraphicsPipelineCreateInfo.fragmentShaderPath = "shaders/simple_frag.spv";
+    // Same shaders as the texture pipeline, without TEXTURED. They still declare the texture table, so its layout is
+    // part of this pipeline's too
+    primativeShapesGraphicsPipelineCreateInfo.vertexShaderPath = UI_VERTEX_SHADER_PATH;
+    primativeShapesGraphicsPipelineCreateInfo.fragmentShaderPath = (app.textures.isBindless) ? UI_BINDLESS_FRAGMENT_SHADER_PATH : UI_FRAGMENT_SHADER_PATH;
+    primativeShapesGraphicsPipelineCreateInfo.features = 0;
     primativeShapesGraphicsPipelineCreateInfo.device = app.device;
+    primativeShapesGraphicsPipelineCreateInfo.variants = &app.pipelineVariants;
     primativeShapesGraphicsPipelineCreateInfo.swapChainImageFormat = app.swapChainImageFormat;
     primativeShapesGraphicsPipelineCreateInfo.vertexBindingDescription = BasicVertex::getBindingDescription();
     primativeShapesGraphicsPipelineCreateInfo.vertexAttributeDescriptions = BasicVertex::getAttributeDescriptions();
     primativeShapesGraphicsPipelineCreateInfo.swapChainExtent = app.swapChainExtent;
     primativeShapesGraphicsPipelineCreateInfo.descriptorSetLayoutBindings = primativeShapesPipelineDescriptorSetLayoutBindings;
+    primativeShapesGraphicsPipelineCreateInfo.textureSetLayout = app.textures.descriptorSetLayout;
+    primativeShapesGraphicsPipelineCreateInfo.texturesAreBindless = app.textures.isBindless;
     primativeShapesGraphicsPipelineCreateInfo.swapChainSize = static_cast<uint8_t>(app.swapChainImages.size());
     primativeShapesGraphicsPipelineCreateInfo.swapChainImageViews = app.swapChainImageViews;
+    primativeShapesGraphicsPipelineCreateInfo.finalLayout = app.swapChainImageFinalLayout;
 
     GenericGraphicsPipelineTargets primativeShapesPipelineSetup
     {
@@ -1509,6 +2327,13 @@ VulkanApplication setupApplication()
 
     // Create Texture Sampler END
 
+    // Vertex memory starts zeroed, so text points at the font atlas by default
+    if(registerTexture(app.device, app.textures, texturesPipeline.textureImageView, texturesPipeline.textureSampler) != 0) {
+        throw std::runtime_error("failed to register the font atlas as texture 0!");
+    }
+
+    createImageAssets(app);
+
     createBufferOnMemory(   app.device,
                             texturesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)].size,
                             texturesPipeline.usageMap[static_cast<uint16_t>(MemoryUsageType::VERTEX_BUFFER)].offset,
@@ -1537,65 +2362,20 @@ VulkanApplication setupApplication()
                             app.indicesMemory,
                             primativeShapesPipeline.indexBuffer );
 
-    // Create Description Pool Begin
-    std::array<VkDescriptorPoolSize, 1> descriptorPoolSizes = {};
-
-    descriptorPoolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptorPoolSizes[0].descriptorCount = static_cast<uint32_t>(app.swapChainImages.size());
-
-    VkDescriptorPoolCreateInfo poolInfo = {};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
-    poolInfo.pPoolSizes = descriptorPoolSizes.data();
-    poolInfo.maxSets = static_cast<uint32_t>(app.swapChainImages.size());
-
-    if (vkCreateDescriptorPool(app.device, &poolInfo, nullptr, &app.descriptorPool) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create descriptor pool!");
-    }
-
-    // Create Description Pool END
-
-    // Create Description Sets BEGIN
-    std::vector<VkDescriptorSetLayout> layouts(app.swapChainImages.size(), texturesPipeline.descriptorSetLayout);
-
-    VkDescriptorSetAllocateInfo descriptorAllocInfo = {};
-    descriptorAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    descriptorAllocInfo.descriptorPool = app.descriptorPool;
-    descriptorAllocInfo.descriptorSetCount = static_cast<uint32_t>(app.swapChainImages.size());
-    descriptorAllocInfo.pSetLayouts = layouts.data();
-
-    texturesPipeline.descriptorSets.resize(app.swapChainImages.size());
-
-    if (vkAllocateDescriptorSets(app.device, &descriptorAllocInfo, texturesPipeline.descriptorSets.data()) != VK_SUCCESS) {
-        throw std::runtime_error("failed to allocate descriptor sets!");
-    }
-
-    for (size_t i = 0; i < app.swapChainImages.size(); i++)
-    {
-
-        VkDescriptorImageInfo imageInfo = {};
-
-        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        imageInfo.imageView = texturesPipeline.textureImageView;
-        imageInfo.sampler = texturesPipeline.textureSampler;
-
-        assert(texturesPipeline.textureImageView && "Image view = null");
-        assert(texturesPipeline.textureSampler && "Sampler = null");
-
-        std::array<VkWriteDescriptorSet, 1> descriptorWrites = {};
+    createBuffer(   app.device,
+                    app.physicalDevice,
+                    vconfig::MAX_TRANSFORMS * sizeof(GpuTransform),
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    app.transformsBuffer,
+                    app.transformsMemory );
 
-        descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-        descriptorWrites[0].dstSet = texturesPipeline.descriptorSets[i];
-        descriptorWrites[0].dstBinding = 0;
-        descriptorWrites[0].dstArrayElement = 0;
-        descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        descriptorWrites[0].descriptorCount = 1;
-        descriptorWrites[0].pImageInfo = &imageInfo;
+    vkMapMemory(app.device, app.transformsMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&app.mappedTransforms));
 
-        vkUpdateDescriptorSets(app.device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-    }
+    // Writes the root before anything is drawn
+    app.entitySystem.transforms.flush(app.mappedTransforms);
 
-    // Create Description Sets END
+    createDescriptorSets(app);
 
     // Create Command Buffers BEGIN
 
@@ -1638,6 +2418,7 @@ VulkanApplication setupApplication()
 }
 
 bool updateGenericGraphicsPipeline( VkDevice device,
+                                    PipelineVariants& variants,
                                     VkExtent2D swapchainExtent,
                                     std::vector<VkImageView>& swapChainImageViews,
                                     uint8_t swapchainSize,
@@ -1663,81 +2444,8 @@ bool updateGenericGraphicsPipeline( VkDevice device,
         throw std::runtime_error("failed to create render pass!");
     }
 
-    if(setupCache.descriptorSetLayoutBindings.size() == 0) {
-        out.descriptorSetLayout = nullptr;
-    } else {
-
-        VkDescriptorSetLayoutCreateInfo layoutInfo = {};
-        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(setupCache.descriptorSetLayoutBindings.size());
-        layoutInfo.pBindings = setupCache.descriptorSetLayoutBindings.data();
-
-        if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, out.descriptorSetLayout) != VK_SUCCESS) {
-            throw std::runtime_error("failed to create descriptor set layout!");
-        }
-    }
-
-    // TODO: Get rid of VertexInputInfo structure as it can be reconstructed and isn't providing any value as-is
-    setupCache.vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    setupCache.vertexInputInfo.vertexBindingDescriptionCount = 1;
-    setupCache.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(setupCache.vertexAttributeDescriptions.size());
-    setupCache.vertexInputInfo.pVertexBindingDescriptions = &setupCache.vertexBindingDescription;
-    setupCache.vertexInputInfo.pVertexAttributeDescriptions = setupCache.vertexAttributeDescriptions.data();
-
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(swapchainExtent.width);
-    viewport.height = static_cast<float>(swapchainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = swapchainExtent;
-
-//    VkPipelineViewportStateCreateInfo viewportState = {};
-    setupCache.viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    setupCache.viewportState.viewportCount = 1;
-    setupCache.viewportState.pViewports = &viewport;
-    setupCache.viewportState.scissorCount = 1;
-    setupCache.viewportState.pScissors = &scissor;
-
-    setupCache.pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-    if(setupCache.descriptorSetLayoutBindings.size() == 0)
-    {
-        setupCache.pipelineLayoutInfo.setLayoutCount = 0;
-        setupCache.pipelineLayoutInfo.pSetLayouts = nullptr;
-    } else
-    {
-        setupCache.pipelineLayoutInfo.setLayoutCount = 1;
-        setupCache.pipelineLayoutInfo.pSetLayouts = out.descriptorSetLayout;
-    }
-
-    if (vkCreatePipelineLayout(device, &setupCache.pipelineLayoutInfo, nullptr, out.pipelineLayout) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create pipeline layout!");
-    }
-
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = setupCache.shaderStages;
-    pipelineInfo.pVertexInputState = &setupCache.vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &setupCache.inputAssembly;
-    pipelineInfo.pViewportState = &setupCache.viewportState;
-    pipelineInfo.pRasterizationState = &setupCache.rasterizer;
-    pipelineInfo.pMultisampleState = &setupCache.multisampling;
-    pipelineInfo.pColorBlendState = &setupCache.colorBlending;
-    pipelineInfo.layout = *out.pipelineLayout;
-    pipelineInfo.renderPass = *out.renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, out.graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
-    }
+    // The new render pass has the same format, so this finds the pipeline built when it was created
+    *out.graphicsPipeline = findOrCreatePipeline(device, variants, setupCache.variant, *out.renderPass);
 
     out.swapChainFramebuffers->resize(swapchainSize);
 
@@ -1754,7 +2462,7 @@ bool updateGenericGraphicsPipeline( VkDevice device,
 bool createGenericGraphicsPipeline(const GenericGraphicsPipelineSetup& params, GenericGraphicsPipelineTargets& out, PipelineSetupData &outSetup, bool clearFirst)
 {
 
-    outSetup.descriptorSetLayoutBindings = params.descriptorSetLayoutBindings;
+    outSetup.textureSetLayout = params.textureSetLayout;
 
     VkAttachmentDescription colorAttachment = {};
     colorAttachment.format = params.swapChainImageFormat;
@@ -1763,8 +2471,8 @@ bool createGenericGraphicsPipeline(const GenericGraphicsPipelineSetup& params, G
     colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = (clearFirst) ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    colorAttachment.initialLayout = (clearFirst) ? VK_IMAGE_LAYOUT_UNDEFINED : params.finalLayout;
+    colorAttachment.finalLayout = params.finalLayout;
 
     outSetup.attachmentDescription = colorAttachment;
 
@@ -1802,149 +2510,100 @@ bool createGenericGraphicsPipeline(const GenericGraphicsPipelineSetup& params, G
         throw std::runtime_error("failed to create render pass!");
     }
 
-    if(outSetup.descriptorSetLayoutBindings.size() == 0) {
+    if(params.descriptorSetLayoutBindings.size() == 0) {
         out.descriptorSetLayout = nullptr;
     } else {
 
         VkDescriptorSetLayoutCreateInfo layoutInfo = {};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = static_cast<uint32_t>(outSetup.descriptorSetLayoutBindings.size());
-        layoutInfo.pBindings = outSetup.descriptorSetLayoutBindings.data();
+        layoutInfo.bindingCount = static_cast<uint32_t>(params.descriptorSetLayoutBindings.size());
+        layoutInfo.pBindings = params.descriptorSetLayoutBindings.data();
 
         if (vkCreateDescriptorSetLayout(params.device, &layoutInfo, nullptr, out.descriptorSetLayout) != VK_SUCCESS) {
             throw std::runtime_error("failed to create descriptor set layout!");
         }
     }
 
-    auto vertShaderCode = readFile(params.vertexShaderPath.c_str());
-    auto fragShaderCode = readFile(params.fragmentShaderPath.c_str());
-
-    VkShaderModule vertShaderModule = createShaderModule(params.device, vertShaderCode);
-    VkShaderModule fragShaderModule = createShaderModule(params.device, fragShaderCode);
-
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShaderModule;
-    vertShaderStageInfo.pName = "main";
-
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShaderModule;
-    fragShaderStageInfo.pName = "main";
-
-    outSetup.shaderStages[0] = vertShaderStageInfo;
-    outSetup.shaderStages[1] = fragShaderStageInfo;
-
-    outSetup.vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-
-    outSetup.vertexBindingDescription = params.vertexBindingDescription;
-    outSetup.vertexAttributeDescriptions = params.vertexAttributeDescriptions;
-
-    outSetup.vertexInputInfo.vertexBindingDescriptionCount = 1;
-    outSetup.vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(outSetup.vertexAttributeDescriptions.size());
-    outSetup.vertexInputInfo.pVertexBindingDescriptions = &outSetup.vertexBindingDescription;
-    outSetup.vertexInputInfo.pVertexAttributeDescriptions = outSetup.vertexAttributeDescriptions.data();
-
-//    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-    outSetup.inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-    outSetup.inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-    outSetup.inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-    VkViewport viewport = {};
-    viewport.x = 0.0f;
-    viewport.y = 0.0f;
-    viewport.width = static_cast<float>(params.swapChainExtent.width);
-    viewport.height = static_cast<float>(params.swapChainExtent.height);
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-
-    VkRect2D scissor = {};
-    scissor.offset = {0, 0};
-    scissor.extent = params.swapChainExtent;
-
-//    VkPipelineViewportStateCreateInfo viewportState = {};
-    outSetup.viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    outSetup.viewportState.viewportCount = 1;
-    outSetup.viewportState.pViewports = &viewport;
-    outSetup.viewportState.scissorCount = 1;
-    outSetup.viewportState.pScissors = &scissor;
-
-//    VkPipelineRasterizationStateCreateInfo rasterizer = {};
-    outSetup.rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-    outSetup.rasterizer.depthClampEnable = VK_FALSE;
-    outSetup.rasterizer.rasterizerDiscardEnable = VK_FALSE;
-    outSetup.rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-    outSetup.rasterizer.lineWidth = 1.0f;
-    outSetup.rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-    outSetup.rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-    outSetup.rasterizer.depthBiasEnable = VK_FALSE;
-
-//    VkPipelineMultisampleStateCreateInfo multisampling = {};
-    outSetup.multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-    outSetup.multisampling.sampleShadingEnable = VK_FALSE;
-    outSetup.multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-
-//    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-    outSetup.colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-    outSetup.colorBlendAttachment.blendEnable = VK_TRUE;
-    outSetup.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-    outSetup.colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-
-    outSetup.colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-    outSetup.colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-
-    outSetup.colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-    outSetup.colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-
-//    VkPipelineColorBlendStateCreateInfo colorBlending = {};
-    outSetup.colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-    outSetup.colorBlending.logicOpEnable = VK_FALSE;
-    outSetup.colorBlending.logicOp = VK_LOGIC_OP_COPY;
-    outSetup.colorBlending.attachmentCount = 1;
-    outSetup.colorBlending.pAttachments = &outSetup.colorBlendAttachment;
-    outSetup.colorBlending.blendConstants[0] = 0.0f;
-    outSetup.colorBlending.blendConstants[1] = 0.0f;
-    outSetup.colorBlending.blendConstants[2] = 0.0f;
-    outSetup.colorBlending.blendConstants[3] = 0.0f;
-
-//    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    outSetup.pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-
-    if(outSetup.descriptorSetLayoutBindings.size() == 0)
+    assert(params.variants != nullptr);
+
+    VkShaderModule vertShaderModule = loadShaderModule(params.device, *params.variants, params.vertexShaderPath);
+    VkShaderModule fragShaderModule = loadShaderModule(params.device, *params.variants, params.fragmentShaderPath);
+
+    // SPIR-V that's out of date with the vertex layout or descriptor sets would otherwise read garbage, or nothing at all
+    uint32_t fedLocations = 0;
+    uint32_t setZeroBindings = 0;
+
+    for(const VkVertexInputAttributeDescription& attribute : params.vertexAttributeDescriptions) {
+        fedLocations |= 1u << attribute.location;
+    }
+
+    for(const VkDescriptorSetLayoutBinding& binding : params.descriptorSetLayoutBindings) {
+        setZeroBindings |= 1u << binding.binding;
+    }
+
+    const ShaderInterface& vertInterface = params.variants->interfaces.at(vertShaderModule);
+    const ShaderInterface& fragInterface = params.variants->interfaces.at(fragShaderModule);
+
+    if((vertInterface.inputLocations & ~fedLocations) != 0) {
+        throw std::runtime_error("failed to create graphics pipeline, the vertex shader reads inputs the vertex layout doesn't have!");
+    }
+
+    if(((vertInterface.bindings[0] | fragInterface.bindings[0]) & ~setZeroBindings) != 0) {
+        throw std::runtime_error("failed to create graphics pipeline, the shaders use bindings that set 0 doesn't have!");
+    }
+
+    const uint32_t textureTableBindings = (params.textureSetLayout != VK_NULL_HANDLE) ? (1u << TextureTable::BINDING) : 0;
+
+    if(((vertInterface.bindings[TextureTable::DESCRIPTOR_SET] | fragInterface.bindings[TextureTable::DESCRIPTOR_SET]) & ~textureTableBindings) != 0) {
+        throw std::runtime_error("failed to create graphics pipeline, the shaders sample a texture table the pipeline doesn't have!");
+    }
+
+    for(uint32_t set = TextureTable::DESCRIPTOR_SET + 1; set < ShaderInterface::MAX_DESCRIPTOR_SETS; set++)
+    {
+        if((vertInterface.bindings[set] | fragInterface.bindings[set]) != 0) {
+            throw std::runtime_error("failed to create graphics pipeline, the shaders use a descriptor set the pipeline doesn't have!");
+        }
+    }
+
+    // The module would be rejected by a device without descriptor indexing, or index a table with a single slot
+    if((vertInterface.needsDescriptorIndexing || fragInterface.needsDescriptorIndexing) && ! params.texturesAreBindless) {
+        throw std::runtime_error("failed to create graphics pipeline, the shaders need a bindless texture table!");
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+
+    // Followed by the texture table's layout as set 1, if the pipeline samples textures
+    VkDescriptorSetLayout setLayouts[2] = { VK_NULL_HANDLE, outSetup.textureSetLayout };
+
+    if(params.descriptorSetLayoutBindings.size() == 0)
     {
-        outSetup.pipelineLayoutInfo.setLayoutCount = 0;
-        outSetup.pipelineLayoutInfo.pSetLayouts = nullptr;
+        assert(outSetup.textureSetLayout == VK_NULL_HANDLE && "The texture table needs set 0 to exist");
+
+        pipelineLayoutInfo.setLayoutCount = 0;
+        pipelineLayoutInfo.pSetLayouts = nullptr;
     } else
     {
-        outSetup.pipelineLayoutInfo.setLayoutCount = 1;
-        outSetup.pipelineLayoutInfo.pSetLayouts = out.descriptorSetLayout;
+        setLayouts[0] = *out.descriptorSetLayout;
+
+        pipelineLayoutInfo.setLayoutCount = (outSetup.textureSetLayout != VK_NULL_HANDLE) ? 2 : 1;
+        pipelineLayoutInfo.pSetLayouts = setLayouts;
     }
 
-    if (vkCreatePipelineLayout(params.device, &outSetup.pipelineLayoutInfo, nullptr, out.pipelineLayout) != VK_SUCCESS) {
+    if (vkCreatePipelineLayout(params.device, &pipelineLayoutInfo, nullptr, out.pipelineLayout) != VK_SUCCESS) {
         throw std::runtime_error("failed to create pipeline layout!");
     }
 
-    VkGraphicsPipelineCreateInfo pipelineInfo = {};
-    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
-    pipelineInfo.pStages = outSetup.shaderStages;
-    pipelineInfo.pVertexInputState = &outSetup.vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &outSetup.inputAssembly;
-    pipelineInfo.pViewportState = &outSetup.viewportState;
-    pipelineInfo.pRasterizationState = &outSetup.rasterizer;
-    pipelineInfo.pMultisampleState = &outSetup.multisampling;
-    pipelineInfo.pColorBlendState = &outSetup.colorBlending;
-    pipelineInfo.layout = *out.pipelineLayout;
-    pipelineInfo.renderPass = *out.renderPass;
-    pipelineInfo.subpass = 0;
-    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
-
-    if (vkCreateGraphicsPipelines(params.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, out.graphicsPipeline) != VK_SUCCESS) {
-        throw std::runtime_error("failed to create graphics pipeline!");
-    }
+    outSetup.variant = makePipelineVariantKey(  vertShaderModule,
+                                                fragShaderModule,
+                                                params.features,
+                                                *out.pipelineLayout,
+                                                params.swapChainImageFormat,
+                                                params.vertexBindingDescription.stride,
+                                                params.vertexAttributeDescriptions.data(),
+                                                params.vertexAttributeDescriptions.size() );
+
+    *out.graphicsPipeline = findOrCreatePipeline(params.device, *params.variants, outSetup.variant, *out.renderPass);
 
     out.swapChainFramebuffers->resize(params.swapChainSize);
 
@@ -12,6 +12,8 @@
 #include <cstring>
 #include <cstdlib>
 #include <cstdint>
+#include <cmath>
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <thread>
@@ -23,24 +25,89 @@
 #include "text.h"
 #include "config.h"
 #include "input.h"
+#include "instrumentation.h"
+#include "trace.h"
+#include "headless.h"
+#include "opchain.h"
+#include "animation.h"
+#include "hittest.h"
 
 void recreateSwapChain(VulkanApplication& app);
 
 void drawFrame(VulkanApplication& app);
 void mainLoop(VulkanApplication& app);
+// Returns false if the final frame doesn't show the example scene, or differs from the image at expectedImagePath by
+// more than vconfig::GOLDEN_IMAGE_MAX_DIFFERENT_PIXELS pixels. expectedImagePath can be null
+bool headlessLoop(VulkanApplication& app, uint32_t numFrames, const char * outputImagePath, const char * expectedImagePath);
+
+// Resizes the offscreen images and rebuilds everything that depends on the extent, like recreateSwapChain does on a window resize
+void resizeHeadless(VulkanApplication& app, uint32_t width, uint32_t height);
 
 bool removeArrayIndex(uint16_t *array, uint16_t arraySize, uint16_t arrayIndex);
 
 void loopLogic(VulkanApplication& app, std::chrono::milliseconds delta);
+void recordCommandBuffers(VulkanApplication& app);
 void loadInitialMeshData(VulkanApplication& app, uint32_t delta);
 
-uint32_t drawText(VulkanApplication& app, NormalizedPoint point, std::string& text);
+// Return the entity of the text's vertices. Both are given a colour component, for the button it's on its background
+Entity32 drawText(VulkanApplication& app, NormalizedPoint point, std::string& text);
+Entity32 button(VulkanApplication& app, glm::vec3 color, std::string& text, NormalizedPoint tlPoint);
+
+// Adds mouse bounds that belong to the entity and records them in its bounds component. Returns the bounds index
+uint16_t bindBounds(VulkanApplication& app, Entity32 entity, const MouseBounds& mouseBounds);
+
+// Releases an entity drawn by any widget. Stops the animations and per frame moves that target it and makes its
+// triangles degenerate, as its vertex and index ranges stay in the pipeline. Releasing a stale handle does nothing
+void releaseEntity(VulkanApplication& app, Entity32 entity);
+
+// Draws an image from loadImage, stretched to width and height. It shows as transparent until the image has been
+// uploaded. ENTITY_INVALID for INVALID_IMAGE
+Entity32 image(VulkanApplication& app, uint32_t imageAsset, NormalizedPoint tlPoint, NormFloat16 width, NormFloat16 height);
+
+// Replaces the text drawn by an entity from drawText or button, keeping its place and vertex range. Text with the
+// same content does nothing. Returns false if nothing changed, or the text doesn't fit the entity's range
+bool setText(VulkanApplication& app, Entity32 textEntity, std::string& text);
+
+// Gives the entity its own node in app.entitySystem.transforms and points its vertices at it. Vertex positions are then
+// relative to the node, and moving the entity only changes the transform. Returns TransformHierarchy::INVALID_NODE if full
+uint32_t attachTransform(VulkanApplication& app, Entity32 entity, uint32_t parentNode, const Affine2D& localTransform);
+
+// The entity is then placed by layoutNode, which it becomes the owner of. origin is where the top left of its mesh
+// currently is. Gives the entity a transform, so it mustn't already have one. Returns false if out of transforms
+bool bindLayout(VulkanApplication& app, Entity32 entity, uint32_t layoutNode, NormalizedPoint origin);
+
+// Updates app.layout and moves the entities whose node changed. Called by loopLogic
+void applyLayout(VulkanApplication& app);
+
+// Writes world transforms that changed to the transforms buffer. Called by loopLogic
+void flushTransforms(VulkanApplication& app);
 
 int16_t doublePercentageToInt16(double value);
 float int16PercentageToFloat(int16_t value);
 double int16PercentageToDouble(int16_t value);
 
-static void handleOperation(VulkanApplication& app, uint16_t operationIndex);
+void handleOperation(VulkanApplication& app, uint16_t operationIndex);
+void handleOperation4(VulkanApplication& app, Operation4& operation);
+void handleOperation8(VulkanApplication& app, Operation8& operation);
+
+// Active bounds have run their hover enter operations and are waiting to run their exit operations. Hovered bounds are
+// every bounds under the cursor, whether or not they have hover operations
+bool isActiveBoundsIndex(VulkanApplication& app, uint16_t boundsIndex);
+bool isHoveredBoundsIndex(VulkanApplication& app, uint16_t boundsIndex);
+
+// Marks the next frame as needing to be drawn when the main loop is idle
+void requestRedraw();
+
+// Cursor position is in window pixels, as given by GLFW
+void handleCursorMove(VulkanApplication& app, double xPos, double yPos);
+
+// Runs everything queued in app.input since the last call
+void processInput(VulkanApplication& app);
+
+// Run bound operations. Key and button values are GLFW's. Clicks go to the bounds under the cursor as of the last cursor move
+void handleKey(VulkanApplication& app, int key, int action, int mods);
+void handleClick(VulkanApplication& app, int button);
+void handleScroll(VulkanApplication& app, double xOffset, double yOffset);
 
 void createVertexBuffer(    const VkDevice device,
                             const VkPhysicalDevice physicalDevice,
@@ -52,11 +119,13 @@ void createVertexBuffer(    const VkDevice device,
                             VkDeviceMemory& outVertexBufferMemory,
                             void ** outMappedMemory );
 
-VulkanApplication setupApplication();
+VulkanApplication setupApplication(bool headless);
 
 bool createGenericGraphicsPipeline(const GenericGraphicsPipelineSetup& params, GenericGraphicsPipelineTargets& out, PipelineSetupData& outSetup, bool clearFirst);
 
+// Recreates the render pass and framebuffers for the new swapchain. The pipeline is found in variants rather than rebuilt
 bool updateGenericGraphicsPipeline( VkDevice device,
+                                    PipelineVariants& variants,
                                     VkExtent2D swapchainExtent,
                                     std::vector<VkImageView>& swapChainImageViews,
                                     uint8_t swapchainSize,
@@ -0,0 +1,122 @@
+#include "meshcache.h"
+
+#include <cassert>
+#include <cstring>
+#include <functional>
+
+#include "vertexkernels.h"
+
+size_t MeshKeyHash::operator()(const MeshKey& key) const
+{
+    size_t hash = std::hash<std::string>()(key.text);
+
+    const uint64_t packed[] = { key.type, key.style, static_cast<uint32_t>(key.width), static_cast<uint32_t>(key.height) };
+
+    for(uint64_t value : packed) {
+        hash ^= std::hash<uint64_t>()(value) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+    }
+
+    return hash;
+}
+
+void MeshCache::reserve(uint32_t maxMeshes)
+{
+    assert(maxMeshes > 0);
+
+    capacity = maxMeshes;
+
+    clear();
+
+    lookup.reserve(capacity);
+    meshes.reserve(capacity);
+    keys.reserve(capacity);
+}
+
+uint32_t MeshCache::find(const MeshKey& key)
+{
+    const auto found = lookup.find(key);
+
+    if(found == lookup.end()) {
+        numMisses++;
+        return INVALID_MESH;
+    }
+
+    numHits++;
+    return found->second;
+}
+
+uint32_t MeshCache::insert(const MeshKey& key, CachedMesh&& mesh)
+{
+    assert(lookup.find(key) == lookup.end() && "Mesh is already cached");
+    assert(mesh.vertices.size() == static_cast<size_t>(mesh.numVertices) * mesh.vertexStride);
+
+    if(freeMeshes.empty() && meshes.size() == capacity)
+    {
+        // Only happens on a miss with a full cache, so a scan is fine
+        for(uint32_t i = 0; i < meshes.size(); i++)
+        {
+            if(meshes[i].numUsers == 0)
+            {
+                lookup.erase(keys[i]);
+                meshes[i] = CachedMesh();
+                freeMeshes.push_back(i);
+                break;
+            }
+        }
+
+        if(freeMeshes.empty()) {
+            return INVALID_MESH;
+        }
+    }
+
+    uint32_t index;
+
+    if(! freeMeshes.empty())
+    {
+        index = freeMeshes.back();
+        freeMeshes.pop_back();
+
+        meshes[index] = std::move(mesh);
+        keys[index] = key;
+    } else
+    {
+        index = static_cast<uint32_t>(meshes.size());
+
+        meshes.push_back(std::move(mesh));
+        keys.push_back(key);
+    }
+
+    meshes[index].numUsers = 0;
+    lookup.emplace(key, index);
+
+    return index;
+}
+
+void MeshCache::release(uint32_t mesh)
+{
+    assert(meshes[mesh].numUsers > 0);
+    meshes[mesh].numUsers--;
+}
+
+void MeshCache::write(uint32_t mesh, uint8_t * vertices, uint16_t * indices, uint16_t firstVertex, float x, float y) const
+{
+    const CachedMesh& cached = meshes[mesh];
+
+    memcpy(vertices, cached.vertices.data(), cached.vertices.size());
+    translateVertices(reinterpret_cast<float *>(vertices), cached.numVertices, cached.vertexStride, x, y);
+
+    for(size_t i = 0; i < cached.indices.size(); i++) {
+        indices[i] = static_cast<uint16_t>(cached.indices[i] + firstVertex);
+    }
+}
+
+void MeshCache::clear()
+{
+    lookup.clear();
+    meshes.clear();
+    keys.clear();
+    freeMeshes.clear();
+
+    numHits = 0;
+    numMisses = 0;
+}
@@ -0,0 +1,79 @@
+#ifndef MESHCACHE_H
+#define MESHCACHE_H
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <unordered_map>
+
+// Geometry generated for widget content, so widgets with the same content only generate it once and a widget that's
+// given the content it already has does nothing. Meshes are kept relative to the widget's top left and are copied
+// into a pipeline's vertex and index memory where the widget is placed (See MeshCache::write)
+
+// Everything a widget's geometry depends on
+struct MeshKey
+{
+    uint8_t type;       // UIType
+    uint32_t style;     // E.g. a packed colour
+    int32_t width;      // fixed16 units, 0 when the size comes from the content
+    int32_t height;
+    std::string text;
+
+    inline bool operator==(const MeshKey& other) const {
+        return type == other.type && style == other.style && width == other.width && height == other.height && text == other.text;
+    }
+};
+
+struct MeshKeyHash
+{
+    size_t operator()(const MeshKey& key) const;
+};
+
+struct CachedMesh
+{
+    std::vector<uint8_t> vertices;  // numVertices * vertexStride bytes, positions are the first member
+    std::vector<uint16_t> indices;  // Relative to the first vertex
+    uint16_t numVertices;
+    uint16_t vertexStride;
+    uint32_t numUsers;
+};
+
+struct MeshCache
+{
+    static const constexpr uint32_t INVALID_MESH = UINT32_MAX;
+
+    std::unordered_map<MeshKey, uint32_t, MeshKeyHash> lookup;
+    std::vector<CachedMesh> meshes;
+    std::vector<MeshKey> keys;      // Key of each mesh, for eviction
+    std::vector<uint32_t> freeMeshes;
+
+    uint32_t capacity = 0;
+    uint32_t numHits = 0;
+    uint32_t numMisses = 0;
+
+    void reserve(uint32_t maxMeshes);
+
+    // INVALID_MESH if nothing with this content has been generated (Or it's been evicted)
+    uint32_t find(const MeshKey& key);
+
+    // Meshes without users are kept until the cache is full, then evicted to make room. Returns INVALID_MESH if every
+    // mesh is in use
+    uint32_t insert(const MeshKey& key, CachedMesh&& mesh);
+
+    inline void retain(uint32_t mesh) {
+        meshes[mesh].numUsers++;
+    }
+
+    void release(uint32_t mesh);
+
+    // Copies the mesh with its positions offset by x, y and its indices starting at firstVertex
+    void write(uint32_t mesh, uint8_t * vertices, uint16_t * indices, uint16_t firstVertex, float x, float y) const;
+
+    void clear();
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(meshes.size() - freeMeshes.size());
+    }
+};
+
+#endif // MESHCACHE_H
@@ -0,0 +1,300 @@
+#include "opchain.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "mainvulkan.h"
+
+// Computed goto (A GCC / Clang extension) gives each instruction its own indirect branch, which predicts
+// far better than the single shared branch of a switch. Other compilers fall back to the switch
+#if defined(__GNUC__) || defined(__clang__)
+#define OPCHAIN_COMPUTED_GOTO
+#endif
+
+static const uint8_t MAX_CALL_DEPTH = 16;
+
+static inline uint16_t readU16(const uint8_t * position)
+{
+    uint16_t value;
+    memcpy(&value, position, sizeof(uint16_t));
+    return value;
+}
+
+static inline int16_t readI16(const uint8_t * position)
+{
+    int16_t value;
+    memcpy(&value, position, sizeof(int16_t));
+    return value;
+}
+
+// BEGIN OperationChainBuilder
+
+OperationChainBuilder::OperationChainBuilder(OperationChainProgram& program)
+    : program(program)
+{
+}
+
+uint16_t OperationChainBuilder::begin()
+{
+    assert(! inChain && "OperationChainBuilder::end must be called before starting another chain");
+    assert(program.code.size() <= UINT16_MAX);
+
+    inChain = true;
+    program.chainOffsets.push_back(static_cast<uint16_t>(program.code.size()));
+
+    return static_cast<uint16_t>(program.chainOffsets.size() - 1);
+}
+
+void OperationChainBuilder::end()
+{
+    assert(inChain);
+
+    emitCode(OpChainCode::RETURN);
+    inChain = false;
+
+    if(program.code.size() > UINT16_MAX) {
+        throw std::runtime_error("operation chain program exceeds 64KB!");
+    }
+}
+
+void OperationChainBuilder::runOperation(OperationIndex operationIndex)
+{
+    emitCode(OpChainCode::RUN_OPERATION);
+    emitU16(operationIndex);
+}
+
+void OperationChainBuilder::runOp4(uint8_t opCode, Operation4Union data)
+{
+    emitCode(OpChainCode::RUN_OP4);
+    program.code.push_back(opCode);
+
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&data);
+    program.code.insert(program.code.end(), bytes, bytes + sizeof(Operation4Union));
+}
+
+void OperationChainBuilder::runOp8(uint8_t opCode, Operation8Union data)
+{
+    emitCode(OpChainCode::RUN_OP8);
+    program.code.push_back(opCode);
+
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&data);
+    program.code.insert(program.code.end(), bytes, bytes + sizeof(Operation8Union));
+}
+
+void OperationChainBuilder::call(uint16_t chainIndex)
+{
+    emitCode(OpChainCode::CALL);
+    emitU16(chainIndex);
+}
+
+OpChainLabel OperationChainBuilder::jump()
+{
+    emitCode(OpChainCode::JUMP);
+    return emitJumpOffset();
+}
+
+OpChainLabel OperationChainBuilder::jumpIfOperationActive(OperationIndex operationIndex)
+{
+    emitCode(OpChainCode::JUMP_IF_OPERATION_ACTIVE);
+    emitU16(operationIndex);
+    return emitJumpOffset();
+}
+
+OpChainLabel OperationChainBuilder::jumpIfOperationInactive(OperationIndex operationIndex)
+{
+    emitCode(OpChainCode::JUMP_IF_OPERATION_INACTIVE);
+    emitU16(operationIndex);
+    return emitJumpOffset();
+}
+
+OpChainLabel OperationChainBuilder::jumpIfBoundsHovered(uint16_t boundsIndex)
+{
+    emitCode(OpChainCode::JUMP_IF_BOUNDS_HOVERED);
+    emitU16(boundsIndex);
+    return emitJumpOffset();
+}
+
+void OperationChainBuilder::bind(OpChainLabel label)
+{
+    // Offset is relative to the end of the jump instruction, which is where the offset field ends
+    const ptrdiff_t offset = static_cast<ptrdiff_t>(program.code.size()) - static_cast<ptrdiff_t>(label + sizeof(int16_t));
+    assert(offset >= INT16_MIN && offset <= INT16_MAX);
+
+    const int16_t offset16 = static_cast<int16_t>(offset);
+    memcpy(program.code.data() + label, &offset16, sizeof(int16_t));
+}
+
+void OperationChainBuilder::emitCode(OpChainCode code)
+{
+    assert(inChain && "OperationChainBuilder::begin must be called first");
+    program.code.push_back(static_cast<uint8_t>(code));
+}
+
+void OperationChainBuilder::emitU16(uint16_t value)
+{
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&value);
+    program.code.insert(program.code.end(), bytes, bytes + sizeof(uint16_t));
+}
+
+OpChainLabel OperationChainBuilder::emitJumpOffset()
+{
+    const OpChainLabel label = program.code.size();
+    emitU16(0);
+    return label;
+}
+
+// END OperationChainBuilder
+
+void runOperationChain(VulkanApplication& app, uint16_t chainIndex)
+{
+    TRACE_FUNCTION();
+
+    const OperationChainProgram& program = app.operationChains;
+
+    assert(chainIndex < program.chainOffsets.size() && "Invalid operation chain index");
+
+    const uint8_t * code = program.code.data();
+    const uint8_t * ip = code + program.chainOffsets[chainIndex];
+
+    const uint8_t * callStack[MAX_CALL_DEPTH];
+    uint8_t callDepth = 0;
+
+#ifdef OPCHAIN_COMPUTED_GOTO
+    // Must match the order of OpChainCode
+    static void * const dispatchTable[] = {
+        &&op_RETURN,
+        &&op_RUN_OPERATION,
+        &&op_RUN_OP4,
+        &&op_RUN_OP8,
+        &&op_CALL,
+        &&op_JUMP,
+        &&op_JUMP_IF_OPERATION_ACTIVE,
+        &&op_JUMP_IF_OPERATION_INACTIVE,
+        &&op_JUMP_IF_BOUNDS_HOVERED
+    };
+
+    static_assert(sizeof(dispatchTable) / sizeof(void *) == static_cast<size_t>(OpChainCode::SIZE));
+
+    #define OPCHAIN_DISPATCH() goto *dispatchTable[*ip++]
+    #define OPCHAIN_TARGET(name) op_##name:
+#else
+    #define OPCHAIN_DISPATCH() goto dispatch
+    #define OPCHAIN_TARGET(name) case OpChainCode::name:
+#endif
+
+    OPCHAIN_DISPATCH();
+
+#ifndef OPCHAIN_COMPUTED_GOTO
+dispatch:
+    switch(static_cast<OpChainCode>(*ip++))
+    {
+#endif
+        OPCHAIN_TARGET(RETURN)
+        {
+            if(callDepth == 0) {
+                return;
+            }
+
+            ip = callStack[--callDepth];
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(RUN_OPERATION)
+        {
+            const OperationIndex operationIndex = readU16(ip);
+            ip += 2;
+
+            handleOperation(app, operationIndex);
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(RUN_OP4)
+        {
+            Operation4 operation;
+            operation.opCode = ip[0];
+            operation.flags = OPERATION_FLAGS_SIZE_4;
+            memcpy(&operation.opData, ip + 1, sizeof(Operation4Union));
+            ip += 1 + sizeof(Operation4Union);
+
+            handleOperation4(app, operation);
+            requestRedraw();
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(RUN_OP8)
+        {
+            Operation8 operation;
+            operation.opCode = ip[0];
+            operation.flags = OPERATION_FLAGS_SIZE_8;
+            memcpy(&operation.opData, ip + 1, sizeof(Operation8Union));
+            ip += 1 + sizeof(Operation8Union);
+
+            handleOperation8(app, operation);
+            requestRedraw();
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(CALL)
+        {
+            const uint16_t calledChain = readU16(ip);
+            ip += 2;
+
+            assert(calledChain < program.chainOffsets.size() && "Invalid operation chain index");
+
+            if(callDepth == MAX_CALL_DEPTH) {
+                assert(false && "Operation chain call depth exceeded");
+                return;
+            }
+
+            callStack[callDepth++] = ip;
+            ip = code + program.chainOffsets[calledChain];
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(JUMP)
+        {
+            const int16_t offset = readI16(ip);
+            ip += 2 + offset;
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(JUMP_IF_OPERATION_ACTIVE)
+        {
+            const OperationIndex operationIndex = readU16(ip);
+            const int16_t offset = readI16(ip + 2);
+            ip += 4;
+
+            if(app.opAt(operationIndex).flags & OPERATION_FLAGS_ACTIVE) {
+                ip += offset;
+            }
+
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(JUMP_IF_OPERATION_INACTIVE)
+        {
+            const OperationIndex operationIndex = readU16(ip);
+            const int16_t offset = readI16(ip + 2);
+            ip += 4;
+
+            if(! (app.opAt(operationIndex).flags & OPERATION_FLAGS_ACTIVE)) {
+                ip += offset;
+            }
+
+            OPCHAIN_DISPATCH();
+        }
+        OPCHAIN_TARGET(JUMP_IF_BOUNDS_HOVERED)
+        {
+            const uint16_t boundsIndex = readU16(ip);
+            const int16_t offset = readI16(ip + 2);
+            ip += 4;
+
+            if(isHoveredBoundsIndex(app, boundsIndex)) {
+                ip += offset;
+            }
+
+            OPCHAIN_DISPATCH();
+        }
+#ifndef OPCHAIN_COMPUTED_GOTO
+        default:
+            assert(false && "Invalid operation chain instruction");
+            return;
+    }
+#endif
+
+    #undef OPCHAIN_DISPATCH
+    #undef OPCHAIN_TARGET
+}
@@ -0,0 +1,78 @@
+#ifndef OPCHAIN_H
+#define OPCHAIN_H
+
+// Operation chains
+// A chain is a sequence of bytecode instructions stored in VulkanApplication::operationChains. Chains can run existing
+// operations, branch on operation / hover state and call other chains, so widget behaviour can be described as data.
+//
+// Instruction encoding: a one byte OpChainCode followed by its operands. Multi byte operands are little endian and
+// unaligned. Jump offsets are signed and relative to the end of the jump instruction.
+//
+//  RETURN                                                  Return to the calling chain, or stop
+//  RUN_OPERATION               u16 operationIndex          handleOperation (Activates per-frame operations)
+//  RUN_OP4                     u8 opCode, 2 byte data      handleOperation4 on an inline operation
+//  RUN_OP8                     u8 opCode, 6 byte data      handleOperation8 on an inline operation
+//  CALL                        u16 chainIndex
+//  JUMP                        i16 offset
+//  JUMP_IF_OPERATION_ACTIVE    u16 operationIndex, i16 offset
+//  JUMP_IF_OPERATION_INACTIVE  u16 operationIndex, i16 offset
+//  JUMP_IF_BOUNDS_HOVERED      u16 boundsIndex, i16 offset
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "typesvulkan.h"
+
+enum class OpChainCode : uint8_t
+{
+    RETURN = 0,
+    RUN_OPERATION,
+    RUN_OP4,
+    RUN_OP8,
+    CALL,
+    JUMP,
+    JUMP_IF_OPERATION_ACTIVE,
+    JUMP_IF_OPERATION_INACTIVE,
+    JUMP_IF_BOUNDS_HOVERED,
+    SIZE
+};
+
+// Position of a jump offset that still needs to be patched
+typedef size_t OpChainLabel;
+
+// Appends chains to an OperationChainProgram. Forward jumps return a label which is later bound to the
+// current end of the chain with `bind`
+class OperationChainBuilder
+{
+public:
+    explicit OperationChainBuilder(OperationChainProgram& program);
+
+    // Starts a new chain and returns its index. Chains can't be nested, call `end` first
+    uint16_t begin();
+    void end();
+
+    void runOperation(OperationIndex operationIndex);
+    void runOp4(uint8_t opCode, Operation4Union data);
+    void runOp8(uint8_t opCode, Operation8Union data);
+    void call(uint16_t chainIndex);
+
+    OpChainLabel jump();
+    OpChainLabel jumpIfOperationActive(OperationIndex operationIndex);
+    OpChainLabel jumpIfOperationInactive(OperationIndex operationIndex);
+    // Taken while the cursor is over the bounds (See VulkanApplication::hoveredBoundsIndices), even if it has no hover operations
+    OpChainLabel jumpIfBoundsHovered(uint16_t boundsIndex);
+
+    void bind(OpChainLabel label);
+
+private:
+    void emitCode(OpChainCode code);
+    void emitU16(uint16_t value);
+    OpChainLabel emitJumpOffset();
+
+    OperationChainProgram& program;
+    bool inChain = false;
+};
+
+void runOperationChain(VulkanApplication& app, uint16_t chainIndex);
+
+#endif // OPCHAIN_H
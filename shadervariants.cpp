@@ -0,0 +1,325 @@
+#include "shadervariants.h"
+
+#include <cassert>
+#include <stdexcept>
+
+#include "vulkanhelper.h"
+
+size_t PipelineVariantKeyHash::operator()(const PipelineVariantKey& key) const
+{
+    // FNV-1a over the whole key, which has no padding (See PipelineVariantKey)
+    const uint8_t * bytes = reinterpret_cast<const uint8_t *>(&key);
+
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    for(size_t i = 0; i < sizeof(PipelineVariantKey); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return static_cast<size_t>(hash);
+}
+
+// The subset of SPIR-V that reflectShaderInterface reads. See the SPIR-V specification, section 3
+namespace spirv
+{
+    const uint32_t MAGIC = 0x07230203;
+    const uint32_t HEADER_WORDS = 5;
+
+    const uint16_t OP_CAPABILITY = 17;
+    const uint16_t OP_VARIABLE = 59;
+    const uint16_t OP_DECORATE = 71;
+
+    const uint32_t DECORATION_LOCATION = 30;
+    const uint32_t DECORATION_BINDING = 33;
+    const uint32_t DECORATION_DESCRIPTOR_SET = 34;
+
+    const uint32_t STORAGE_CLASS_INPUT = 1;
+
+    const uint32_t CAPABILITY_SHADER_NON_UNIFORM = 5301;
+    const uint32_t CAPABILITY_RUNTIME_DESCRIPTOR_ARRAY = 5302;
+}
+
+ShaderInterface reflectShaderInterface(const std::vector<char>& code)
+{
+    if(code.size() < spirv::HEADER_WORDS * sizeof(uint32_t) || code.size() % sizeof(uint32_t) != 0) {
+        throw std::runtime_error("failed to read shader, it isn't SPIR-V!");
+    }
+
+    const uint32_t numWords = static_cast<uint32_t>(code.size() / sizeof(uint32_t));
+    std::vector<uint32_t> words(numWords);
+    memcpy(words.data(), code.data(), code.size());
+
+    if(words[0] != spirv::MAGIC) {
+        throw std::runtime_error("failed to read shader, it isn't SPIR-V!");
+    }
+
+    // Decorations come before the variables they decorate, so they're gathered by id first
+    const uint32_t idBound = words[3];
+    const uint32_t UNSET = UINT32_MAX;
+
+    std::vector<uint32_t> locations(idBound, UNSET);
+    std::vector<uint32_t> sets(idBound, UNSET);
+    std::vector<uint32_t> bindings(idBound, UNSET);
+
+    ShaderInterface interface;
+
+    for(uint32_t i = spirv::HEADER_WORDS; i < numWords;)
+    {
+        const uint16_t opcode = static_cast<uint16_t>(words[i] & 0xFFFF);
+        const uint16_t wordCount = static_cast<uint16_t>(words[i] >> 16);
+
+        if(wordCount == 0 || i + wordCount > numWords) {
+            throw std::runtime_error("failed to read shader, it isn't SPIR-V!");
+        }
+
+        if(opcode == spirv::OP_CAPABILITY && wordCount >= 2)
+        {
+            if(words[i + 1] == spirv::CAPABILITY_SHADER_NON_UNIFORM || words[i + 1] == spirv::CAPABILITY_RUNTIME_DESCRIPTOR_ARRAY) {
+                interface.needsDescriptorIndexing = true;
+            }
+        }
+
+        if(opcode == spirv::OP_DECORATE && wordCount >= 4 && words[i + 1] < idBound)
+        {
+            const uint32_t target = words[i + 1];
+
+            switch(words[i + 2])
+            {
+                case spirv::DECORATION_LOCATION: locations[target] = words[i + 3]; break;
+                case spirv::DECORATION_BINDING: bindings[target] = words[i + 3]; break;
+                case spirv::DECORATION_DESCRIPTOR_SET: sets[target] = words[i + 3]; break;
+                default: break;
+            }
+        }
+
+        if(opcode == spirv::OP_VARIABLE && wordCount >= 4 && words[i + 2] < idBound)
+        {
+            const uint32_t variable = words[i + 2];
+
+            // Built-ins (E.g. gl_InstanceIndex) are inputs without a location
+            if(words[i + 3] == spirv::STORAGE_CLASS_INPUT && locations[variable] < 32) {
+                interface.inputLocations |= 1u << locations[variable];
+            }
+
+            if(bindings[variable] != UNSET)
+            {
+                // No DescriptorSet decoration means set 0
+                const uint32_t set = (sets[variable] == UNSET) ? 0 : sets[variable];
+
+                if(set >= ShaderInterface::MAX_DESCRIPTOR_SETS || bindings[variable] >= 32) {
+                    throw std::runtime_error("failed to read shader, a resource is outside the sets it can be given!");
+                }
+
+                interface.bindings[set] |= 1u << bindings[variable];
+            }
+        }
+
+        i += wordCount;
+    }
+
+    return interface;
+}
+
+VkShaderModule loadShaderModule(VkDevice device, PipelineVariants& variants, const std::string& path)
+{
+    const auto found = variants.shaderModules.find(path);
+
+    if(found != variants.shaderModules.end()) {
+        return found->second;
+    }
+
+    const std::vector<char> code = readFile(path);
+
+    VkShaderModule shaderModule = createShaderModule(device, code);
+    variants.shaderModules.emplace(path, shaderModule);
+    variants.interfaces.emplace(shaderModule, reflectShaderInterface(code));
+
+    return shaderModule;
+}
+
+PipelineVariantKey makePipelineVariantKey(  VkShaderModule vertexShader,
+                                            VkShaderModule fragmentShader,
+                                            uint32_t features,
+                                            VkPipelineLayout layout,
+                                            VkFormat colorFormat,
+                                            uint32_t vertexStride,
+                                            const VkVertexInputAttributeDescription * vertexAttributes,
+                                            uint32_t numVertexAttributes )
+{
+    assert(numVertexAttributes <= MAX_VARIANT_VERTEX_ATTRIBUTES);
+    assert(features < (1u << NUM_SHADER_FEATURES));
+
+    PipelineVariantKey key;
+    memset(&key, 0, sizeof(key));
+
+    key.vertexShader = vertexShader;
+    key.fragmentShader = fragmentShader;
+    key.layout = layout;
+    key.features = features;
+    key.colorFormat = colorFormat;
+    key.vertexStride = vertexStride;
+    key.numVertexAttributes = numVertexAttributes;
+
+    for(uint32_t i = 0; i < numVertexAttributes; i++) {
+        key.vertexAttributes[i] = vertexAttributes[i];
+    }
+
+    return key;
+}
+
+static VkPipeline createPipeline(VkDevice device, const PipelineVariantKey& key, VkRenderPass renderPass)
+{
+    // Every feature is a bool constant, whether or not the stage uses it. Stages ignore entries they don't declare
+    VkBool32 featureValues[NUM_SHADER_FEATURES];
+    VkSpecializationMapEntry featureEntries[NUM_SHADER_FEATURES];
+
+    for(uint32_t i = 0; i < NUM_SHADER_FEATURES; i++)
+    {
+        featureValues[i] = (key.features & (1u << i)) ? VK_TRUE : VK_FALSE;
+        featureEntries[i] = { i, static_cast<uint32_t>(i * sizeof(VkBool32)), sizeof(VkBool32) };
+    }
+
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = NUM_SHADER_FEATURES;
+    specializationInfo.pMapEntries = featureEntries;
+    specializationInfo.dataSize = sizeof(featureValues);
+    specializationInfo.pData = featureValues;
+
+    VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+
+    shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    shaderStages[0].module = key.vertexShader;
+    shaderStages[0].pName = "main";
+    shaderStages[0].pSpecializationInfo = &specializationInfo;
+
+    shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    shaderStages[1].module = key.fragmentShader;
+    shaderStages[1].pName = "main";
+    shaderStages[1].pSpecializationInfo = &specializationInfo;
+
+    VkVertexInputBindingDescription vertexBinding = {};
+    vertexBinding.binding = 0;
+    vertexBinding.stride = key.vertexStride;
+    vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInputInfo.vertexBindingDescriptionCount = 1;
+    vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+    vertexInputInfo.vertexAttributeDescriptionCount = key.numVertexAttributes;
+    vertexInputInfo.pVertexAttributeDescriptions = key.vertexAttributes;
+
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+    inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    // Set when recording, so the pipeline doesn't depend on the swapchain's extent
+    VkPipelineViewportStateCreateInfo viewportState = {};
+    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount = 1;
+
+    const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+
+    VkPipelineDynamicStateCreateInfo dynamicState = {};
+    dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    dynamicState.dynamicStateCount = 2;
+    dynamicState.pDynamicStates = dynamicStates;
+
+    VkPipelineRasterizationStateCreateInfo rasterizer = {};
+    rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    rasterizer.depthClampEnable = VK_FALSE;
+    rasterizer.rasterizerDiscardEnable = VK_FALSE;
+    rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterizer.lineWidth = 1.0f;
+    rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+    rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
+    rasterizer.depthBiasEnable = VK_FALSE;
+
+    VkPipelineMultisampleStateCreateInfo multisampling = {};
+    multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    multisampling.sampleShadingEnable = VK_FALSE;
+    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+    colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+
+    colorBlendAttachment.blendEnable = VK_TRUE;
+    colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+
+    colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+
+    colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+
+    VkPipelineColorBlendStateCreateInfo colorBlending = {};
+    colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    colorBlending.logicOpEnable = VK_FALSE;
+    colorBlending.logicOp = VK_LOGIC_OP_COPY;
+    colorBlending.attachmentCount = 1;
+    colorBlending.pAttachments = &colorBlendAttachment;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    pipelineInfo.stageCount = 2;
+    pipelineInfo.pStages = shaderStages;
+    pipelineInfo.pVertexInputState = &vertexInputInfo;
+    pipelineInfo.pInputAssemblyState = &inputAssembly;
+    pipelineInfo.pViewportState = &viewportState;
+    pipelineInfo.pRasterizationState = &rasterizer;
+    pipelineInfo.pMultisampleState = &multisampling;
+    pipelineInfo.pColorBlendState = &colorBlending;
+    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.layout = key.layout;
+    pipelineInfo.renderPass = renderPass;
+    pipelineInfo.subpass = 0;
+    pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+    VkPipeline pipeline;
+
+    if (vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create graphics pipeline!");
+    }
+
+    return pipeline;
+}
+
+VkPipeline findOrCreatePipeline(VkDevice device, PipelineVariants& variants, const PipelineVariantKey& key, VkRenderPass renderPass)
+{
+    const auto found = variants.pipelines.find(key);
+
+    if(found != variants.pipelines.end())
+    {
+        variants.numHits++;
+        return found->second;
+    }
+
+    VkPipeline pipeline = createPipeline(device, key, renderPass);
+
+    variants.pipelines.emplace(key, pipeline);
+    variants.numBuilds++;
+
+    return pipeline;
+}
+
+void destroyPipelineVariants(VkDevice device, PipelineVariants& variants)
+{
+    for(auto& entry : variants.pipelines) {
+        vkDestroyPipeline(device, entry.second, nullptr);
+    }
+
+    for(auto& entry : variants.shaderModules) {
+        vkDestroyShaderModule(device, entry.second, nullptr);
+    }
+
+    variants.pipelines.clear();
+    variants.shaderModules.clear();
+    variants.interfaces.clear();
+}
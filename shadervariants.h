@@ -0,0 +1,99 @@
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+// Every pipeline draws with the same UI shaders (bin/shaders/ui.vert and ui.frag), specialised for the features it
+// needs through specialization constants rather than a hand written shader pair per combination of features. Shader
+// modules are loaded from disk once, and pipelines are cached by everything they're built from, so asking for a
+// variant that's already been built (E.g. when the swapchain is recreated) doesn't build it again
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Feature N is specialization constant N in the shaders
+enum ShaderFeature : uint32_t
+{
+    SHADER_FEATURE_TEXTURED = 1 << 0    // Samples the texture table, otherwise draws the vertex colour
+};
+
+static const constexpr uint32_t NUM_SHADER_FEATURES = 1;
+static const constexpr uint32_t MAX_VARIANT_VERTEX_ATTRIBUTES = 8;
+
+// Everything a pipeline is built from, besides the state that every UI pipeline shares. Hashed and compared bytewise,
+// so only make it through makePipelineVariantKey, which zeroes the attributes that aren't used
+struct PipelineVariantKey
+{
+    VkShaderModule vertexShader;
+    VkShaderModule fragmentShader;
+    VkPipelineLayout layout;
+    uint32_t features;          // ShaderFeature bits
+    VkFormat colorFormat;       // Pipelines work with any render pass that has the same attachment format
+    uint32_t vertexStride;
+    uint32_t numVertexAttributes;
+    VkVertexInputAttributeDescription vertexAttributes[MAX_VARIANT_VERTEX_ATTRIBUTES];
+
+    inline bool operator==(const PipelineVariantKey& other) const {
+        return memcmp(this, &other, sizeof(PipelineVariantKey)) == 0;
+    }
+};
+
+static_assert(sizeof(PipelineVariantKey) == 3 * sizeof(VkPipelineLayout) + 4 * sizeof(uint32_t) + MAX_VARIANT_VERTEX_ATTRIBUTES * sizeof(VkVertexInputAttributeDescription),
+              "PipelineVariantKey can't have padding, it's compared bytewise");
+
+struct PipelineVariantKeyHash
+{
+    size_t operator()(const PipelineVariantKey& key) const;
+};
+
+// What a module expects from the pipeline it's used in, read from its SPIR-V when it's loaded. Compared against the
+// pipeline's vertex and descriptor layouts, so SPIR-V that's out of date with them fails pipeline creation rather than
+// reading garbage
+struct ShaderInterface
+{
+    static const constexpr uint32_t MAX_DESCRIPTOR_SETS = 4;
+
+    uint32_t inputLocations = 0;                    // Bit N is set when an input variable is at location N
+    uint32_t bindings[MAX_DESCRIPTOR_SETS] = {};    // Bit N of bindings[S] is set when a resource is at set S, binding N
+
+    // Declares RuntimeDescriptorArray or ShaderNonUniform, which only a bindless texture table provides
+    bool needsDescriptorIndexing = false;
+};
+
+// Throws if code isn't SPIR-V
+ShaderInterface reflectShaderInterface(const std::vector<char>& code);
+
+struct PipelineVariants
+{
+    std::unordered_map<std::string, VkShaderModule> shaderModules;
+    std::unordered_map<VkShaderModule, ShaderInterface> interfaces;
+    std::unordered_map<PipelineVariantKey, VkPipeline, PipelineVariantKeyHash> pipelines;
+
+    uint32_t numBuilds = 0;     // Pipelines created, one per distinct key
+    uint32_t numHits = 0;       // Requests for a pipeline that had already been built
+};
+
+// Loads the SPIR-V at path the first time it's asked for, and reflects its interface into variants.interfaces. The
+// module is owned by variants
+VkShaderModule loadShaderModule(VkDevice device, PipelineVariants& variants, const std::string& path);
+
+PipelineVariantKey makePipelineVariantKey(  VkShaderModule vertexShader,
+                                            VkShaderModule fragmentShader,
+                                            uint32_t features,
+                                            VkPipelineLayout layout,
+                                            VkFormat colorFormat,
+                                            uint32_t vertexStride,
+                                            const VkVertexInputAttributeDescription * vertexAttributes,
+                                            uint32_t numVertexAttributes );
+
+// Builds the pipeline for key against renderPass the first time it's asked for, after that the same pipeline is returned
+// for any compatible render pass. Viewport and scissor are dynamic state. The pipeline is owned by variants
+VkPipeline findOrCreatePipeline(VkDevice device, PipelineVariants& variants, const PipelineVariantKey& key, VkRenderPass renderPass);
+
+void destroyPipelineVariants(VkDevice device, PipelineVariants& variants);
+
+#endif // SHADERVARIANTS_H
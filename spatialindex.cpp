@@ -0,0 +1,145 @@
+#include "spatialindex.h"
+
+#include <cassert>
+#include <algorithm>
+
+uint16_t MouseBoundsGrid::add(const FixedRect& rect)
+{
+    assert(rects.size() < UINT16_MAX && "Mouse bounds limit reached");
+
+    if(cells[0].empty())
+    {
+        for(uint8_t level = 0; level < NUM_LEVELS; level++) {
+            cells[level].resize(static_cast<size_t>(cellsPerAxis(level)) * cellsPerAxis(level));
+        }
+    }
+
+    const uint16_t boundsIndex = static_cast<uint16_t>(rects.size());
+    const CellRange range = cellRangeOf(rect);
+
+    rects.push_back(rect);
+    ranges.push_back(range);
+    link(boundsIndex, range);
+
+    return boundsIndex;
+}
+
+void MouseBoundsGrid::update(uint16_t boundsIndex, const FixedRect& rect)
+{
+    assert(boundsIndex < rects.size());
+
+    rects[boundsIndex] = rect;
+
+    // Small moves usually stay within the same cells, in which case only the rect changes
+    const CellRange range = cellRangeOf(rect);
+
+    if(range == ranges[boundsIndex]) {
+        return;
+    }
+
+    unlink(boundsIndex, ranges[boundsIndex]);
+    link(boundsIndex, range);
+    ranges[boundsIndex] = range;
+}
+
+void MouseBoundsGrid::clear()
+{
+    rects.clear();
+    ranges.clear();
+
+    for(std::vector<std::vector<uint16_t>>& levelCells : cells)
+    {
+        for(std::vector<uint16_t>& cell : levelCells) {
+            cell.clear();
+        }
+    }
+}
+
+uint16_t MouseBoundsGrid::query(int32_t x, int32_t y, uint16_t * hits, uint16_t maxHits) const
+{
+    if(rects.empty()) {
+        return 0;
+    }
+
+    uint16_t numHits = 0;
+
+    // Each bounds is only in one level, so nothing is hit twice
+    for(uint8_t level = 0; level < NUM_LEVELS; level++)
+    {
+        const std::vector<uint16_t>& cell = cells[level][cellOf(y, level) * cellsPerAxis(level) + cellOf(x, level)];
+
+        for(uint16_t boundsIndex : cell)
+        {
+            if(numHits < maxHits && rects[boundsIndex].contains(x, y)) {
+                hits[numHits++] = boundsIndex;
+            }
+        }
+    }
+
+    // Lists are unordered after updates; keep the order the bounds were added in, as a linear scan would
+    std::sort(hits, hits + numHits);
+
+    return numHits;
+}
+
+uint8_t MouseBoundsGrid::cellOf(int32_t coord, uint8_t level)
+{
+    const int32_t numCells = cellsPerAxis(level);
+    const int32_t clamped = std::min(std::max(coord, MIN_COORD), MAX_COORD);
+    const int32_t cell = ((clamped - MIN_COORD) * numCells) / (MAX_COORD - MIN_COORD);
+
+    // MAX_COORD itself falls in the last cell
+    return static_cast<uint8_t>(std::min(cell, numCells - 1));
+}
+
+MouseBoundsGrid::CellRange MouseBoundsGrid::cellRangeOf(const FixedRect& rect)
+{
+    for(uint8_t level = 0;; level++)
+    {
+        const CellRange range = { level, cellOf(rect.left, level), cellOf(rect.top, level), cellOf(rect.right, level), cellOf(rect.bottom, level) };
+        const uint32_t numCells = (range.maxX - range.minX + 1u) * (range.maxY - range.minY + 1u);
+
+        // The coarsest level always fits (See NUM_LEVELS)
+        if(numCells <= MAX_CELLS_PER_BOUNDS || level == NUM_LEVELS - 1) {
+            return range;
+        }
+    }
+}
+
+void MouseBoundsGrid::link(uint16_t boundsIndex, const CellRange& range)
+{
+    const uint8_t numCells = cellsPerAxis(range.level);
+
+    for(uint8_t y = range.minY; y <= range.maxY; y++)
+    {
+        for(uint8_t x = range.minX; x <= range.maxX; x++) {
+            cells[range.level][y * numCells + x].push_back(boundsIndex);
+        }
+    }
+}
+
+void MouseBoundsGrid::unlink(uint16_t boundsIndex, const CellRange& range)
+{
+    auto swapRemove = [boundsIndex](std::vector<uint16_t>& list)
+    {
+        for(size_t i = 0; i < list.size(); i++)
+        {
+            if(list[i] == boundsIndex) {
+                list[i] = list.back();
+                list.pop_back();
+                return;
+            }
+        }
+
+        assert(false && "Bounds missing from grid");
+    };
+
+    const uint8_t numCells = cellsPerAxis(range.level);
+
+    for(uint8_t y = range.minY; y <= range.maxY; y++)
+    {
+        for(uint8_t x = range.minX; x <= range.maxX; x++) {
+            swapRemove(cells[range.level][y * numCells + x]);
+        }
+    }
+}
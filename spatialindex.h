@@ -0,0 +1,74 @@
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "fixedpoint.h"
+
+// Hierarchy of uniform grids over normalized device space used to find the mouse bounds under the cursor.
+// Each level has a quarter of the cells per axis of the one below it. Bounds go in the finest level where they cover
+// at most MAX_CELLS_PER_BOUNDS cells, and are listed in every cell they overlap there. A query tests the bounds in the
+// cursor's cell on each level, so small bounds stay in small cells and large ones (E.g. buttons) don't go in a list
+// that every query scans. The coarsest level is small enough for any bounds. Anything outside of [-1, 1] is clamped
+// into the edge cells
+struct MouseBoundsGrid
+{
+    static const constexpr int32_t MIN_COORD = NORMFLOAT_MIN;
+    static const constexpr int32_t MAX_COORD = NORMFLOAT_MAX;
+    static const constexpr uint8_t CELLS_PER_AXIS = 64;         // Of the finest level
+    static const constexpr uint8_t NUM_LEVELS = 3;              // 64, 16 and 4 cells per axis
+    static const constexpr uint8_t LEVEL_SHIFT = 2;             // Each level has CELLS_PER_AXIS >> (level * LEVEL_SHIFT)
+    static const constexpr uint16_t MAX_CELLS_PER_BOUNDS = 16;
+
+    static_assert((CELLS_PER_AXIS >> ((NUM_LEVELS - 1) * LEVEL_SHIFT)) * (CELLS_PER_AXIS >> ((NUM_LEVELS - 1) * LEVEL_SHIFT)) <= MAX_CELLS_PER_BOUNDS,
+                  "Any bounds has to fit in the coarsest level");
+
+    // Index of the bounds, as used in OnMouseEventOpBindings::bounds
+    uint16_t add(const FixedRect& rect);
+    void update(uint16_t boundsIndex, const FixedRect& rect);
+    void clear();
+
+    // Writes the indices of up to maxHits bounds that contain the point, in ascending order. Returns the number written
+    uint16_t query(int32_t x, int32_t y, uint16_t * hits, uint16_t maxHits) const;
+
+    inline const FixedRect& rectOf(uint16_t boundsIndex) const {
+        return rects[boundsIndex];
+    }
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(rects.size());
+    }
+
+private:
+
+    // Inclusive range of cells covered in level
+    struct CellRange
+    {
+        uint8_t level;
+        uint8_t minX;
+        uint8_t minY;
+        uint8_t maxX;
+        uint8_t maxY;
+
+        inline bool operator==(const CellRange& other) const {
+            return level == other.level && minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+        }
+    };
+
+    static inline uint8_t cellsPerAxis(uint8_t level) {
+        return static_cast<uint8_t>(CELLS_PER_AXIS >> (level * LEVEL_SHIFT));
+    }
+
+    static uint8_t cellOf(int32_t coord, uint8_t level);
+    static CellRange cellRangeOf(const FixedRect& rect);
+
+    void link(uint16_t boundsIndex, const CellRange& range);
+    void unlink(uint16_t boundsIndex, const CellRange& range);
+
+    std::vector<FixedRect> rects;
+    std::vector<CellRange> ranges;
+    std::vector<std::vector<uint16_t>> cells[NUM_LEVELS];
+};
+
+#endif // SPATIALINDEX_H
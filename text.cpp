@@ -263,14 +263,7 @@ void updateAddVertexPositions(  glm::vec2 * vertices,
                                 float addToX,
                                 float addToY )
 {
-    while(numberVertices-- != 0)
-    {
-        vertices->y += addToY;
-        vertices->x += addToX;
-
-        // Move forward by stride
-        vertices = reinterpret_cast<glm::vec2 *>( reinterpret_cast<uint8_t *>(vertices) + verticesStrideBytes );
-    }
+    translateVertices(reinterpret_cast<float *>(vertices), numberVertices, verticesStrideBytes, addToX, addToY);
 }
 
 void updateMultVertexPositions( glm::vec2 * vertices,
@@ -279,15 +272,7 @@ void updateMultVertexPositions( glm::vec2 * vertices,
                                 float multByX,
                                 float multByY )
 {
-    while(numberVertices-- != 0)
-    {
-        vertices->x /= multByX;
-        vertices->y /= multByY;
-//        numberVertices--;
-
-        // Move forward by stride
-        vertices = reinterpret_cast<glm::vec2 *>( reinterpret_cast<uint8_t *>(vertices) + verticesStrideBytes );
-    }
+    scaleVertices(reinterpret_cast<float *>(vertices), numberVertices, verticesStrideBytes, multByX, multByY);
 }
 
 /*
@@ -14,6 +14,7 @@
 
 #include "typesvulkan.h"
 #include "config.h"
+#include "vertexkernels.h"
 
 struct GenerateTextMeshesParams
 {
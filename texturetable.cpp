@@ -0,0 +1,183 @@
+#include "texturetable.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+bool supportsDescriptorIndexing(VkInstance instance, VkPhysicalDevice physicalDevice)
+{
+    uint32_t extensionCount;
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+
+    bool hasDescriptorIndexing = false;
+    bool hasMaintenance3 = false;
+
+    for(const VkExtensionProperties& extension : availableExtensions)
+    {
+        hasDescriptorIndexing |= (strcmp(extension.extensionName, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) == 0);
+        hasMaintenance3 |= (strcmp(extension.extensionName, VK_KHR_MAINTENANCE3_EXTENSION_NAME) == 0);
+    }
+
+    if(! hasDescriptorIndexing || ! hasMaintenance3) {
+        return false;
+    }
+
+    auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+
+    if(getFeatures2 == nullptr) {
+        return false;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeaturesEXT indexingFeatures = {};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+
+    VkPhysicalDeviceFeatures2KHR features = {};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+    features.pNext = &indexingFeatures;
+
+    getFeatures2(physicalDevice, &features);
+
+    return indexingFeatures.shaderSampledImageArrayNonUniformIndexing
+        && indexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+        && indexingFeatures.descriptorBindingPartiallyBound
+        && indexingFeatures.runtimeDescriptorArray;
+}
+
+void createTextureTable(VkDevice device, bool bindless, uint32_t capacity, TextureTable& outTable)
+{
+    assert(capacity > 0);
+
+    // The update after bind limits are at least 500000 wherever descriptor indexing is supported, so there's no need
+    // to query them for a capacity in the thousands
+    outTable.isBindless = bindless;
+    outTable.capacity = (bindless) ? capacity : 1;
+
+    VkDescriptorSetLayoutBinding binding = {};
+    binding.binding = TextureTable::BINDING;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = outTable.capacity;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = nullptr;
+
+    const VkDescriptorBindingFlagsEXT bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT;
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo = {};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+    bindingFlagsInfo.bindingCount = 1;
+    bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.pNext = (bindless) ? &bindingFlagsInfo : nullptr;
+    layoutInfo.flags = (bindless) ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
+    layoutInfo.bindingCount = 1;
+    layoutInfo.pBindings = &binding;
+
+    if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &outTable.descriptorSetLayout) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture table descriptor set layout!");
+    }
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = outTable.capacity;
+
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = (bindless) ? VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT : 0;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    poolInfo.maxSets = 1;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &outTable.descriptorPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create texture table descriptor pool!");
+    }
+
+    VkDescriptorSetAllocateInfo allocInfo = {};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = outTable.descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &outTable.descriptorSetLayout;
+
+    if (vkAllocateDescriptorSets(device, &allocInfo, &outTable.descriptorSet) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate texture table descriptor set!");
+    }
+
+    outTable.imageViews.clear();
+    outTable.samplers.clear();
+    outTable.freeSlots.clear();
+
+    outTable.imageViews.reserve(outTable.capacity);
+    outTable.samplers.reserve(outTable.capacity);
+}
+
+void destroyTextureTable(VkDevice device, TextureTable& table)
+{
+    if(table.descriptorPool != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device, table.descriptorPool, nullptr);
+    }
+
+    if(table.descriptorSetLayout != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device, table.descriptorSetLayout, nullptr);
+    }
+
+    table = TextureTable();
+}
+
+uint32_t registerTexture(VkDevice device, TextureTable& table, VkImageView imageView, VkSampler sampler)
+{
+    assert(imageView != VK_NULL_HANDLE && sampler != VK_NULL_HANDLE);
+
+    uint32_t texture;
+
+    if(! table.freeSlots.empty())
+    {
+        texture = table.freeSlots.back();
+        table.freeSlots.pop_back();
+
+        table.imageViews[texture] = imageView;
+        table.samplers[texture] = sampler;
+    } else
+    {
+        if(table.imageViews.size() == table.capacity) {
+            return TextureTable::INVALID_TEXTURE;
+        }
+
+        texture = static_cast<uint32_t>(table.imageViews.size());
+
+        table.imageViews.push_back(imageView);
+        table.samplers.push_back(sampler);
+    }
+
+    VkDescriptorImageInfo imageInfo = {};
+    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageView = imageView;
+    imageInfo.sampler = sampler;
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = table.descriptorSet;
+    write.dstBinding = 0;
+    write.dstArrayElement = texture;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &imageInfo;
+
+    vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+    return texture;
+}
+
+void releaseTexture(TextureTable& table, uint32_t texture)
+{
+    assert(texture < table.imageViews.size() && table.imageViews[texture] != VK_NULL_HANDLE);
+    assert(std::find(table.freeSlots.begin(), table.freeSlots.end(), texture) == table.freeSlots.end());
+
+    // Partially bound, so a stale descriptor in an unused slot is fine
+    table.imageViews[texture] = VK_NULL_HANDLE;
+    table.samplers[texture] = VK_NULL_HANDLE;
+    table.freeSlots.push_back(texture);
+}
@@ -0,0 +1,59 @@
+#ifndef TEXTURETABLE_H
+#define TEXTURETABLE_H
+
+// Textures are drawn through one descriptor set that's created at startup and kept until shutdown, so it isn't touched
+// when the swapchain is recreated. Vertices of the texture pipeline pick their texture by index (Vertex::textureIndex).
+//
+// With VK_EXT_descriptor_indexing the set is one large, partially bound array of combined image samplers that's
+// indexed per vertex, and textures can be added while it's bound. Without it the array has a single slot, every index
+// reads that slot and anything drawn by the texture pipeline has to live in one atlas
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+#include <vector>
+
+struct TextureTable
+{
+    static const constexpr uint32_t INVALID_TEXTURE = UINT32_MAX;
+
+    // Set number the table is bound to in pipelines that sample it. Set 0 is the per swapchain image set
+    static const constexpr uint32_t DESCRIPTOR_SET = 1;
+
+    // The table's only binding, an array of combined image samplers
+    static const constexpr uint32_t BINDING = 0;
+
+    bool isBindless = false;
+    uint32_t capacity = 0;
+
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+    VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+
+    // Not owned, whoever registers a texture destroys it after releasing it
+    std::vector<VkImageView> imageViews;
+    std::vector<VkSampler> samplers;
+    std::vector<uint32_t> freeSlots;
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(imageViews.size() - freeSlots.size());
+    }
+};
+
+// Whether the device has VK_EXT_descriptor_indexing with the features the bindless path needs. Requires
+// VK_KHR_get_physical_device_properties2 on the instance, and is false without it
+bool supportsDescriptorIndexing(VkInstance instance, VkPhysicalDevice physicalDevice);
+
+// Capacity is clamped to 1 when not bindless
+void createTextureTable(VkDevice device, bool bindless, uint32_t capacity, TextureTable& outTable);
+void destroyTextureTable(VkDevice device, TextureTable& table);
+
+// Returns the index vertices use to sample the texture, or INVALID_TEXTURE if the table is full. The slot is written
+// straight away, which a bindless table allows while its set is in use by a pending command buffer
+uint32_t registerTexture(VkDevice device, TextureTable& table, VkImageView imageView, VkSampler sampler);
+
+// The slot may be handed out again, so nothing should still be drawing with it
+void releaseTexture(TextureTable& table, uint32_t texture);
+
+#endif // TEXTURETABLE_H
@@ -0,0 +1,105 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace trace {
+
+    static std::mutex registryMutex;
+    static std::vector<std::unique_ptr<ThreadTraceBuffer>> registeredBuffers;
+
+    // Buffers are owned by the registry rather than the thread so events survive the thread exiting
+    static ThreadTraceBuffer * registerThreadBuffer()
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        registeredBuffers.emplace_back(new ThreadTraceBuffer());
+        ThreadTraceBuffer * buffer = registeredBuffers.back().get();
+        buffer->threadId = static_cast<uint32_t>(registeredBuffers.size());
+
+        return buffer;
+    }
+
+    ThreadTraceBuffer& threadBuffer()
+    {
+        static thread_local ThreadTraceBuffer * buffer = registerThreadBuffer();
+        return *buffer;
+    }
+
+    bool writeChromeTrace(const char * path)
+    {
+        FILE * file = fopen(path, "w");
+
+        if(file == nullptr) {
+            printf("Failed to open '%s' for writing trace\n", path);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+
+        struct ThreadEvents
+        {
+            uint32_t threadId;
+            std::vector<TraceEvent> events;
+        };
+
+        // Each ring is copied up to the write index loaded here, so events recorded while the trace is written are
+        // left out rather than read half written
+        std::vector<ThreadEvents> snapshots;
+        snapshots.reserve(registeredBuffers.size());
+
+        // Scopes are recorded when they end, so an enclosing scope comes after the ones inside it but starts earlier.
+        // The earliest start has to be looked for in every event, not only the first of each ring
+        uint64_t baseNs = UINT64_MAX;
+
+        for(const std::unique_ptr<ThreadTraceBuffer>& buffer : registeredBuffers)
+        {
+            const uint32_t numWritten = buffer->numWritten.load(std::memory_order_acquire);
+            const uint32_t firstIndex = (numWritten > ThreadTraceBuffer::CAPACITY) ? numWritten - ThreadTraceBuffer::CAPACITY : 0;
+
+            ThreadEvents snapshot = { buffer->threadId, {} };
+            snapshot.events.reserve(numWritten - firstIndex);
+
+            for(uint32_t i = firstIndex; i < numWritten; i++)
+            {
+                const TraceEvent& event = buffer->events[i & (ThreadTraceBuffer::CAPACITY - 1)];
+                baseNs = std::min(baseNs, event.startNs);
+                snapshot.events.push_back(event);
+            }
+
+            snapshots.push_back(std::move(snapshot));
+        }
+
+        fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", file);
+
+        bool firstEvent = true;
+        uint32_t numEventsWritten = 0;
+
+        for(const ThreadEvents& snapshot : snapshots)
+        {
+            for(const TraceEvent& event : snapshot.events)
+            {
+                fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                        (firstEvent) ? "" : ",\n",
+                        event.name,
+                        snapshot.threadId,
+                        (event.startNs - baseNs) / 1000.0,
+                        event.durationNs / 1000.0);
+
+                firstEvent = false;
+                numEventsWritten++;
+            }
+        }
+
+        fputs("\n]}\n", file);
+        fclose(file);
+
+        printf("Wrote %u trace events to '%s'\n", numEventsWritten, path);
+
+        return true;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Scoped trace events written out as Chrome Trace Event JSON (Open in Perfetto or chrome://tracing)
+// Enabled with the ENABLE_TRACING CMake option, which defines VKGUI_ENABLE_TRACING.
+// When disabled, every TRACE_* macro expands to nothing
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+namespace trace {
+
+    struct TraceEvent
+    {
+        const char * name;
+        uint64_t startNs;
+        uint64_t durationNs;
+    };
+
+    // Each thread records into its own preallocated ring, so recording never locks or allocates.
+    // Once full, the oldest events are overwritten
+    struct ThreadTraceBuffer
+    {
+        static constexpr uint32_t CAPACITY = 1 << 16;
+
+        uint32_t threadId;
+        std::atomic<uint32_t> numWritten { 0 };
+        TraceEvent events[CAPACITY];
+    };
+
+    ThreadTraceBuffer& threadBuffer();
+
+    inline uint64_t nowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    inline void recordEvent(const char * name, uint64_t startNs, uint64_t durationNs)
+    {
+        ThreadTraceBuffer& buffer = threadBuffer();
+        const uint32_t index = buffer.numWritten.load(std::memory_order_relaxed);
+
+        buffer.events[index & (ThreadTraceBuffer::CAPACITY - 1)] = { name, startNs, durationNs };
+        buffer.numWritten.store(index + 1, std::memory_order_release);
+    }
+
+    // `name` must be a string literal (Or otherwise outlive the trace)
+    class ScopedTraceEvent
+    {
+    public:
+        explicit ScopedTraceEvent(const char * name)
+            : name(name), startNs(nowNs()) {}
+
+        ~ScopedTraceEvent() {
+            recordEvent(name, startNs, nowNs() - startNs);
+        }
+
+    private:
+        const char * name;
+        uint64_t startNs;
+    };
+
+    // Writes every registered thread's events. Intended to be called from the main thread. Other threads may keep
+    // recording, anything after the point their ring is copied is left out. A thread that records a full ring's worth
+    // of events during the copy overwrites events being read, so call it while worker threads are idle or stopped
+    bool writeChromeTrace(const char * path);
+}
+
+#ifdef VKGUI_ENABLE_TRACING
+    #define TRACE_CONCAT_IMPL(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+    #define TRACE_SCOPE(name) trace::ScopedTraceEvent TRACE_CONCAT(traceScope_, __LINE__)(name)
+    #define TRACE_FUNCTION() TRACE_SCOPE(__func__)
+    #define TRACE_WRITE(path) trace::writeChromeTrace(path)
+#else
+    #define TRACE_SCOPE(name)
+    #define TRACE_FUNCTION()
+    #define TRACE_WRITE(path)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,239 @@
+#include "transform.h"
+
+#include <cassert>
+
+static void toGpuTransform(const Affine2D& transform, GpuTransform& out)
+{
+    out.linear[0] = transform.a;
+    out.linear[1] = transform.b;
+    out.linear[2] = transform.c;
+    out.linear[3] = transform.d;
+    out.translation[0] = transform.tx;
+    out.translation[1] = transform.ty;
+    out.translation[2] = 0.0f;
+    out.translation[3] = 0.0f;
+}
+
+void TransformHierarchy::reserve(uint32_t maxNodes)
+{
+    assert(maxNodes > 0);
+
+    capacity = maxNodes;
+
+    local.reserve(capacity);
+    world.reserve(capacity);
+    parents.reserve(capacity);
+    firstChildren.reserve(capacity);
+    nextSiblings.reserve(capacity);
+    dirty.reserve(capacity);
+    dirtyNodes.reserve(capacity);
+    walkStack.reserve(capacity);
+
+    local.assign(1, transform::identity());
+    world.assign(1, transform::identity());
+    parents.assign(1, INVALID_NODE);
+    firstChildren.assign(1, INVALID_NODE);
+    nextSiblings.assign(1, INVALID_NODE);
+
+    // Written out on the first flush
+    dirty.assign(1, 1);
+    dirtyNodes.assign(1, ROOT);
+
+    freeNodes.clear();
+}
+
+uint32_t TransformHierarchy::create(uint32_t parent, const Affine2D& localTransform)
+{
+    assert(isValid(parent) && "Invalid parent transform");
+
+    uint32_t node;
+
+    if(! freeNodes.empty())
+    {
+        node = freeNodes.back();
+        freeNodes.pop_back();
+    } else
+    {
+        if(local.size() == capacity) {
+            return INVALID_NODE;
+        }
+
+        node = static_cast<uint32_t>(local.size());
+
+        local.push_back({});
+        world.push_back({});
+        parents.push_back(INVALID_NODE);
+        firstChildren.push_back(INVALID_NODE);
+        nextSiblings.push_back(INVALID_NODE);
+        dirty.push_back(0);
+    }
+
+    local[node] = localTransform;
+    firstChildren[node] = INVALID_NODE;
+
+    link(node, parent);
+    markDirty(node);
+
+    return node;
+}
+
+void TransformHierarchy::release(uint32_t node)
+{
+    assert(node != ROOT && isValid(node));
+
+    const uint32_t parent = parents[node];
+
+    uint32_t child = firstChildren[node];
+
+    while(child != INVALID_NODE)
+    {
+        const uint32_t next = nextSiblings[child];
+
+        link(child, parent);
+        markDirty(child);
+
+        child = next;
+    }
+
+    unlink(node);
+
+    firstChildren[node] = INVALID_NODE;
+    parents[node] = INVALID_NODE;
+
+    // Left in dirtyNodes if it's there, flush skips released nodes
+    dirty[node] = 0;
+
+    freeNodes.push_back(node);
+}
+
+void TransformHierarchy::setLocal(uint32_t node, const Affine2D& localTransform)
+{
+    assert(node != ROOT && isValid(node));
+
+    local[node] = localTransform;
+    markDirty(node);
+}
+
+void TransformHierarchy::translate(uint32_t node, float x, float y)
+{
+    assert(node != ROOT && isValid(node));
+
+    local[node].tx += x;
+    local[node].ty += y;
+    markDirty(node);
+}
+
+void TransformHierarchy::remap(const Affine2D& change, const Affine2D& inverse)
+{
+    for(uint32_t node = 1; node < local.size(); node++)
+    {
+        if(isValid(node)) {
+            local[node] = transform::combine(transform::combine(inverse, local[node]), change);
+            markDirty(node);
+        }
+    }
+}
+
+Affine2D TransformHierarchy::worldOf(uint32_t node) const
+{
+    assert(isValid(node));
+
+    Affine2D result = local[node];
+
+    for(uint32_t parent = parents[node]; parent != INVALID_NODE; parent = parents[parent]) {
+        result = transform::combine(result, local[parent]);
+    }
+
+    return result;
+}
+
+uint32_t TransformHierarchy::flush(GpuTransform * out)
+{
+    uint32_t numWritten = 0;
+
+    for(uint32_t root : dirtyNodes)
+    {
+        // Released, already written as part of another subtree or will be as part of an ancestor's
+        if(! dirty[root] || hasDirtyAncestor(root)) {
+            continue;
+        }
+
+        walkStack.clear();
+        walkStack.push_back(root);
+
+        while(! walkStack.empty())
+        {
+            const uint32_t node = walkStack.back();
+            walkStack.pop_back();
+
+            const uint32_t parent = parents[node];
+
+            world[node] = (parent == INVALID_NODE) ? local[node] : transform::combine(local[node], world[parent]);
+            dirty[node] = 0;
+
+            toGpuTransform(world[node], out[node]);
+            numWritten++;
+
+            for(uint32_t child = firstChildren[node]; child != INVALID_NODE; child = nextSiblings[child]) {
+                walkStack.push_back(child);
+            }
+        }
+    }
+
+    dirtyNodes.clear();
+
+    return numWritten;
+}
+
+void TransformHierarchy::markDirty(uint32_t node)
+{
+    if(! dirty[node]) {
+        dirty[node] = 1;
+        dirtyNodes.push_back(node);
+    }
+}
+
+void TransformHierarchy::unlink(uint32_t node)
+{
+    const uint32_t parent = parents[node];
+
+    if(parent == INVALID_NODE) {
+        return;
+    }
+
+    if(firstChildren[parent] == node) {
+        firstChildren[parent] = nextSiblings[node];
+    } else
+    {
+        uint32_t sibling = firstChildren[parent];
+
+        while(nextSiblings[sibling] != node) {
+            sibling = nextSiblings[sibling];
+        }
+
+        nextSiblings[sibling] = nextSiblings[node];
+    }
+
+    nextSiblings[node] = INVALID_NODE;
+}
+
+void TransformHierarchy::link(uint32_t node, uint32_t parent)
+{
+    unlink(node);
+
+    parents[node] = parent;
+    nextSiblings[node] = firstChildren[parent];
+    firstChildren[parent] = node;
+}
+
+bool TransformHierarchy::hasDirtyAncestor(uint32_t node) const
+{
+    for(uint32_t parent = parents[node]; parent != INVALID_NODE; parent = parents[parent])
+    {
+        if(dirty[parent]) {
+            return true;
+        }
+    }
+
+    return false;
+}
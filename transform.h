@@ -0,0 +1,100 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "vertexkernels.h"
+
+// A transform as laid out in the storage buffer read by the vertex shaders (std430, 32 bytes)
+struct GpuTransform
+{
+    float linear[4];        // a b c d
+    float translation[4];   // tx ty, padded to a vec4
+};
+
+namespace transform
+{
+    inline Affine2D identity() {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f };
+    }
+
+    inline Affine2D translation(float x, float y) {
+        return { 1.0f, 0.0f, 0.0f, 1.0f, x, y };
+    }
+
+    inline Affine2D scale(float x, float y) {
+        return { x, 0.0f, 0.0f, y, 0.0f, 0.0f };
+    }
+
+    // Applies `second` after `first`
+    inline Affine2D combine(const Affine2D& first, const Affine2D& second)
+    {
+        return {    second.a * first.a + second.c * first.b,
+                    second.b * first.a + second.d * first.b,
+                    second.a * first.c + second.c * first.d,
+                    second.b * first.c + second.d * first.d,
+                    second.a * first.tx + second.c * first.ty + second.tx,
+                    second.b * first.tx + second.d * first.ty + second.ty };
+    }
+}
+
+// Tree of 2D affine transforms. Each node stores a transform relative to its parent, and world transforms are only
+// recomputed (And written out) for the subtrees whose local transform changed since the last flush, so moving a node
+// costs one write no matter how many vertices reference it or its children.
+// Node ROOT is the identity and can't be changed or released
+struct TransformHierarchy
+{
+    static const constexpr uint32_t ROOT = 0;
+    static const constexpr uint32_t INVALID_NODE = UINT32_MAX;
+
+    std::vector<Affine2D> local;
+    std::vector<Affine2D> world;
+    std::vector<uint32_t> parents;
+    std::vector<uint32_t> firstChildren;
+    std::vector<uint32_t> nextSiblings;
+    std::vector<uint8_t> dirty;         // Local transform changed since the last flush
+    std::vector<uint32_t> dirtyNodes;
+    std::vector<uint32_t> freeNodes;
+    std::vector<uint32_t> walkStack;    // Scratch space for flush
+
+    uint32_t capacity = 0;
+
+    void reserve(uint32_t maxNodes);
+
+    // Returns INVALID_NODE if capacity nodes are in use
+    uint32_t create(uint32_t parent, const Affine2D& localTransform);
+
+    // Children are moved up to the released node's parent, keeping their local transforms
+    void release(uint32_t node);
+
+    void setLocal(uint32_t node, const Affine2D& localTransform);
+    void translate(uint32_t node, float x, float y);
+
+    // Applies `change` to every node's space, I.e. local = change * local * inverse. Used when every vertex position
+    // is remapped the same way (On a window resize)
+    void remap(const Affine2D& change, const Affine2D& inverse);
+
+    // Doesn't require a flush
+    Affine2D worldOf(uint32_t node) const;
+
+    // Recomputes stale world transforms and writes them to `out`, indexed by node. Returns the number written
+    uint32_t flush(GpuTransform * out);
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(local.size() - freeNodes.size());
+    }
+
+    inline bool isValid(uint32_t node) const {
+        return node < parents.size() && (node == ROOT || parents[node] != INVALID_NODE);
+    }
+
+private:
+
+    void markDirty(uint32_t node);
+    void unlink(uint32_t node);
+    void link(uint32_t node, uint32_t parent);
+    bool hasDirtyAncestor(uint32_t node) const;
+};
+
+#endif // TRANSFORM_H
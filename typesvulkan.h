@@ -9,20 +9,28 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <cassert>
+#include <cstring>
 #include <string>
 #include <array>
 #include <ctype.h>
 #include <unordered_map>
 #include <tuple>
 
+#include "fixedpoint.h"
 #include "entity.h"
+#include "spatialindex.h"
+#include "input.h"
+#include "layout.h"
+#include "fixedvector.h"
+#include "arena.h"
+#include "texturetable.h"
+#include "imageassets.h"
+#include "shadervariants.h"
 
 /*  What major things are missing?
  *
  *  Framebuffer resizing
- *  layouts
- *      specifying % and absolute values
- *      Even layout types like grid layout
  *  draw order
  *  pages (You need to be able to generate page data from a function)
  *  memory allocator - memory is a complete mess atm
@@ -76,20 +84,26 @@ struct FontBitmap
     static bool instanciate_char_bitmap(FontBitmap& font_bitmap, FT_Face& face, const char c);
 };
 
+// 4 points of precision
+// range [0, 1]
 struct NormFloat16
 {
     uint16_t data;
 
     inline void set(double value) {
-        data = static_cast<uint16_t>(value * 10000.0);
+        data = fixed16::fromDoubleUnsigned(value);
     }
 
     inline double get() const {
-        return data / 10000.0;
+        return fixed16::toDouble(data);
+    }
+
+    inline float toFloat() const {
+        return fixed16::toFloat(data);
     }
 
     inline void addTo(NormFloat16 val) {
-        data += val.data;
+        data = fixed16::add(data, val.data);
     }
 };
 
@@ -100,35 +114,37 @@ struct SNormFloat16
     int16_t data;
 
     inline void set(double value) {
-        data = static_cast<int16_t>(value * 10000.0);
+        data = fixed16::fromDouble(value);
     }
 
     inline double get() const {
-        return data / 10000.0;
+        return fixed16::toDouble(data);
+    }
+
+    inline float toFloat() const {
+        return fixed16::toFloat(data);
     }
 
     inline void addTo(NormFloat16 val) {
-        data += static_cast<int16_t>(val.data);
+        data = fixed16::add(data, val.data);
     }
 
     inline void addTo(SNormFloat16 val) {
-        data += val.data;
+        data = fixed16::add(data, val.data);
     }
 };
 
-#define NORMFLOAT_MAX   10000
-#define NORMFLOAT_MIN  -10000
-
 namespace normfloat16 {
-    inline double add(SNormFloat16 a, SNormFloat16 b) {
-        return a.get() + b.get();
+    inline SNormFloat16 add(SNormFloat16 a, SNormFloat16 b) {
+        return { fixed16::add(a.data, b.data) };
     }
 
-    inline double add(SNormFloat16 a, NormFloat16 b) {
-        return a.get() + b.get();
+    inline SNormFloat16 add(SNormFloat16 a, NormFloat16 b) {
+        return { fixed16::add(a.data, b.data) };
     }
 }
 
+static_assert(sizeof(NormFloat16) == 2);
 static_assert(sizeof(SNormFloat16) == 2);
 
 struct Point
@@ -236,6 +252,9 @@ struct Area
 #define MOUSE_BOUNDS_FLAGS_3_ON_LCLICK              0b0000010000000000
 #define MOUSE_BOUNDS_FLAGS_0_ON_LCLICK              0b0000110000000000
 
+// onHoverEnterOperation / onHoverExitOperation are operation chain indices instead of operation indices
+#define MOUSE_BOUNDS_FLAGS_CHAINS                   0b0000000000000001
+
 #define MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_ENTER_MASK      0b1100000000000000
 #define MOUSE_BOUNDS_FLAGS_NUM_ON_HOVER_EXIT_MASK       0b0011000000000000
 
@@ -249,40 +268,109 @@ struct Area
 //#define MOUSE_BOUNDS_FLAGS_3_ON_MCLICK              0b00000000 00000001
 //#define MOUSE_BOUNDS_FLAGS_0_ON_MCLICK              0b00000000 00000011
 
+typedef uint16_t OperationIndex;
+
+#define OPERATION_INDEX_INVALID UINT16_MAX
+
+// Unused operation slots are OPERATION_INDEX_INVALID
 struct MouseBounds
 {
     NormalizedRect boundsArea;
     uint16_t flags;
-    uint8_t onHoverEnterOperation;
-    uint8_t onHoverExitOperation;
-    uint8_t onLClickOperation;
-    uint8_t onRClickOperation;
-    uint8_t onMClickOperation;
+    OperationIndex onHoverEnterOperation;
+    OperationIndex onHoverExitOperation;
+    OperationIndex onLClickOperation;
+    OperationIndex onRClickOperation;
+    OperationIndex onMClickOperation;
     uint8_t numSubAreas;   // 0 to just use boundArea
+    uint8_t numSubRects = 0;    // The first numSubRects sub areas are rects and the rest are arcs, like Area::rects
+    uint16_t firstSubArea = 0;  // Index into OnMouseEventOpBindings::complexAreas
 };
 
-// TODO: Implement operation chains
-struct OperationChainBounds
+// Bytecode for all operation chains, executed by runOperationChain (See opchain.h for the instruction set)
+struct OperationChainProgram
 {
-    uint8_t startIndex;
-    uint8_t length; // Can use a bit of this to double startIndex
+    std::vector<uint8_t> code;
+    std::vector<uint16_t> chainOffsets;     // Entry point into `code` for each chain index
 };
 
-// TODO: Implement key - operation bindings
-struct KeyPressOperation
+// Naming is hard.
+inline FixedRect toFixedRect(const NormalizedRect& rect)
 {
-    uint8_t key;
-    uint8_t operationIndex;
-    uint16_t flags;
-};
+    const int32_t left = rect.topLeftPoint.x.data;
+    const int32_t top = rect.topLeftPoint.y.data;
+
+    return { left, top, left + rect.width.data, top + rect.height.data };
+}
 
-// Naming is hard.
 struct OnMouseEventOpBindings
 {
-    uint16_t numBounds;
-    uint16_t numAreas;
-    MouseBounds bounds[10];
-    AreaShape complexAreas[1];
+    uint16_t numBounds = 0;
+    uint16_t numAreas = 0;
+    std::vector<MouseBounds> bounds;
+
+    // Sub areas of compound bounds (See hittest.h). Positions are relative to the top left of the boundsArea they
+    // belong to, so moving a bounds doesn't need to touch them
+    std::vector<AreaShape> complexAreas;
+
+    // Kept in sync with the boundsArea of each bounds. Use addBounds / moveBounds instead of writing to bounds directly
+    MouseBoundsGrid grid;
+
+    uint16_t addBounds(const MouseBounds& mouseBounds)
+    {
+        const uint16_t boundsIndex = grid.add(toFixedRect(mouseBounds.boundsArea));
+        assert(boundsIndex == bounds.size());
+
+        bounds.push_back(mouseBounds);
+        numBounds++;
+
+        return boundsIndex;
+    }
+
+    // The bounds is only hit where one of its sub areas is. boundsArea should enclose all of them
+    uint16_t addBounds(MouseBounds mouseBounds, const std::vector<NormalizedRect>& subRects, const std::vector<NormalizedArc>& subArcs)
+    {
+        assert(subRects.size() + subArcs.size() <= UINT8_MAX);
+        assert(complexAreas.size() <= UINT16_MAX);
+
+        mouseBounds.firstSubArea = static_cast<uint16_t>(complexAreas.size());
+        mouseBounds.numSubRects = static_cast<uint8_t>(subRects.size());
+        mouseBounds.numSubAreas = static_cast<uint8_t>(subRects.size() + subArcs.size());
+
+        for(const NormalizedRect& rect : subRects) {
+            AreaShape shape;
+            shape.r = rect;
+            complexAreas.push_back(shape);
+        }
+
+        for(const NormalizedArc& arc : subArcs) {
+            AreaShape shape;
+            shape.a = arc;
+            complexAreas.push_back(shape);
+        }
+
+        numAreas = static_cast<uint16_t>(complexAreas.size());
+
+        return addBounds(mouseBounds);
+    }
+
+    void moveBounds(uint16_t boundsIndex, SNormFloat16 addX, SNormFloat16 addY)
+    {
+        NormalizedRect& boundsArea = bounds[boundsIndex].boundsArea;
+        boundsArea.topLeftPoint.x.addTo(addX);
+        boundsArea.topLeftPoint.y.addTo(addY);
+
+        grid.update(boundsIndex, toFixedRect(boundsArea));
+    }
+
+    void clearBounds()
+    {
+        bounds.clear();
+        grid.clear();
+        complexAreas.clear();
+        numBounds = 0;
+        numAreas = 0;
+    }
 };
 
 struct ChangeColorOperation
@@ -386,6 +474,7 @@ typedef uint8_t Operation;
 // Different sizes should be able to reuse Operation Codes
 #define OPERATION_CODE_DEACTIVATE_OP            3
 #define OPERATION_CODE_APPLY_MOVE_TO_BOUNDS     4
+#define OPERATION_CODE_ANIMATED_MOVE            5
 
 struct Operation2
 {
@@ -447,6 +536,437 @@ static_assert(sizeof(ActiveMoveDrag) == 14);
 static_assert(sizeof(ActiveSelectionDrag) == 14);
 static_assert(sizeof(ActiveMoveDrag) == 14);
 
+// Stores operations of all sizes in one buffer. Each OperationIndex maps to a byte offset through `offsets`, so lookups
+// are a single indirection and operations can be appended or removed in any order, at any time.
+// Removed blocks go onto a free list for their size class (The next free offset is written into the block itself)
+// and removed indices are recycled.
+struct OperationStore
+{
+    static const constexpr uint16_t MAX_OPERATIONS = 4096;
+    static const constexpr uint16_t STORAGE_BYTES = 65520;
+    static const constexpr uint16_t NULL_OFFSET = UINT16_MAX;
+
+    alignas(8) uint8_t storage[STORAGE_BYTES];
+    uint16_t storageUsed = 0;
+
+    uint16_t offsets[MAX_OPERATIONS];
+    uint16_t numIndices = 0;    // Indices handed out so far, including removed ones
+    uint16_t numOperations = 0;
+
+    uint16_t freeIndices[MAX_OPERATIONS];
+    uint16_t numFreeIndices = 0;
+
+    // Indexed by sizeClass()
+    uint16_t freeBlocks[4] = { NULL_OFFSET, NULL_OFFSET, NULL_OFFSET, NULL_OFFSET };
+
+    static inline uint8_t sizeBytes(uint8_t flags)
+    {
+        switch(flags & OPERATION_FLAGS_SIZE_16)
+        {
+            case OPERATION_FLAGS_SIZE_4: return 4;
+            case OPERATION_FLAGS_SIZE_8: return 8;
+            case OPERATION_FLAGS_SIZE_16: return 16;
+            default: return 2;
+        }
+    }
+
+    static inline uint8_t sizeClass(uint8_t flags)
+    {
+        switch(flags & OPERATION_FLAGS_SIZE_16)
+        {
+            case OPERATION_FLAGS_SIZE_4: return 1;
+            case OPERATION_FLAGS_SIZE_8: return 2;
+            case OPERATION_FLAGS_SIZE_16: return 3;
+            default: return 0;
+        }
+    }
+
+    inline bool isValid(OperationIndex index) const {
+        return index < numIndices && offsets[index] != NULL_OFFSET;
+    }
+
+    inline bool canInsert(uint8_t flags) const
+    {
+        const bool hasIndex = (numFreeIndices > 0 || numIndices < MAX_OPERATIONS);
+        const bool hasBlock = (freeBlocks[sizeClass(flags)] != NULL_OFFSET || storageUsed + sizeBytes(flags) <= STORAGE_BYTES);
+
+        return hasIndex && hasBlock;
+    }
+
+    inline Operation2& at(OperationIndex index)
+    {
+        assert(isValid(index) && "Invalid operation index");
+        return *reinterpret_cast<Operation2*>(storage + offsets[index]);
+    }
+
+    // `flags` must include one of the OPERATION_FLAGS_SIZE_* values. `data` is the operation excluding the opCode and flags
+    OperationIndex insert(uint8_t opCode, uint8_t flags, const void * data)
+    {
+        if(! canInsert(flags)) {
+            assert(false && "Operation store is full");
+            return OPERATION_INDEX_INVALID;
+        }
+
+        const uint8_t size = sizeBytes(flags);
+        uint16_t& freeBlock = freeBlocks[sizeClass(flags)];
+        uint16_t offset;
+
+        if(freeBlock != NULL_OFFSET) {
+            offset = freeBlock;
+            memcpy(&freeBlock, storage + offset, sizeof(uint16_t));
+        } else {
+            offset = storageUsed;
+            storageUsed += size;
+        }
+
+        const OperationIndex index = (numFreeIndices > 0) ? freeIndices[--numFreeIndices] : numIndices++;
+
+        offsets[index] = offset;
+        storage[offset] = opCode;
+        storage[offset + 1] = flags;
+
+        if(size > 2) {
+            memcpy(storage + offset + 2, data, size - 2);
+        }
+
+        numOperations++;
+
+        return index;
+    }
+
+    void remove(OperationIndex index)
+    {
+        assert(isValid(index) && "Invalid operation index");
+
+        const uint16_t offset = offsets[index];
+        uint16_t& freeBlock = freeBlocks[sizeClass(storage[offset + 1])];
+
+        memcpy(storage + offset, &freeBlock, sizeof(uint16_t));
+        freeBlock = offset;
+
+        offsets[index] = NULL_OFFSET;
+        freeIndices[numFreeIndices++] = index;
+        numOperations--;
+    }
+};
+
+enum class PerFrameBatch : uint8_t { RELATIVE_MOVE = 0, BOUNDS_MOVE, OTHER, SIZE };
+
+// Active per-frame operations, grouped by opCode into structure of arrays batches so that each kind of operation
+// runs as one loop instead of going through handleOperation (See doPerFrameOperations).
+// Operation data is copied in when an operation is activated. Removal swaps the last element of a batch into
+// the hole, so order within a batch is not preserved (All batched operations are commutative)
+struct PerFrameOperations
+{
+    static const constexpr uint32_t INVALID_LOCATION = UINT32_MAX;
+
+    struct RelativeMoves
+    {
+        std::vector<OperationIndex> operations;
+        std::vector<Entity16> targets;
+        std::vector<SNormFloat16> addX;
+        std::vector<SNormFloat16> addY;
+    };
+
+    struct BoundsMoves
+    {
+        std::vector<OperationIndex> operations;
+        std::vector<uint16_t> boundsIndices;
+        std::vector<SNormFloat16> addX;
+        std::vector<SNormFloat16> addY;
+    };
+
+    RelativeMoves relativeMoves;
+    BoundsMoves boundsMoves;
+    std::vector<OperationIndex> other;  // Run through handleOperation
+
+    // Indexed by OperationIndex. Batch in the upper 8 bits, position within the batch in the lower 24
+    std::vector<uint32_t> locations;
+
+    uint32_t count = 0;
+    uint32_t capacity = 0;
+
+    void reserve(uint32_t maxOperations)
+    {
+        capacity = maxOperations;
+        locations.assign(OperationStore::MAX_OPERATIONS, INVALID_LOCATION);
+
+        relativeMoves.operations.reserve(capacity);
+        relativeMoves.targets.reserve(capacity);
+        relativeMoves.addX.reserve(capacity);
+        relativeMoves.addY.reserve(capacity);
+
+        boundsMoves.operations.reserve(capacity);
+        boundsMoves.boundsIndices.reserve(capacity);
+        boundsMoves.addX.reserve(capacity);
+        boundsMoves.addY.reserve(capacity);
+
+        other.reserve(capacity);
+    }
+
+    inline bool contains(OperationIndex index) const {
+        return index < locations.size() && locations[index] != INVALID_LOCATION;
+    }
+
+    bool add(OperationIndex index, const Operation2& operation)
+    {
+        assert(index < locations.size() && "PerFrameOperations::reserve must be called first");
+        assert(! contains(index));
+
+        if(count == capacity) {
+            return false;
+        }
+
+        const bool isSize8 = ((operation.flags & OPERATION_FLAGS_SIZE_16) == OPERATION_FLAGS_SIZE_8);
+        const Operation8& operation8 = reinterpret_cast<const Operation8&>(operation);
+
+        if(isSize8 && operation.opCode == OPERATION_CODE_RELATIVE_MOVE)
+        {
+            const RelativeMoveOperation& relativeMove = operation8.opData.relativeMove;
+
+            locations[index] = makeLocation(PerFrameBatch::RELATIVE_MOVE, relativeMoves.operations.size());
+            relativeMoves.operations.push_back(index);
+            relativeMoves.targets.push_back(relativeMove.targetEntity);
+            relativeMoves.addX.push_back(relativeMove.addX);
+            relativeMoves.addY.push_back(relativeMove.addY);
+        } else if(isSize8 && operation.opCode == OPERATION_CODE_APPLY_MOVE_TO_BOUNDS)
+        {
+            const SimpleMouseBoundsMoveOperation& boundsMove = operation8.opData.mouseBoundsMove;
+
+            locations[index] = makeLocation(PerFrameBatch::BOUNDS_MOVE, boundsMoves.operations.size());
+            boundsMoves.operations.push_back(index);
+            boundsMoves.boundsIndices.push_back(boundsMove.boundsIndex);
+            boundsMoves.addX.push_back(boundsMove.addX);
+            boundsMoves.addY.push_back(boundsMove.addY);
+        } else
+        {
+            locations[index] = makeLocation(PerFrameBatch::OTHER, other.size());
+            other.push_back(index);
+        }
+
+        count++;
+
+        return true;
+    }
+
+    void remove(OperationIndex index)
+    {
+        assert(contains(index));
+
+        const uint32_t location = locations[index];
+        const size_t position = location & 0x00FFFFFF;
+
+        switch(static_cast<PerFrameBatch>(location >> 24))
+        {
+            case PerFrameBatch::RELATIVE_MOVE:
+                swapRemoveOperation(relativeMoves.operations, position);
+                swapRemove(relativeMoves.targets, position);
+                swapRemove(relativeMoves.addX, position);
+                swapRemove(relativeMoves.addY, position);
+                break;
+            case PerFrameBatch::BOUNDS_MOVE:
+                swapRemoveOperation(boundsMoves.operations, position);
+                swapRemove(boundsMoves.boundsIndices, position);
+                swapRemove(boundsMoves.addX, position);
+                swapRemove(boundsMoves.addY, position);
+                break;
+            default:
+                swapRemoveOperation(other, position);
+        }
+
+        locations[index] = INVALID_LOCATION;
+        count--;
+    }
+
+private:
+
+    static inline uint32_t makeLocation(PerFrameBatch batch, size_t position) {
+        return (static_cast<uint32_t>(batch) << 24) | static_cast<uint32_t>(position);
+    }
+
+    template<typename T>
+    inline void swapRemove(std::vector<T>& values, size_t position)
+    {
+        values[position] = values.back();
+        values.pop_back();
+    }
+
+    // Also points the location of the operation that gets moved into the hole at its new position
+    inline void swapRemoveOperation(std::vector<OperationIndex>& operations, size_t position)
+    {
+        const OperationIndex moved = operations.back();
+        locations[moved] = (locations[moved] & 0xFF000000) | static_cast<uint32_t>(position);
+
+        operations[position] = moved;
+        operations.pop_back();
+    }
+};
+
+// Running AnimatedMoveOperations, one track per operation, advanced by elapsed time in advanceAnimations (See animation.h).
+// Tracks are packed structure of arrays; a finished or stopped track is swap removed
+struct AnimationTracks
+{
+    static const constexpr uint32_t INVALID_TRACK = UINT32_MAX;
+
+    std::vector<OperationIndex> operations;
+    std::vector<Entity16> targets;
+    std::vector<float> elapsedMs;
+    std::vector<float> durationMs;
+
+    // Total move in normalized device units, and how much of it has already been written to the vertices
+    std::vector<float> differenceX;
+    std::vector<float> differenceY;
+    std::vector<float> appliedX;
+    std::vector<float> appliedY;
+
+    // Scale is around the centre of the target, as it was when the track started
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> targetScale;
+    std::vector<float> appliedScale;
+
+    std::vector<uint8_t> moveFunctions;
+    std::vector<uint8_t> scaleFunctions;
+
+    // Indexed by OperationIndex
+    std::vector<uint32_t> trackOf;
+
+    uint32_t capacity = 0;
+
+    void reserve(uint32_t maxTracks)
+    {
+        capacity = maxTracks;
+        trackOf.assign(OperationStore::MAX_OPERATIONS, INVALID_TRACK);
+
+        operations.reserve(capacity);
+        targets.reserve(capacity);
+        elapsedMs.reserve(capacity);
+        durationMs.reserve(capacity);
+        differenceX.reserve(capacity);
+        differenceY.reserve(capacity);
+        appliedX.reserve(capacity);
+        appliedY.reserve(capacity);
+        centerX.reserve(capacity);
+        centerY.reserve(capacity);
+        targetScale.reserve(capacity);
+        appliedScale.reserve(capacity);
+        moveFunctions.reserve(capacity);
+        scaleFunctions.reserve(capacity);
+    }
+
+    inline uint32_t size() const {
+        return static_cast<uint32_t>(operations.size());
+    }
+
+    inline bool contains(OperationIndex index) const {
+        return index < trackOf.size() && trackOf[index] != INVALID_TRACK;
+    }
+
+    // Returns the new track, or INVALID_TRACK if capacity has been reached. Anything already applied starts at zero
+    uint32_t add(OperationIndex index, Entity16 target, float duration, float diffX, float diffY, float centreX, float centreY, float scale, uint8_t moveFunction, uint8_t scaleFunction)
+    {
+        assert(index < trackOf.size() && "AnimationTracks::reserve must be called first");
+        assert(! contains(index));
+
+        if(size() == capacity) {
+            return INVALID_TRACK;
+        }
+
+        const uint32_t track = size();
+
+        operations.push_back(index);
+        targets.push_back(target);
+        elapsedMs.push_back(0.0f);
+        durationMs.push_back(duration);
+        differenceX.push_back(diffX);
+        differenceY.push_back(diffY);
+        appliedX.push_back(0.0f);
+        appliedY.push_back(0.0f);
+        centerX.push_back(centreX);
+        centerY.push_back(centreY);
+        targetScale.push_back(scale);
+        appliedScale.push_back(1.0f);
+        moveFunctions.push_back(moveFunction);
+        scaleFunctions.push_back(scaleFunction);
+
+        trackOf[index] = track;
+        return track;
+    }
+
+    // Stops the track of an operation, leaving the target wherever it currently is
+    void remove(OperationIndex index)
+    {
+        assert(contains(index));
+
+        const uint32_t track = trackOf[index];
+        const OperationIndex moved = operations.back();
+
+        trackOf[moved] = track;
+        trackOf[index] = INVALID_TRACK;
+
+        swapRemove(operations, track);
+        swapRemove(targets, track);
+        swapRemove(elapsedMs, track);
+        swapRemove(durationMs, track);
+        swapRemove(differenceX, track);
+        swapRemove(differenceY, track);
+        swapRemove(appliedX, track);
+        swapRemove(appliedY, track);
+        swapRemove(centerX, track);
+        swapRemove(centerY, track);
+        swapRemove(targetScale, track);
+        swapRemove(appliedScale, track);
+        swapRemove(moveFunctions, track);
+        swapRemove(scaleFunctions, track);
+    }
+
+private:
+
+    template<typename T>
+    inline void swapRemove(std::vector<T>& values, size_t position)
+    {
+        values[position] = values.back();
+        values.pop_back();
+    }
+};
+
+#define KEY_BINDING_FLAGS_ON_PRESS      0b00000001
+#define KEY_BINDING_FLAGS_ON_REPEAT     0b00000010
+#define KEY_BINDING_FLAGS_ON_RELEASE    0b00000100
+#define KEY_BINDING_FLAGS_CHAIN         0b00001000  // operationIndex is an operation chain index
+
+// Operation run for a key. Modifiers must match exactly (Caps / Num lock are ignored)
+struct KeyPressOperation
+{
+    OperationIndex operationIndex = OPERATION_INDEX_INVALID;
+    uint8_t mods = 0;
+    uint8_t flags = 0;
+};
+
+// Key and scroll to operation lookup, used by processInput. Keys are indexed by GLFW key code
+struct InputBindings
+{
+    static const constexpr uint16_t NUM_KEYS = GLFW_KEY_LAST + 1;
+
+    KeyPressOperation keys[NUM_KEYS];
+
+    // Run once per whole scroll step. Only KEY_BINDING_FLAGS_CHAIN is used from flags
+    KeyPressOperation scrollUp;
+    KeyPressOperation scrollDown;
+    KeyPressOperation scrollLeft;
+    KeyPressOperation scrollRight;
+
+    // Fractional steps (E.g. from a touchpad) carried over to the next scroll
+    double scrollRemainderX = 0.0;
+    double scrollRemainderY = 0.0;
+
+    inline void bindKey(int key, OperationIndex operationIndex, uint8_t flags = KEY_BINDING_FLAGS_ON_PRESS, uint8_t mods = 0)
+    {
+        assert(key >= 0 && key < NUM_KEYS);
+        keys[key] = { operationIndex, mods, flags };
+    }
+};
+
 // TODO: Remove this at some point as not being used
 namespace operation
 {
@@ -503,9 +1023,21 @@ typedef struct Glyph
 static_assert(sizeof(glm::vec3) == sizeof(float) * 3);
 static_assert(sizeof(float) == 4);
 
+// Upper bounds for the pipeline setup temporaries, kept inline so creating or recreating a pipeline doesn't allocate
+static const constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 8;
+static const constexpr uint32_t MAX_DESCRIPTOR_BINDINGS = 4;
+
+typedef FixedVector<VkVertexInputAttributeDescription, MAX_VERTEX_ATTRIBUTES> VertexAttributeDescriptions;
+typedef FixedVector<VkDescriptorSetLayoutBinding, MAX_DESCRIPTOR_BINDINGS> DescriptorSetLayoutBindings;
+
+static_assert(MAX_VERTEX_ATTRIBUTES <= MAX_VARIANT_VERTEX_ATTRIBUTES);
+
+// transformIndex is always the last member, so it can be found from the stride alone (See attachTransform)
+
 struct BasicVertex {
     glm::vec2 pos;
     glm::vec3 color;
+    uint32_t transformIndex;    // Node in EntitySystemHandle::transforms
 
     static VkVertexInputBindingDescription getBindingDescription() {
         VkVertexInputBindingDescription bindingDescription = {};
@@ -516,10 +1048,10 @@ struct BasicVertex {
         return bindingDescription;
     }
 
-    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions = {};
+    static VertexAttributeDescriptions getAttributeDescriptions() {
+        VertexAttributeDescriptions attributeDescriptions;
 
-        attributeDescriptions.resize(2); // TODO: Needs to be manually changed with below code.
+        attributeDescriptions.resize(5); // TODO: Needs to be manually changed with below code.
 
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
@@ -531,6 +1063,23 @@ struct BasicVertex {
         attributeDescriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
         attributeDescriptions[1].offset = offsetof(BasicVertex, color);
 
+        attributeDescriptions[2].binding = 0;
+        attributeDescriptions[2].location = 3;
+        attributeDescriptions[2].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[2].offset = offsetof(BasicVertex, transformIndex);
+
+        // The UI vertex shader also takes Vertex's texCoord and textureIndex. Untextured variants never read them, so
+        // they're fed from members that do exist rather than widening BasicVertex
+        attributeDescriptions[3].binding = 0;
+        attributeDescriptions[3].location = 2;
+        attributeDescriptions[3].format = VK_FORMAT_R32G32_SFLOAT;
+        attributeDescriptions[3].offset = offsetof(BasicVertex, pos);
+
+        attributeDescriptions[4].binding = 0;
+        attributeDescriptions[4].location = 4;
+        attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[4].offset = offsetof(BasicVertex, transformIndex);
+
         return attributeDescriptions;
     }
 };
@@ -539,6 +1088,8 @@ struct Vertex {
     glm::vec2 pos;
     glm::vec3 color;
     glm::vec2 texCoord;
+    uint32_t textureIndex;      // Slot in VulkanApplication::textures. 0 is the font atlas
+    uint32_t transformIndex;
 
     static VkVertexInputBindingDescription getBindingDescription() {
         VkVertexInputBindingDescription bindingDescription = {};
@@ -549,10 +1100,10 @@ struct Vertex {
         return bindingDescription;
     }
 
-    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() {
-        std::vector<VkVertexInputAttributeDescription> attributeDescriptions = {};
+    static VertexAttributeDescriptions getAttributeDescriptions() {
+        VertexAttributeDescriptions attributeDescriptions;
 
-        attributeDescriptions.resize(3); // TODO: Needs to be manually changed with below code.
+        attributeDescriptions.resize(5); // TODO: Needs to be manually changed with below code.
 
         attributeDescriptions[0].binding = 0;
         attributeDescriptions[0].location = 0;
@@ -569,22 +1120,40 @@ struct Vertex {
         attributeDescriptions[2].format = VK_FORMAT_R32G32_SFLOAT;
         attributeDescriptions[2].offset = offsetof(Vertex, texCoord);
 
+        attributeDescriptions[3].binding = 0;
+        attributeDescriptions[3].location = 3;
+        attributeDescriptions[3].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[3].offset = offsetof(Vertex, transformIndex);
+
+        attributeDescriptions[4].binding = 0;
+        attributeDescriptions[4].location = 4;
+        attributeDescriptions[4].format = VK_FORMAT_R32_UINT;
+        attributeDescriptions[4].offset = offsetof(Vertex, textureIndex);
+
         return attributeDescriptions;
     }
-}; 
+};
+
+static_assert(offsetof(BasicVertex, transformIndex) == sizeof(BasicVertex) - sizeof(uint32_t));
+static_assert(offsetof(Vertex, transformIndex) == sizeof(Vertex) - sizeof(uint32_t));
 
 struct GenericGraphicsPipelineSetup
 {
     std::string vertexShaderPath;
     std::string fragmentShaderPath;
+    uint32_t features = 0;                      // ShaderFeature bits the shaders are specialised with
     VkDevice device;
+    PipelineVariants * variants = nullptr;      // Where the shaders and pipeline are cached
     VkFormat swapChainImageFormat;
     VkVertexInputBindingDescription vertexBindingDescription;
-    std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions;
+    VertexAttributeDescriptions vertexAttributeDescriptions;
     VkExtent2D swapChainExtent;
-    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings; // ?
+    DescriptorSetLayoutBindings descriptorSetLayoutBindings; // ?
+    VkDescriptorSetLayout textureSetLayout = VK_NULL_HANDLE;  // Bound as set 1 when set (See TextureTable)
+    bool texturesAreBindless = false;                         // TextureTable::isBindless of the table at set 1
     uint8_t swapChainSize;
     std::vector<VkImageView> swapChainImageViews;
+    VkImageLayout finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 };
 
 struct GenericGraphicsPipelineTargets
@@ -602,34 +1171,13 @@ struct PipelineSetupData {
     VkAttachmentReference attachmentReference;
     VkSubpassDependency subpassDependency;
 
-    VkPipelineShaderStageCreateInfo shaderStages[2];
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo;
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly;
-    VkPipelineViewportStateCreateInfo viewportState;
-    VkPipelineRasterizationStateCreateInfo rasterizer;
-    VkPipelineMultisampleStateCreateInfo multisampling;
-    VkPipelineColorBlendAttachmentState colorBlendAttachment;
-    VkPipelineColorBlendStateCreateInfo colorBlending;
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo;
-    std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+    VkDescriptorSetLayout textureSetLayout;
 
-    VkVertexInputBindingDescription vertexBindingDescription;
-    std::vector<VkVertexInputAttributeDescription> vertexAttributeDescriptions;
+    // Looked up again when the swapchain is recreated, which finds the pipeline already built
+    PipelineVariantKey variant;
 };
 
-enum class UIType { NOT = 0, SHAPE, BUTTON, TEXT, SIZE };
-
-enum class GraphicsUpdateDependency { STATIC, ALL, SIZE };
-
-struct UITypeMeshBinding
-{
-    UIType type;
-    GraphicsUpdateDependency updateDependency;
-    uint32_t indexStartIndex;
-    uint32_t vertexStartIndex;
-    uint16_t vertexLength;
-    uint16_t indexLength;
-};
+enum class UIType { NOT = 0, SHAPE, BUTTON, TEXT, IMAGE, SIZE };
 
 enum class MemoryUsageType { VERTEX_BUFFER = 0, INDICES_BUFFER, SIZE };
 
@@ -690,7 +1238,6 @@ struct VulkanApplicationPipeline
     }
 
     VkDeviceMemory pipelineMemory;
-    UITypeMeshBinding uiComponentsMap[100];
 
     // Refactor End
 
@@ -715,13 +1262,21 @@ struct RelatedVertices
     uint8_t stride;
 };
 
+// Counters used to report per-frame work (See bench/bench.cpp)
+struct FrameStatistics
+{
+    uint64_t bytesUploaded = 0;             // Bytes rewritten in mapped vertex memory after the initial mesh upload
+    uint32_t drawsPerFrame = 0;             // Draw calls recorded into each command buffer
+    uint32_t commandBufferRecordings = 0;
+};
+
 struct VulkanApplication
 {
-    GLFWwindow* window;
+    GLFWwindow* window = nullptr;
 
     VkInstance instance;
     VkDebugUtilsMessengerEXT debugMessenger;
-    VkSurfaceKHR surface;
+    VkSurfaceKHR surface = VK_NULL_HANDLE;
 
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkDevice device;
@@ -734,10 +1289,40 @@ struct VulkanApplication
     VkFormat swapChainImageFormat;
     VkExtent2D swapChainExtent;
 
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::vector<VkImage> swapChainImages;
     std::vector<VkImageView> swapChainImageViews;
     std::vector<VkFramebuffer> swapChainFramebuffers;
+    VkImageLayout swapChainImageFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // In headless mode swapChainImages are offscreen images owned by the application (See headless.h)
+    bool isHeadless = false;
+    std::vector<VkDeviceMemory> offscreenImageMemory;
+    uint32_t nextOffscreenImage = 0;
+    uint32_t lastRenderedImage = 0;
+
+    FrameStatistics frameStats;
+
+    // Scratch memory for the current frame, reset at the start of loopLogic
+    FrameArena frameArena;
+
+    // Set when the device supports VK_EXT_descriptor_indexing, and vconfig::ENABLE_DESCRIPTOR_INDEXING allows it
+    bool descriptorIndexingEnabled = false;
+
+    // Set when the device supports VK_EXT_memory_budget, which images use to keep within what the driver allows
+    bool memoryBudgetEnabled = false;
+
+    // Shader modules and every pipeline built from them. Outlives swapchain recreation
+    PipelineVariants pipelineVariants;
+
+    // Every texture the texture pipeline can sample. Outlives swapchain recreation
+    TextureTable textures;
+
+    // Images for image widgets, decoded and uploaded in the background (See processImageAssets)
+    ImageAssets images;
+
+    // Filled by the GLFW callbacks, drained once per frame by processInput
+    Input input;
 
     VkCommandPool commandPool;
     std::vector<VkCommandBuffer> commandBuffers;
@@ -757,83 +1342,72 @@ struct VulkanApplication
     VkDeviceMemory indicesMemory;
     uint8_t * mappedIndicesMemory;
 
+    // World transforms read by the vertex shaders, written by TransformHierarchy::flush
+    VkBuffer transformsBuffer = VK_NULL_HANDLE;
+    VkDeviceMemory transformsMemory = VK_NULL_HANDLE;
+    GpuTransform * mappedTransforms = nullptr;
+
     /* Entity Stuff */
 
     EntitySystemHandle entitySystem;
     static const constexpr uint16_t NUM_EVENTS = 40;
-    static const constexpr uint16_t NUM_OPERATIONS = 40;
 
     // TODO: Array lengths are hardcoded
 
-    uint16_t numPerFrameOperations;
-    uint16_t perFrameOperationIndices[10];
+    PerFrameOperations perFrameOperations;
+    AnimationTracks animations;
+
+    OperationChainProgram operationChains;
+
+    // Root fills the screen. Entities are placed by it through bindLayout
+    LayoutTree layout;
 
     OnMouseEventOpBindings onMouseEventOpBindings;
 
     uint16_t activeBoundsIndices[10];
     uint16_t numActiveBounds = 0;
 
-    // TODO: Clean up below
-    uint8_t numOp16 = 0;
-    uint8_t numOp8 = 0;
-    uint8_t numOp4 = 0;
-    uint8_t numOp2 = 0;
-
-    Operation2 operations[NUM_OPERATIONS];
-
-    Operation2& opAt(uint16_t index)
-    {
-        if(index < numOp16) {
-            return *reinterpret_cast<Operation2*>((reinterpret_cast<Operation16*>(operations) + index));
-        }
-
-        uint8_t op2SizeCounter = numOp16 * 8;
-        index -= numOp16;
+    // Every bounds under the cursor as of the last cursor move, whether or not it has hover operations.
+    // Clicks are dispatched from this instead of hit testing again
+    uint16_t hoveredBoundsIndices[10];
+    uint16_t numHoveredBounds = 0;
 
-        if(index < numOp8) {
-            return *(reinterpret_cast<Operation2*>(reinterpret_cast<Operation8*>(operations) + index) + op2SizeCounter);
-        }
+    InputBindings inputBindings;
 
-        op2SizeCounter += numOp8 * 4;
-        index -= numOp8;
+    OperationStore operations;
 
-        if(index < numOp4) {
-            return *(reinterpret_cast<Operation2*>(reinterpret_cast<Operation4*>(operations) + index) + op2SizeCounter);
-        }
-
-        op2SizeCounter += numOp4 * 2;
-        index -= numOp4;
-
-        assert(index < numOp2 && "index for opAt is too big");
+    inline Operation2& opAt(OperationIndex index) {
+        return operations.at(index);
+    }
 
-        return *(reinterpret_cast<Operation2*>(reinterpret_cast<Operation2*>(operations) + index) + op2SizeCounter);
+    OperationIndex insertOp16(uint8_t opCode, uint8_t flags, Operation16Union op16Data) {
+        return operations.insert(opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_16), &op16Data);
     }
 
-    void insertOp16(uint8_t opCode, uint8_t flags, Operation16Union op16Data)
-    {
-        assert(numOp2 == 0 && numOp4 == 0 && numOp8 == 0 && "You cannot insert an op16 after inserting a smaller sized operation");
-        *reinterpret_cast<Operation16 *>(operations + numOp16 * 8) = { opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_16), op16Data };
-        numOp16++;
+    OperationIndex insertOp8(uint8_t opCode, uint8_t flags, Operation8Union op8Data) {
+        return operations.insert(opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_8), &op8Data);
     }
 
-    void insertOp8(uint8_t opCode, uint8_t flags, Operation8Union op8Data)
-    {
-        assert(numOp2 == 0 && numOp4 == 0 && "You cannot insert an op8 after inserting a smaller sized operation");
-        *reinterpret_cast<Operation8 *>(operations + (numOp8 * 4) + (numOp16 * 8)) = { opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_8), op8Data };
-        numOp8++;
+    OperationIndex insertOp4(uint8_t opCode, uint8_t flags, Operation4Union op4Data) {
+        return operations.insert(opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_4), &op4Data);
     }
 
-    void insertOp4(uint8_t opCode, uint8_t flags, Operation4Union op4Data)
-    {
-        assert(numOp2 == 0 && "You cannot insert an op4 after inserting a smaller sized operation");
-        *reinterpret_cast<Operation4 *>(operations + (numOp4 * 2) + (numOp8 * 4) + (numOp16 * 8)) = { opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_4), op4Data };
-        numOp4++;
+    OperationIndex insertOp2(uint8_t opCode, uint8_t flags) {
+        return operations.insert(opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_2), nullptr);
     }
 
-    void insertOp2(uint8_t opCode, uint8_t flags)
+    // Also stops the operation if it's running every frame or animating. The index may be reused by a later insert
+    void removeOp(OperationIndex index)
     {
-        *reinterpret_cast<Operation2 *>(operations + numOp2 + (numOp4 * 2) + (numOp8 * 4) + (numOp16 * 8)) = { opCode, static_cast<uint8_t>(flags | OPERATION_FLAGS_SIZE_2) };
-        numOp2++;
+        if(perFrameOperations.contains(index)) {
+            perFrameOperations.remove(index);
+        }
+
+        if(animations.contains(index)) {
+            animations.remove(index);
+        }
+
+        operations.remove(index);
     }
 
     /* Entity Stuff end */
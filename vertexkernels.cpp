@@ -0,0 +1,480 @@
+#include "vertexkernels.h"
+
+#include <cassert>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VERTEX_KERNELS_SSE2
+#include <emmintrin.h>
+
+// AVX2 kernels are compiled with a target attribute so the rest of the build doesn't need -mavx2.
+// Only enabled where the CPU can be queried at runtime
+#if defined(__GNUC__) || defined(__clang__)
+#define VERTEX_KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VERTEX_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+// Two floats, no padding
+static const uint32_t PACKED_STRIDE = 8;
+
+static inline float * advance(float * position, uint32_t strideBytes) {
+    return reinterpret_cast<float *>(reinterpret_cast<uint8_t *>(position) + strideBytes);
+}
+
+// BEGIN Scalar
+
+void translateVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY)
+{
+    while(numVertices-- != 0)
+    {
+        positions[0] += addX;
+        positions[1] += addY;
+
+        positions = advance(positions, strideBytes);
+    }
+}
+
+void scaleVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY)
+{
+    while(numVertices-- != 0)
+    {
+        positions[0] *= multX;
+        positions[1] *= multY;
+
+        positions = advance(positions, strideBytes);
+    }
+}
+
+void transformVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform)
+{
+    while(numVertices-- != 0)
+    {
+        const float x = positions[0];
+        const float y = positions[1];
+
+        positions[0] = transform.a * x + transform.c * y + transform.tx;
+        positions[1] = transform.b * x + transform.d * y + transform.ty;
+
+        positions = advance(positions, strideBytes);
+    }
+}
+
+// END Scalar
+
+// BEGIN SSE2
+#ifdef VERTEX_KERNELS_SSE2
+
+// Each op works on two vertices at once, laid out as x0 y0 x1 y1
+
+struct TranslateSSE2
+{
+    __m128 offset;
+
+    inline __m128 operator()(__m128 positions) const {
+        return _mm_add_ps(positions, offset);
+    }
+};
+
+struct ScaleSSE2
+{
+    __m128 scale;
+
+    inline __m128 operator()(__m128 positions) const {
+        return _mm_mul_ps(positions, scale);
+    }
+};
+
+struct AffineSSE2
+{
+    __m128 diagonal;    // a d a d
+    __m128 cross;       // c b c b
+    __m128 offset;
+
+    inline __m128 operator()(__m128 positions) const
+    {
+        const __m128 swapped = _mm_shuffle_ps(positions, positions, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(positions, diagonal), _mm_mul_ps(swapped, cross)), offset);
+    }
+};
+
+template <typename Op>
+static void runSSE2(float * positions, uint32_t numVertices, uint32_t strideBytes, const Op& op)
+{
+    if(strideBytes == PACKED_STRIDE)
+    {
+        for(; numVertices >= 4; numVertices -= 4, positions += 8)
+        {
+            const __m128 first = _mm_loadu_ps(positions);
+            const __m128 second = _mm_loadu_ps(positions + 4);
+
+            _mm_storeu_ps(positions, op(first));
+            _mm_storeu_ps(positions + 4, op(second));
+        }
+    }
+
+    // Strided streams gather two positions into one register, 8 bytes from each vertex
+    for(; numVertices >= 2; numVertices -= 2)
+    {
+        float * next = advance(positions, strideBytes);
+
+        __m128 pair = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(positions));
+        pair = _mm_loadh_pi(pair, reinterpret_cast<const __m64 *>(next));
+        pair = op(pair);
+
+        _mm_storel_pi(reinterpret_cast<__m64 *>(positions), pair);
+        _mm_storeh_pi(reinterpret_cast<__m64 *>(next), pair);
+
+        positions = advance(next, strideBytes);
+    }
+
+    if(numVertices == 1)
+    {
+        const __m128 single = _mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64 *>(positions));
+        _mm_storel_pi(reinterpret_cast<__m64 *>(positions), op(single));
+    }
+}
+
+static void translateSSE2(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY) {
+    runSSE2(positions, numVertices, strideBytes, TranslateSSE2 { _mm_setr_ps(addX, addY, addX, addY) });
+}
+
+static void scaleSSE2(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY) {
+    runSSE2(positions, numVertices, strideBytes, ScaleSSE2 { _mm_setr_ps(multX, multY, multX, multY) });
+}
+
+static void transformSSE2(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform)
+{
+    const AffineSSE2 op = { _mm_setr_ps(transform.a, transform.d, transform.a, transform.d),
+                            _mm_setr_ps(transform.c, transform.b, transform.c, transform.b),
+                            _mm_setr_ps(transform.tx, transform.ty, transform.tx, transform.ty) };
+
+    runSSE2(positions, numVertices, strideBytes, op);
+}
+
+#endif
+// END SSE2
+
+// BEGIN AVX2
+#ifdef VERTEX_KERNELS_AVX2
+
+// Four vertices at once. AVX2 has gathers but no scatters, so only packed streams benefit; strided streams
+// and the last few vertices are left to the SSE2 kernels
+
+struct TranslateAVX2
+{
+    __m256 offset;
+
+    AVX2_TARGET inline __m256 operator()(__m256 positions) const {
+        return _mm256_add_ps(positions, offset);
+    }
+};
+
+struct ScaleAVX2
+{
+    __m256 scale;
+
+    AVX2_TARGET inline __m256 operator()(__m256 positions) const {
+        return _mm256_mul_ps(positions, scale);
+    }
+};
+
+struct AffineAVX2
+{
+    __m256 diagonal;
+    __m256 cross;
+    __m256 offset;
+
+    AVX2_TARGET inline __m256 operator()(__m256 positions) const
+    {
+        const __m256 swapped = _mm256_permute_ps(positions, _MM_SHUFFLE(2, 3, 0, 1));
+        return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(positions, diagonal), _mm256_mul_ps(swapped, cross)), offset);
+    }
+};
+
+// Returns the number of vertices updated
+template <typename Op>
+AVX2_TARGET static uint32_t runPackedAVX2(float * positions, uint32_t numVertices, const Op& op)
+{
+    uint32_t i = 0;
+
+    for(; i + 8 <= numVertices; i += 8)
+    {
+        const __m256 first = _mm256_loadu_ps(positions + i * 2);
+        const __m256 second = _mm256_loadu_ps(positions + i * 2 + 8);
+
+        _mm256_storeu_ps(positions + i * 2, op(first));
+        _mm256_storeu_ps(positions + i * 2 + 8, op(second));
+    }
+
+    return i;
+}
+
+AVX2_TARGET static void translateAVX2(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY)
+{
+    if(strideBytes == PACKED_STRIDE)
+    {
+        const TranslateAVX2 op = { _mm256_setr_ps(addX, addY, addX, addY, addX, addY, addX, addY) };
+        const uint32_t numUpdated = runPackedAVX2(positions, numVertices, op);
+
+        positions += numUpdated * 2;
+        numVertices -= numUpdated;
+    }
+
+    translateSSE2(positions, numVertices, strideBytes, addX, addY);
+}
+
+AVX2_TARGET static void scaleAVX2(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY)
+{
+    if(strideBytes == PACKED_STRIDE)
+    {
+        const ScaleAVX2 op = { _mm256_setr_ps(multX, multY, multX, multY, multX, multY, multX, multY) };
+        const uint32_t numUpdated = runPackedAVX2(positions, numVertices, op);
+
+        positions += numUpdated * 2;
+        numVertices -= numUpdated;
+    }
+
+    scaleSSE2(positions, numVertices, strideBytes, multX, multY);
+}
+
+AVX2_TARGET static void transformAVX2(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform)
+{
+    if(strideBytes == PACKED_STRIDE)
+    {
+        const Affine2D& t = transform;
+        const AffineAVX2 op = { _mm256_setr_ps(t.a, t.d, t.a, t.d, t.a, t.d, t.a, t.d),
+                                _mm256_setr_ps(t.c, t.b, t.c, t.b, t.c, t.b, t.c, t.b),
+                                _mm256_setr_ps(t.tx, t.ty, t.tx, t.ty, t.tx, t.ty, t.tx, t.ty) };
+
+        const uint32_t numUpdated = runPackedAVX2(positions, numVertices, op);
+
+        positions += numUpdated * 2;
+        numVertices -= numUpdated;
+    }
+
+    transformSSE2(positions, numVertices, strideBytes, transform);
+}
+
+#endif
+// END AVX2
+
+// BEGIN NEON
+#ifdef VERTEX_KERNELS_NEON
+
+struct TranslateNEON
+{
+    float32x4_t offset;
+
+    inline float32x4_t operator()(float32x4_t positions) const {
+        return vaddq_f32(positions, offset);
+    }
+};
+
+struct ScaleNEON
+{
+    float32x4_t scale;
+
+    inline float32x4_t operator()(float32x4_t positions) const {
+        return vmulq_f32(positions, scale);
+    }
+};
+
+struct AffineNEON
+{
+    float32x4_t diagonal;
+    float32x4_t cross;
+    float32x4_t offset;
+
+    inline float32x4_t operator()(float32x4_t positions) const
+    {
+        const float32x4_t swapped = vrev64q_f32(positions);
+        return vaddq_f32(vaddq_f32(vmulq_f32(positions, diagonal), vmulq_f32(swapped, cross)), offset);
+    }
+};
+
+static inline float32x4_t repeatPair(float first, float second)
+{
+    const float values[4] = { first, second, first, second };
+    return vld1q_f32(values);
+}
+
+template <typename Op>
+static void runNEON(float * positions, uint32_t numVertices, uint32_t strideBytes, const Op& op)
+{
+    if(strideBytes == PACKED_STRIDE)
+    {
+        for(; numVertices >= 4; numVertices -= 4, positions += 8)
+        {
+            vst1q_f32(positions, op(vld1q_f32(positions)));
+            vst1q_f32(positions + 4, op(vld1q_f32(positions + 4)));
+        }
+    }
+
+    for(; numVertices >= 2; numVertices -= 2)
+    {
+        float * next = advance(positions, strideBytes);
+
+        const float32x4_t pair = op(vcombine_f32(vld1_f32(positions), vld1_f32(next)));
+
+        vst1_f32(positions, vget_low_f32(pair));
+        vst1_f32(next, vget_high_f32(pair));
+
+        positions = advance(next, strideBytes);
+    }
+
+    if(numVertices == 1)
+    {
+        const float32x2_t single = vld1_f32(positions);
+        vst1_f32(positions, vget_low_f32(op(vcombine_f32(single, single))));
+    }
+}
+
+static void translateNEON(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY) {
+    runNEON(positions, numVertices, strideBytes, TranslateNEON { repeatPair(addX, addY) });
+}
+
+static void scaleNEON(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY) {
+    runNEON(positions, numVertices, strideBytes, ScaleNEON { repeatPair(multX, multY) });
+}
+
+static void transformNEON(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform)
+{
+    const AffineNEON op = { repeatPair(transform.a, transform.d),
+                            repeatPair(transform.c, transform.b),
+                            repeatPair(transform.tx, transform.ty) };
+
+    runNEON(positions, numVertices, strideBytes, op);
+}
+
+#endif
+// END NEON
+
+// BEGIN Dispatch
+
+struct VertexKernels
+{
+    void (*translate)(float *, uint32_t, uint32_t, float, float);
+    void (*scale)(float *, uint32_t, uint32_t, float, float);
+    void (*transform)(float *, uint32_t, uint32_t, const Affine2D&);
+};
+
+// Indexed by VertexKernelTarget. Targets not compiled in are left empty
+static const VertexKernels kernelTable[static_cast<size_t>(VertexKernelTarget::SIZE)] = {
+    { translateVerticesReference, scaleVerticesReference, transformVerticesReference },
+#ifdef VERTEX_KERNELS_SSE2
+    { translateSSE2, scaleSSE2, transformSSE2 },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+#ifdef VERTEX_KERNELS_AVX2
+    { translateAVX2, scaleAVX2, transformAVX2 },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+#ifdef VERTEX_KERNELS_NEON
+    { translateNEON, scaleNEON, transformNEON },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+};
+
+static const VertexKernels * activeKernels = nullptr;
+static VertexKernelTarget activeTarget = VertexKernelTarget::SCALAR;
+
+static inline const VertexKernels& kernels()
+{
+    if(activeKernels == nullptr) {
+        setVertexKernelTarget(bestVertexKernelTarget());
+    }
+
+    return *activeKernels;
+}
+
+bool isVertexKernelTargetSupported(VertexKernelTarget target)
+{
+    assert(target < VertexKernelTarget::SIZE);
+
+    if(kernelTable[static_cast<size_t>(target)].translate == nullptr) {
+        return false;
+    }
+
+#ifdef VERTEX_KERNELS_AVX2
+    if(target == VertexKernelTarget::AVX2)
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+    }
+#endif
+
+    return true;
+}
+
+VertexKernelTarget bestVertexKernelTarget()
+{
+    const VertexKernelTarget preferred[] = { VertexKernelTarget::AVX2, VertexKernelTarget::NEON, VertexKernelTarget::SSE2 };
+
+    for(VertexKernelTarget target : preferred)
+    {
+        if(isVertexKernelTargetSupported(target)) {
+            return target;
+        }
+    }
+
+    return VertexKernelTarget::SCALAR;
+}
+
+VertexKernelTarget vertexKernelTarget()
+{
+    kernels();
+    return activeTarget;
+}
+
+bool setVertexKernelTarget(VertexKernelTarget target)
+{
+    if(! isVertexKernelTargetSupported(target)) {
+        return false;
+    }
+
+    activeTarget = target;
+    activeKernels = &kernelTable[static_cast<size_t>(target)];
+
+    return true;
+}
+
+const char * vertexKernelTargetName(VertexKernelTarget target)
+{
+    switch(target)
+    {
+        case VertexKernelTarget::SCALAR: return "scalar";
+        case VertexKernelTarget::SSE2: return "sse2";
+        case VertexKernelTarget::AVX2: return "avx2";
+        case VertexKernelTarget::NEON: return "neon";
+        default: return "unknown";
+    }
+}
+
+// END Dispatch
+
+void translateVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY)
+{
+    assert(strideBytes >= PACKED_STRIDE && strideBytes % sizeof(float) == 0);
+    kernels().translate(positions, numVertices, strideBytes, addX, addY);
+}
+
+void scaleVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY)
+{
+    assert(strideBytes >= PACKED_STRIDE && strideBytes % sizeof(float) == 0);
+    kernels().scale(positions, numVertices, strideBytes, multX, multY);
+}
+
+void transformVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform)
+{
+    assert(strideBytes >= PACKED_STRIDE && strideBytes % sizeof(float) == 0);
+    kernels().transform(positions, numVertices, strideBytes, transform);
+}
@@ -0,0 +1,42 @@
+#ifndef VERTEXKERNELS_H
+#define VERTEXKERNELS_H
+
+#include <stdint.h>
+
+// Kernels that update the position of each vertex in a stream. Positions are the first two floats of every vertex,
+// vertices are strideBytes apart (A stride of 8 is a packed stream of positions). Strides must be a multiple of 4.
+// The kernel used is picked for the CPU the first time one is called, see setVertexKernelTarget to override it
+
+// x' = a * x + c * y + tx
+// y' = b * x + d * y + ty
+struct Affine2D
+{
+    float a;
+    float b;
+    float c;
+    float d;
+    float tx;
+    float ty;
+};
+
+enum class VertexKernelTarget : uint8_t { SCALAR = 0, SSE2, AVX2, NEON, SIZE };
+
+void translateVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY);
+void scaleVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY);
+void transformVertices(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform);
+
+// Plain loops, kept as the reference the SIMD kernels are checked against
+void translateVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, float addX, float addY);
+void scaleVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, float multX, float multY);
+void transformVerticesReference(float * positions, uint32_t numVertices, uint32_t strideBytes, const Affine2D& transform);
+
+bool isVertexKernelTargetSupported(VertexKernelTarget target);
+VertexKernelTarget bestVertexKernelTarget();
+VertexKernelTarget vertexKernelTarget();
+
+// Returns false and keeps the current kernels if the target isn't supported by this CPU or build
+bool setVertexKernelTarget(VertexKernelTarget target);
+
+const char * vertexKernelTargetName(VertexKernelTarget target);
+
+#endif // VERTEXKERNELS_H
@@ -98,6 +98,7 @@ void copyBuffer(    VkDevice device,
                     VkBuffer dstBuffer,
                     VkDeviceSize size)
 {
+    TRACE_FUNCTION();
 
     VkCommandBufferAllocateInfo allocInfo = {};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -163,6 +164,8 @@ void flushMemoryToDeviceLocal(const VkDevice device,
                               VkDeviceSize bufferSize,
                               VkBufferUsageFlags usage )
 {
+    TRACE_FUNCTION();
+
     createBuffer(   device,
                     physicalDevice,
                     bufferSize,
@@ -202,6 +205,7 @@ void createBuffer(  VkDevice device,
                     VkBuffer& buffer,
                     VkDeviceMemory& bufferMemory)
 {
+    TRACE_FUNCTION();
 
     VkBufferCreateInfo bufferInfo = {};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -266,7 +270,8 @@ void createImage(   VkDevice device,
                     VkImageUsageFlags usage,
                     VkMemoryPropertyFlags properties,
                     VkImage& image,
-                    VkDeviceMemory& imageMemory)
+                    VkDeviceMemory& imageMemory,
+                    uint32_t mipLevels)
 {
 
     VkImageCreateInfo imageInfo = {};
@@ -275,7 +280,7 @@ void createImage(   VkDevice device,
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -351,6 +356,7 @@ void transitionImageLayout( VkDevice device,
                             VkImageLayout oldLayout,
                             VkImageLayout newLayout)
 {
+    TRACE_FUNCTION();
 
     VkCommandBuffer commandBuffer = beginSingleTimeCommands(device, commandPool);
 
@@ -410,6 +416,7 @@ void createTextureImage(    VkDevice device,
                             VkImage& outTextureImage,
                             VkDeviceMemory& outTextureImageMemory)
 {
+    TRACE_FUNCTION();
 
     VkDeviceSize imageSize = texture_width * texture_height * 4;
 
@@ -493,7 +500,7 @@ void createTextureImage(    VkDevice device,
 
 }
 
-void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView& outTextureImageView)
+void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView& outTextureImageView, uint32_t mipLevels)
 {
 
     VkImageViewCreateInfo viewInfo = {};
@@ -503,7 +510,7 @@ void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageVie
     viewInfo.format = format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
 
@@ -11,6 +11,8 @@
 #include <cstdlib>
 #include <vector>
 
+#include "trace.h"
+
 VkShaderModule createShaderModule(VkDevice device, const std::vector<char>& code);
 std::vector<char> readFile(const std::string& filename);
 
@@ -61,7 +63,8 @@ void createImage(   VkDevice device,
                     VkImageUsageFlags usage,
                     VkMemoryPropertyFlags properties,
                     VkImage& image,
-                    VkDeviceMemory& imageMemory);
+                    VkDeviceMemory& imageMemory,
+                    uint32_t mipLevels = 1);
 
 void allocateMemory( VkDevice device,
                      VkDeviceSize size,
@@ -97,6 +100,6 @@ void endSingleTimeCommands( VkDevice device,
                             VkQueue graphicsQueue,
                             VkCommandBuffer commandBuffer);
 
-void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView& outTextureImageView);
+void createImageView(VkDevice device, VkImage image, VkFormat format, VkImageView& outTextureImageView, uint32_t mipLevels = 1);
 
 #endif